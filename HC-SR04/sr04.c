@@ -1,4 +1,5 @@
 #include<linux/init.h>
+#include<linux/delay.h>
 #include<linux/workqueue.h>
 #include<linux/module.h>
 #include<linux/wait.h>
@@ -8,30 +9,95 @@
 #include<linux/interrupt.h>
 #include<linux/time.h>
 #include<linux/gpio.h>
+#include<linux/fs.h>
+#include<linux/kfifo.h>
+#include<linux/poll.h>
+#include<linux/spinlock.h>
+#include<linux/uaccess.h>
+#include "../common/ultrasonic/ultra_demod.h"
 #define ECHO 536 // gpio-536 (GPIO-24) in /sys/kernel/debug/info 
 #define ECHO_LABEL "GPIO_24"
 #define TRIG 535 // GPIO 23 // gpio-535 (GPIO-23) in /sys/kernel/debug/info 
 #define TRIG_LABEL "GPIO_23"
-static wait_queue_head_t waitqueue; //waitqueue for wait and wakeup
+#define TRIG_PULSE_US 10 // starts a measurement; a longer one is a pulse on the social channel
+#define COMM_FIFO_SIZE 32 // decoded packets, power of two for kfifo
+static DECLARE_WAIT_QUEUE_HEAD(waitqueue); //waitqueue for wait and wakeup
+static DECLARE_WAIT_QUEUE_HEAD(comm_waitqueue); //readers of the social channel
 
 dev_t dev = 0; // device driver's major/minor number
+dev_t comm_dev = 0; // minor 1: decoded ultrasonic packets
 
 int IRQ_NO; //variabe for storing echo pin irq
 _Bool echo_status; //for checking ECHO pin status, needed for identifying RISING/FALLING
 uint64_t sr04_send_ts, sr04_recv_ts, duration;
+uint64_t trig_rise_ts; //last time we drove TRIG high, for ranging or transmitting
+
+/* start of ultrasonic packet demodulator */
+/*
+ * Runs in the echo IRQ. Each echo pulse is handed to the shared
+ * demodulator (ultra_demod.h), which decodes v2 frames and v1 packets.
+ * Completed packets go to comm_fifo for /dev/sr04_comm readers.
+ */
+static DEFINE_KFIFO(comm_fifo, struct ultra_rx_packet, COMM_FIFO_SIZE);
+static DEFINE_SPINLOCK(comm_fifo_lock);
+
+static struct ultra_demod comm_demod;
+static uint64_t comm_rise_ts; //rising edge of the pulse being measured
+static _Bool comm_rise_valid; //rising edge was not our own echo
+static uint64_t comm_dropped; //oldest packets overwritten while nobody read
+static DEFINE_SPINLOCK(comm_trig_lock); //the stamps below and trig_rise_ts, 64-bit on a 32-bit Pi
+static uint64_t comm_rx_busy_until; //ranging holds off until then, a frame is being received
+static uint64_t comm_tx_busy_until; //ranging holds off until then, a frame is being sent
+
+static void comm_rx_push(const struct ultra_rx_packet *packet) {
+	spin_lock(&comm_fifo_lock); //hardirq, interrupts are already off
+	if(kfifo_is_full(&comm_fifo)) { //keep the newest packets, like the worm's own queue
+		kfifo_skip(&comm_fifo);
+		comm_dropped++;
+	}
+	kfifo_put(&comm_fifo, *packet);
+	spin_unlock(&comm_fifo_lock);
+	wake_up_interruptible(&comm_waitqueue);
+}
+
+static void comm_echo_edge(_Bool level, uint64_t now) {
+	struct ultra_rx_packet packet;
+	int got;
+	if(level) {
+		comm_rise_ts = now;
+		spin_lock(&comm_trig_lock); //hardirq, interrupts are already off
+		comm_rise_valid = now - trig_rise_ts >= ULTRA_SELF_ECHO_RISE_NS; //our own echo rises right after TRIG
+		spin_unlock(&comm_trig_lock);
+		return;
+	}
+	if(comm_rise_valid) {
+		comm_rise_valid = 0;
+		got = ultra_demod_pulse(&comm_demod, comm_rise_ts, now, &packet);
+		spin_lock(&comm_trig_lock);
+		comm_rx_busy_until = ultra_demod_busy_until(&comm_demod);
+		spin_unlock(&comm_trig_lock);
+		if(got) {
+			comm_rx_push(&packet);
+		}
+	}
+}
+/* end of ultrasonic packet demodulator */
+
 /* start of IRQ Handler */
 
 static irqreturn_t echo_irq_triggered(int irq, void *dev_id) {
+	uint64_t now = ktime_get_ns(); //edge time, taken before anything else delays it
 	echo_status = (_Bool)gpio_get_value(ECHO);
 	if(echo_status == 1) {
-		sr04_send_ts = ktime_get_ns();
+		sr04_send_ts = now;
 		_printk("ECHO INTERRUPT\n");
 	} else {
+		sr04_recv_ts = now;
 		_printk("SUCCEED TO GET sr04_recv_ts%llu\n", sr04_recv_ts);
-		sr04_recv_ts = ktime_get_ns();
 		duration = sr04_recv_ts-sr04_send_ts;
 		wake_up_interruptible(&waitqueue); // interrupt wake up
 	}
+	comm_echo_edge(echo_status, now);
 		
 	return IRQ_HANDLED;
 }
@@ -40,6 +106,7 @@ static irqreturn_t echo_irq_triggered(int irq, void *dev_id) {
 /* -- start of function prototype */
 struct class *sr04_class;
 struct cdev sr04_cdev;
+struct cdev sr04_comm_cdev;
 
 static int __init sr04_driver_init(void);
 int sr04_driver_open(struct inode *inode, struct file *file) ;
@@ -47,6 +114,9 @@ int sr04_driver_release(struct inode *inode, struct file *file) ;
 static void __exit sr04_driver_exit(void);
 
 ssize_t sr04_read(struct file *file, char __user *buf, size_t len, loff_t * off);
+ssize_t sr04_comm_read(struct file *file, char __user *buf, size_t len, loff_t * off);
+ssize_t sr04_comm_write(struct file *file, const char __user *buf, size_t len, loff_t * off);
+__poll_t sr04_comm_poll(struct file *file, poll_table *wait);
 
 /* -- end of function prototype -- */
 
@@ -57,6 +127,15 @@ struct file_operations fops = {
 	.release = sr04_driver_release,
 };
 
+struct file_operations comm_fops = {
+	.owner	= THIS_MODULE,
+	.read	= sr04_comm_read,
+	.write	= sr04_comm_write,
+	.poll	= sr04_comm_poll,
+	.open	= sr04_driver_open,
+	.release = sr04_driver_release,
+};
+
 int sr04_driver_open(struct inode *inode, struct file *file) {
 	return 0;
 }
@@ -67,7 +146,7 @@ int sr04_driver_release(struct inode *inode, struct file *file) {
 static int __init sr04_driver_init(void) {
     int major = MAJOR(dev);
     int minor = MINOR(dev);
-	if(alloc_chrdev_region(&dev, minor, 1, "sr04")<0) { /* NOTE: DEV_T ALLOC */
+	if(alloc_chrdev_region(&dev, minor, 2, "sr04")<0) { /* NOTE: DEV_T ALLOC */
 		_printk("Cannot allocate chrdev region, \n find comment \"NOTE: DEV_T ALLOC \"\n, \
 			Quitting without driver ins...\n");
 		goto chrdev_error;
@@ -79,6 +158,13 @@ static int __init sr04_driver_init(void) {
 			 Quitting without driver ins...\n");\
 		goto cdev_error;
 	}
+	comm_dev = MKDEV(MAJOR(dev), MINOR(dev) + 1);
+	cdev_init(&sr04_comm_cdev,&comm_fops);
+	if((cdev_add(&sr04_comm_cdev,comm_dev,1)) < 0) { /* NOTE: ADDING COMM CDEV */
+		_printk("Cannot add comm cdev: find comment \"NOTE: ADDING COMM CDEV\"\n,\
+			 Quitting without driver ins...\n");
+		goto comm_cdev_error;
+	}
 	if(IS_ERR(sr04_class = class_create("sr04_class"))) { /*NOTE: CREATING DEV CLASS */
 		_printk("Cannot create class structure,\n \
 			  find comment \"NOTE: CREATING DEV CLASS\",\
@@ -90,6 +176,10 @@ static int __init sr04_driver_init(void) {
 		_printk("Cannot create the device,\n find comment \"NOTE: DEV CREATION\", \nQuitting without driver ins...\n");
 		goto device_creation_error;
 	}
+	if(IS_ERR(device_create(sr04_class, NULL, comm_dev, NULL, "sr04_comm"))) { /* NOTE: COMM DEV CREATION */
+		_printk("Cannot create the comm device,\n find comment \"NOTE: COMM DEV CREATION\", \nQuitting without driver ins...\n");
+		goto comm_device_creation_error;
+	}
 
 
 	//gpio availability check
@@ -120,43 +210,67 @@ static int __init sr04_driver_init(void) {
 
 	gpio_direction_output(TRIG,0);
 	gpio_direction_input(ECHO);
-	init_waitqueue_head(&waitqueue); // waitqueue init
 	_printk("SR04 Dev. Driver inserted.");
 	return 0;
 
 
 chrdev_error:
-	unregister_chrdev_region(dev,1);
+	unregister_chrdev_region(dev,2);
 	_printk("SR04 Dev. Driver failed");
 	return -1;
 cdev_error:
 	cdev_del(&sr04_cdev);
 	goto chrdev_error;
+comm_cdev_error:
+	cdev_del(&sr04_comm_cdev);
+	goto cdev_error;
 class_error:
 	class_destroy(sr04_class);
-	goto cdev_error;
+	goto comm_cdev_error;
 
 device_creation_error:
 	device_destroy(sr04_class,dev);
 	goto class_error;
+comm_device_creation_error:
+	device_destroy(sr04_class,comm_dev);
+	goto device_creation_error;
 }
 
 static void __exit sr04_driver_exit(void) {
 	free_irq(IRQ_NO, (void *) echo_irq_triggered);
 	gpio_free(ECHO);
 	gpio_free(TRIG);
+	_printk("SR04 social channel: %llu packets, %llu dropped, %llu frame errors, %llu crc errors, %llu noise pulses\n",
+		comm_demod.stats.packets, comm_dropped, comm_demod.stats.frame_errors,
+		comm_demod.stats.crc_errors, comm_demod.stats.noise);
+	device_destroy(sr04_class,comm_dev);
 	device_destroy(sr04_class,dev);
 	class_destroy(sr04_class);
+	cdev_del(&sr04_comm_cdev);
 	cdev_del(&sr04_cdev);
-	unregister_chrdev_region(dev,1);
+	unregister_chrdev_region(dev,2);
 	_printk( "SR04 Dev. Driver removed.\n" );
 }
 
 
 ssize_t sr04_read(struct file *file, char __user *buf, size_t len, loff_t * off) {
+	unsigned long flags;
+	uint64_t now = ktime_get_ns();
+	_Bool busy;
+
+	spin_lock_irqsave(&comm_trig_lock, flags);
+	busy = now < comm_rx_busy_until || now < comm_tx_busy_until;
+	if(!busy) {
+		trig_rise_ts = now; //our own echo, not a packet
+	}
+	spin_unlock_irqrestore(&comm_trig_lock, flags);
+	if(busy) { //a v2 frame is on air, see ultra_proto.h; the caller keeps its last distance
+		return -EBUSY;
+	}
 	gpio_set_value(TRIG,1);
-	wait_event_interruptible(waitqueue,echo_status == 0); //wait for interrupt pin
+	udelay(TRIG_PULSE_US); //held for the whole echo, other cars would hear it as a symbol or sync
 	gpio_set_value(TRIG,0);
+	wait_event_interruptible(waitqueue,echo_status == 0); //wait for interrupt pin
 	if(duration<=0) { //if duration is invalid
 		_printk("SR04 Distance measurement: failed to get ECHO.. : duration is %llu\n", duration);
 		return 0;
@@ -174,6 +288,71 @@ ssize_t sr04_read(struct file *file, char __user *buf, size_t len, loff_t * off)
 	return 0;
 }
 
+/* start of social channel (minor 1) */
+
+ssize_t sr04_comm_read(struct file *file, char __user *buf, size_t len, loff_t * off) {
+	struct ultra_rx_packet packets[8];
+	unsigned long flags;
+	unsigned int count;
+
+	if(len < sizeof(packets[0])) { //whole records only
+		return -EINVAL;
+	}
+	for(;;) {
+		spin_lock_irqsave(&comm_fifo_lock, flags);
+		count = kfifo_out(&comm_fifo, packets, min_t(size_t, len / sizeof(packets[0]), ARRAY_SIZE(packets)));
+		spin_unlock_irqrestore(&comm_fifo_lock, flags);
+		if(count > 0) {
+			break;
+		}
+		if(file->f_flags & O_NONBLOCK) {
+			return -EAGAIN;
+		}
+		if(wait_event_interruptible(comm_waitqueue, !kfifo_is_empty(&comm_fifo))) {
+			return -ERESTARTSYS;
+		}
+	}
+	if(copy_to_user(buf, packets, count * sizeof(packets[0]))) {
+		return -EFAULT;
+	}
+	return count * sizeof(packets[0]);
+}
+
+//'1' raises TRIG, '0' lowers it; the last byte of a write wins
+ssize_t sr04_comm_write(struct file *file, const char __user *buf, size_t len, loff_t * off) {
+	char level;
+
+	if(len == 0) {
+		return 0;
+	}
+	if(copy_from_user(&level, buf + len - 1, 1)) {
+		return -EFAULT;
+	}
+	if(level != '0' && level != '1') {
+		return -EINVAL;
+	}
+	if(level == '1') {
+		unsigned long flags;
+		uint64_t now = ktime_get_ns();
+		spin_lock_irqsave(&comm_trig_lock, flags);
+		trig_rise_ts = now;
+		comm_tx_busy_until = now + ULTRA2_GAP_TIMEOUT_NS; //the next edge of the frame renews it
+		spin_unlock_irqrestore(&comm_trig_lock, flags);
+	}
+	gpio_set_value(TRIG, level == '1');
+	return len;
+}
+
+__poll_t sr04_comm_poll(struct file *file, poll_table *wait) {
+	__poll_t mask = EPOLLOUT | EPOLLWRNORM; //writes never block
+	poll_wait(file, &comm_waitqueue, wait);
+	if(!kfifo_is_empty(&comm_fifo)) {
+		mask |= EPOLLIN | EPOLLRDNORM;
+	}
+	return mask;
+}
+
+/* end of social channel */
 
 module_init(sr04_driver_init);
 module_exit(sr04_driver_exit);
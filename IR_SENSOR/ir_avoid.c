@@ -0,0 +1,322 @@
+#include<linux/init.h>
+#include<linux/module.h>
+#include<linux/moduleparam.h>
+#include<linux/wait.h>
+#include<linux/cdev.h>
+#include<linux/device.h>
+#include<linux/err.h>
+#include<linux/interrupt.h>
+#include<linux/gpio.h>
+#include<linux/fs.h>
+#include<linux/kfifo.h>
+#include<linux/list.h>
+#include<linux/poll.h>
+#include<linux/slab.h>
+#include<linux/spinlock.h>
+#include<linux/string.h>
+#include<linux/uaccess.h>
+#include "../common/ir/ir_event.h"
+#define IR_LEFT_GPIO 524 // gpio-524 (GPIO-12) in /sys/kernel/debug/gpio
+#define IR_LEFT_LABEL "GPIO_12"
+#define IR_RIGHT_GPIO 529 // gpio-529 (GPIO-17) in /sys/kernel/debug/gpio
+#define IR_RIGHT_LABEL "GPIO_17"
+#define IR_FIFO_SIZE 64 // edges per open file, power of two for kfifo
+
+static unsigned int left_gpio = IR_LEFT_GPIO;
+module_param(left_gpio, uint, 0444);
+MODULE_PARM_DESC(left_gpio, "Kernel GPIO number of the left IR sensor output");
+static unsigned int right_gpio = IR_RIGHT_GPIO;
+module_param(right_gpio, uint, 0444);
+MODULE_PARM_DESC(right_gpio, "Kernel GPIO number of the right IR sensor output");
+
+dev_t ir_dev = 0; // device driver's major/minor number
+
+/* start of edge events */
+/*
+ * Each open file has its own kfifo of edge records, so every reader sees
+ * every edge. The IRQ handlers stamp the edge first and fan it out to all
+ * files under ir_lock; a file that stops reading loses its oldest records.
+ */
+struct ir_session {
+	struct list_head node;
+	DECLARE_KFIFO(events, struct ir_event, IR_FIFO_SIZE);
+	unsigned long dropped;
+};
+
+struct ir_pin {
+	unsigned int *gpio;
+	const char *label;
+	__u8 bit;
+	int irq;
+};
+
+static struct ir_pin ir_pins[] = {
+	{ &left_gpio, IR_LEFT_LABEL, IR_LEFT, -1 },
+	{ &right_gpio, IR_RIGHT_LABEL, IR_RIGHT, -1 },
+};
+
+static LIST_HEAD(ir_sessions);
+static DEFINE_SPINLOCK(ir_lock); //sessions, their fifos and the state below; taken in hardirq
+static DECLARE_WAIT_QUEUE_HEAD(ir_waitqueue);
+static __u8 ir_state; //sensors seeing an obstacle, tracked even while reporting is off
+static _Bool ir_enabled = 1;
+static unsigned long ir_edges; //edges seen since the module was loaded
+static unsigned long ir_dropped; //records lost by files that fell behind
+
+static __u8 ir_reported_state(void) {
+	return ir_enabled ? ir_state : 0;
+}
+
+// ir_lock must be held
+static void ir_push_locked(struct ir_session *session, uint64_t now, __u8 changed) {
+	struct ir_event event = {
+		.timestamp_ns = now,
+		.state = ir_reported_state(),
+		.changed = changed,
+	};
+	if(kfifo_is_full(&session->events)) { //keep the newest edges
+		kfifo_skip(&session->events);
+		session->dropped++;
+		ir_dropped++;
+	}
+	kfifo_put(&session->events, event);
+}
+
+static void ir_broadcast_locked(uint64_t now, __u8 changed) {
+	struct ir_session *session;
+	list_for_each_entry(session, &ir_sessions, node) {
+		ir_push_locked(session, now, changed);
+	}
+}
+/* end of edge events */
+
+/* start of IRQ Handler */
+
+static irqreturn_t ir_edge_triggered(int irq, void *dev_id) {
+	uint64_t now = ktime_get_ns(); //edge time, taken before anything else delays it
+	struct ir_pin *pin = dev_id;
+	_Bool obstacle = !gpio_get_value(*pin->gpio); //the sensor pulls its output low on an obstacle
+	__u8 state;
+
+	spin_lock(&ir_lock); //hardirq, interrupts are already off
+	state = obstacle ? (ir_state | pin->bit) : (ir_state & ~pin->bit);
+	if(state != ir_state) { //a bounce can leave the level where it was
+		ir_state = state;
+		ir_edges++;
+		if(ir_enabled) {
+			ir_broadcast_locked(now, pin->bit);
+		}
+	}
+	spin_unlock(&ir_lock);
+	wake_up_interruptible(&ir_waitqueue);
+	return IRQ_HANDLED;
+}
+
+
+/* -- start of function prototype */
+struct class *ir_class;
+struct cdev ir_cdev;
+
+static int __init ir_driver_init(void);
+int ir_driver_open(struct inode *inode, struct file *file) ;
+int ir_driver_release(struct inode *inode, struct file *file) ;
+static void __exit ir_driver_exit(void);
+
+ssize_t ir_read(struct file *file, char __user *buf, size_t len, loff_t * off);
+ssize_t ir_write(struct file *file, const char __user *buf, size_t len, loff_t * off);
+__poll_t ir_poll(struct file *file, poll_table *wait);
+
+/* -- end of function prototype -- */
+
+struct file_operations ir_fops = {
+	.owner	= THIS_MODULE,
+	.read	= ir_read,
+	.write	= ir_write,
+	.poll	= ir_poll,
+	.open	= ir_driver_open,
+	.release = ir_driver_release,
+};
+
+int ir_driver_open(struct inode *inode, struct file *file) {
+	struct ir_session *session = kzalloc(sizeof(*session), GFP_KERNEL);
+	unsigned long flags;
+
+	if(session == NULL) {
+		return -ENOMEM;
+	}
+	INIT_KFIFO(session->events);
+	spin_lock_irqsave(&ir_lock, flags);
+	ir_push_locked(session, ktime_get_ns(), 0); //snapshot, so the first read tells where we stand
+	list_add_tail(&session->node, &ir_sessions);
+	spin_unlock_irqrestore(&ir_lock, flags);
+	file->private_data = session;
+	return 0;
+}
+
+int ir_driver_release(struct inode *inode, struct file *file) {
+	struct ir_session *session = file->private_data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ir_lock, flags);
+	list_del(&session->node);
+	spin_unlock_irqrestore(&ir_lock, flags);
+	kfree(session);
+	return 0;
+}
+
+static int __init ir_driver_init(void) {
+	int i;
+
+	if(alloc_chrdev_region(&ir_dev, 0, 1, "ir_avoid")<0) { /* NOTE: DEV_T ALLOC */
+		_printk("Cannot allocate chrdev region, Quitting without driver ins...\n");
+		return -1;
+	}
+	_printk("Major = %d, Minor = %d", MAJOR(ir_dev),MINOR(ir_dev));
+	cdev_init(&ir_cdev,&ir_fops);
+	if((cdev_add(&ir_cdev,ir_dev,1)) < 0) { /* NOTE: ADDING CDEV */
+		_printk("Cannot add cdev, Quitting without driver ins...\n");
+		goto cdev_error;
+	}
+	if(IS_ERR(ir_class = class_create("ir_class"))) { /* NOTE: CREATING DEV CLASS */
+		_printk("Cannot create class structure, Quitting without driver ins..\n");
+		goto class_error;
+	}
+	if(IS_ERR(device_create(ir_class, NULL, ir_dev, NULL, "ir_device"))) { /* NOTE: DEV CREATION */
+		_printk("Cannot create the device, Quitting without driver ins...\n");
+		goto device_creation_error;
+	}
+
+	for(i = 0; i < ARRAY_SIZE(ir_pins); i++) {
+		struct ir_pin *pin = &ir_pins[i];
+		if(!gpio_is_valid(*pin->gpio) || gpio_request(*pin->gpio, pin->label) < 0) {
+			_printk("IR %s PIN IS NOT WORKING\n", pin->label);
+			goto gpio_error;
+		}
+		gpio_direction_input(*pin->gpio);
+		if(!gpio_get_value(*pin->gpio)) {
+			ir_state |= pin->bit;
+		}
+	}
+	for(i = 0; i < ARRAY_SIZE(ir_pins); i++) {
+		struct ir_pin *pin = &ir_pins[i];
+		pin->irq = gpio_to_irq(*pin->gpio);
+		if(pin->irq < 0 || request_irq(pin->irq, ir_edge_triggered, IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING,
+			"ir_avoid", pin)) {
+			_printk("cannot register %s irq...", pin->label);
+			pin->irq = -1;
+			goto irq_error;
+		}
+	}
+	_printk("IR Dev. Driver inserted.");
+	return 0;
+
+irq_error:
+	while(i-- > 0) {
+		free_irq(ir_pins[i].irq, &ir_pins[i]);
+		ir_pins[i].irq = -1;
+	}
+	i = ARRAY_SIZE(ir_pins);
+gpio_error:
+	while(i-- > 0) {
+		gpio_free(*ir_pins[i].gpio);
+	}
+	device_destroy(ir_class,ir_dev);
+device_creation_error:
+	class_destroy(ir_class);
+class_error:
+	cdev_del(&ir_cdev);
+cdev_error:
+	unregister_chrdev_region(ir_dev,1);
+	_printk("IR Dev. Driver failed");
+	return -1;
+}
+
+static void __exit ir_driver_exit(void) {
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(ir_pins); i++) {
+		free_irq(ir_pins[i].irq, &ir_pins[i]);
+		gpio_free(*ir_pins[i].gpio);
+	}
+	_printk("IR sensors: %lu edges, %lu records dropped\n", ir_edges, ir_dropped);
+	device_destroy(ir_class,ir_dev);
+	class_destroy(ir_class);
+	cdev_del(&ir_cdev);
+	unregister_chrdev_region(ir_dev,1);
+	_printk( "IR Dev. Driver removed.\n" );
+}
+
+
+ssize_t ir_read(struct file *file, char __user *buf, size_t len, loff_t * off) {
+	struct ir_session *session = file->private_data;
+	struct ir_event events[8];
+	unsigned long flags;
+	unsigned int count;
+
+	if(len < sizeof(events[0])) { //whole records only
+		return -EINVAL;
+	}
+	for(;;) {
+		spin_lock_irqsave(&ir_lock, flags);
+		count = kfifo_out(&session->events, events, min_t(size_t, len / sizeof(events[0]), ARRAY_SIZE(events)));
+		spin_unlock_irqrestore(&ir_lock, flags);
+		if(count > 0) {
+			break;
+		}
+		if(file->f_flags & O_NONBLOCK) {
+			return -EAGAIN;
+		}
+		if(wait_event_interruptible(ir_waitqueue, !kfifo_is_empty(&session->events))) {
+			return -ERESTARTSYS;
+		}
+	}
+	if(copy_to_user(buf, events, count * sizeof(events[0]))) {
+		return -EFAULT;
+	}
+	return count * sizeof(events[0]);
+}
+
+//"ON" resumes reporting, "OFF" stops it; readers get a record for either
+ssize_t ir_write(struct file *file, const char __user *buf, size_t len, loff_t * off) {
+	char cmd[4] = {0};
+	unsigned long flags;
+	_Bool enable;
+
+	if(len == 0) {
+		return 0;
+	}
+	if(copy_from_user(cmd, buf, min_t(size_t, len, sizeof(cmd) - 1))) {
+		return -EFAULT;
+	}
+	if(strncmp(cmd, "ON", 2) == 0) {
+		enable = 1;
+	} else if(strncmp(cmd, "OFF", 3) == 0) {
+		enable = 0;
+	} else {
+		return -EINVAL;
+	}
+	spin_lock_irqsave(&ir_lock, flags);
+	if(enable != ir_enabled) {
+		ir_enabled = enable;
+		ir_broadcast_locked(ktime_get_ns(), ir_state);
+	}
+	spin_unlock_irqrestore(&ir_lock, flags);
+	wake_up_interruptible(&ir_waitqueue);
+	return len;
+}
+
+__poll_t ir_poll(struct file *file, poll_table *wait) {
+	struct ir_session *session = file->private_data;
+	__poll_t mask = EPOLLOUT | EPOLLWRNORM; //writes never block
+	poll_wait(file, &ir_waitqueue, wait);
+	if(!kfifo_is_empty(&session->events)) {
+		mask |= EPOLLIN | EPOLLRDNORM;
+	}
+	return mask;
+}
+
+module_init(ir_driver_init);
+module_exit(ir_driver_exit);
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("IR obstacle sensors with edge events");
+MODULE_VERSION("0.02");
@@ -0,0 +1,4 @@
+#!/bin/sh
+if test -f ir_avoid.ko.xz;then
+	rm -rf ir_avoid.ko.xz
+fi
@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/hub/motor_bus.h"
+#include "../common/hub/sensor_hub.h"
+#include "../common/ir/ir_event.h"
+
+/*
+ * Prints the sensor hub's snapshot and the motor bus slots. It only maps
+ * both blocks read-only, so watching a run adds nothing to the
+ * controllers' loops.
+ */
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int signo) {
+    (void)signo;
+    stop_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static const void* map_readonly(const char* name, size_t size) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+// Milliseconds since a CLOCK_MONOTONIC stamp, -1 for none
+static double age_ms(uint64_t now, uint64_t stamp) {
+    if (stamp == 0) {
+        return -1.0;
+    }
+    return now > stamp ? (double)(now - stamp) / 1e6 : 0.0;
+}
+
+static void print_snapshot(const HubShm_t* hub, uint64_t now) {
+    HubSnapshot_t snapshot;
+    if (hub == NULL || !hub_shm_read(hub, &snapshot)) {
+        printf("hub: no snapshot\n");
+        return;
+    }
+    printf("hub pid %u, published %.1f ms ago%s\n", __atomic_load_n(&hub->writer_pid, __ATOMIC_RELAXED),
+           age_ms(now, snapshot.publish_ns), snapshot.valid ? "" : ", no sensor reporting");
+    if (snapshot.valid & HUB_HAVE_DISTANCE) {
+        printf("  distance %u cm (#%u, %.1f ms ago)\n", snapshot.distance_cm, snapshot.distance_seq,
+               age_ms(now, snapshot.distance_ns));
+    }
+    if (snapshot.valid & HUB_HAVE_IR) {
+        printf("  ir left %s, right %s (edge %.1f ms ago)\n", (snapshot.ir_state & IR_LEFT) ? "obstacle" : "clear",
+               (snapshot.ir_state & IR_RIGHT) ? "obstacle" : "clear", age_ms(now, snapshot.ir_ns));
+    }
+    if (snapshot.valid & HUB_HAVE_MOTOR) {
+        printf("  motor frame %02x %02x %02x %02x %02x (%.1f ms ago)\n", snapshot.motor_frame[0],
+               snapshot.motor_frame[1], snapshot.motor_frame[2], snapshot.motor_frame[3], snapshot.motor_frame[4],
+               age_ms(now, snapshot.motor_ns));
+    }
+    if (snapshot.owner_slot != HUB_NO_OWNER) {
+        printf("  owner pid %u in slot %u, setpoint #%u applied\n", snapshot.owner_pid, snapshot.owner_slot,
+               snapshot.owner_applied);
+    } else {
+        printf("  no owner\n");
+    }
+}
+
+static void print_bus(const MotorBus_t* bus, uint64_t now) {
+    if (bus == NULL || !motor_bus_valid(bus)) {
+        printf("bus: not available\n");
+        return;
+    }
+    for (int i = 0; i < MOTOR_BUS_SLOTS; ++i) {
+        uint32_t pid = __atomic_load_n(&bus->slots[i].pid, __ATOMIC_ACQUIRE);
+        if (pid == 0) {
+            continue;
+        }
+        char name[MOTOR_BUS_NAME_LEN];
+        motor_bus_read_name(bus, i, name);
+        MotorSetpoint_t setpoint = {0};
+        motor_bus_read_setpoint(bus, i, &setpoint);
+        printf("  slot %d: %s pid %u priority %u, beat %.1f ms ago, setpoint #%u %02x %02x %02x %02x %02x\n", i, name,
+               pid, __atomic_load_n(&bus->slots[i].priority, __ATOMIC_RELAXED),
+               age_ms(now, __atomic_load_n(&bus->slots[i].heartbeat_ns, __ATOMIC_ACQUIRE)), setpoint.seq,
+               setpoint.frame[0], setpoint.frame[1], setpoint.frame[2], setpoint.frame[3], setpoint.frame[4]);
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned rate_hz = 2;
+    bool once = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate_hz = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--once") == 0) {
+            once = true;
+        } else {
+            rate_hz = 0;
+            break;
+        }
+    }
+    if (rate_hz == 0 || rate_hz > 100) {
+        fprintf(stderr, "usage: %s [--rate HZ] [--once]\n", argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    // The blocks may appear later; look for them again on every line
+    const HubShm_t* hub = NULL;
+    const MotorBus_t* bus = NULL;
+    while (!stop_requested) {
+        if (hub == NULL) {
+            hub = map_readonly(HUB_SHM_NAME, sizeof(HubShm_t));
+        }
+        if (bus == NULL) {
+            bus = map_readonly(MOTOR_BUS_SHM_NAME, sizeof(MotorBus_t));
+        }
+        uint64_t now = now_ns();
+        print_snapshot(hub, now);
+        print_bus(bus, now);
+        fflush(stdout);
+        if (once) {
+            break;
+        }
+        uint64_t period_ns = 1000000000ULL / rate_hz;
+        struct timespec period = {.tv_sec = (time_t)(period_ns / 1000000000ULL),
+                                  .tv_nsec = (long)(period_ns % 1000000000ULL)};
+        nanosleep(&period, NULL);
+    }
+    return 0;
+}
@@ -1,50 +1,179 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <time.h>
 #include <stdbool.h>
+#include <string.h>
 #include <sys/time.h>
 #include <signal.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #define DEVNAME "/dev/motor"
 #define SR04 "/dev/sr04"
-#define IR "/dev/ir_device"
+#include "../common/ir/ir_event.h"
+#define IR IR_DEVNAME
 #include "../common/motor/ioctl_car_cmd.h"
+#include "../common/telemetry/records.h"
+#include "worm/libsoul/tlog.h"
+#include "worm/hub.h"
 #define AVOID_DIST 70
 #define DIST_MAX   300
 #define BACK_DIST  5
 #define MOVE_TIME         1
 #define SLEEP_TIME        60
 #define ONE_MILI_SEC      1000
+#define TELEMETRY_FILE    "runner_telemetry.bin"
+#define TELEMETRY_SLOTS   256
+#define HUB_WAIT_MS       100
 int motor;
 int sr04;
 int ir;
-void sigHandler (int dummy)
+static ttak_tlog_t telemetry_log;
+static RunnerTelemetry_t telemetry_slots[TELEMETRY_SLOTS];
+static u_int8_t ir_obstacles;
+// With --bus the sensor hub owns every device and the runner only reads and posts through it
+static bool bus_mode = false;
+static HubLink_t hub_link;
+static u_int32_t hub_distance_seq;
+// Set by SIGINT; the loop winds down and main releases everything outside the handler
+static volatile sig_atomic_t stop_requested = 0;
+static uint64_t now_ns (void)
 {
-    close (sr04);
-    close (ir);
-    ioctl(motor, PI_CMD_STOP, sizeof (struct ioctl_info));
-    close (motor);
-    exit (0);
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+// Waits for the next measurement like a read of /dev/sr04 would; 0 if the hub has gone quiet
+static u_int32_t read_distance (void)
+{
+    if (!bus_mode) {
+        static u_int32_t last_dist = 0;
+        char buf[16] = {0}; // the driver always copies 16 bytes
+        if (read (sr04, buf, sizeof (buf)) < 0 && errno == EBUSY) {
+            return last_dist; // an ultrasonic frame is on air, the driver holds ranging off
+        }
+        last_dist = atoi (buf);
+        return last_dist;
+    }
+    for (int waited = 0; waited < HUB_WAIT_MS; waited++) {
+        HubSnapshot_t snapshot;
+        uint64_t now = now_ns ();
+        HubLink_beat (&hub_link, now);
+        if (HubLink_snapshot (&hub_link, now, &snapshot) && snapshot.distance_seq != hub_distance_seq) {
+            hub_distance_seq = snapshot.distance_seq;
+            ir_obstacles = snapshot.ir_state;
+            return snapshot.distance_cm;
+        }
+        usleep (ONE_MILI_SEC);
+    }
+    return 0;
+}
+static void drive (struct ioctl_info *io)
+{
+    if (bus_mode) {
+        HubLink_post (&hub_link, io->buf, now_ns ());
+    } else {
+        ioctl (motor, PI_CMD_IO, io);
+    }
+}
+static void stop_car (void)
+{
+    if (bus_mode) {
+        const char stop[5] = { 0x01, 0x00, 0x00, 0x00, 0x00 };
+        HubLink_post (&hub_link, stop, now_ns ());
+    } else {
+        ioctl (motor, PI_CMD_STOP, sizeof (struct ioctl_info));
+    }
+}
+// Applies every queued IR edge; the driver's first record after open is the current state
+static void drain_ir (void)
+{
+    struct ir_event events[8];
+    ssize_t got;
+    if (bus_mode) {
+        HubSnapshot_t snapshot;
+        if (HubLink_snapshot (&hub_link, now_ns (), &snapshot)) {
+            ir_obstacles = snapshot.ir_state;
+        }
+        return;
+    }
+    while ((got = read (ir, events, sizeof (events))) >= (ssize_t)sizeof (events[0])) {
+        ir_obstacles = events[got / sizeof (events[0]) - 1].state;
+    }
+}
+// 'L' or 'R' for the side that sees an obstacle, 'B' for both, '-' for none
+static char ir_side (void)
+{
+    if ((ir_obstacles & (IR_LEFT | IR_RIGHT)) == (IR_LEFT | IR_RIGHT)) {
+        return 'B';
+    }
+    if (ir_obstacles & IR_LEFT) {
+        return 'L';
+    }
+    return (ir_obstacles & IR_RIGHT) ? 'R' : '-';
+}
+static void log_action (u_int32_t dist, char ir_flag, u_int8_t action, const struct ioctl_info *io)
+{
+    RunnerTelemetry_t record = {
+        .timestamp_ns = now_ns (),
+        .distance_cm = dist,
+        .ir_flag = (uint8_t)ir_flag,
+        .action = action,
+        .left_speed = (uint8_t)io->buf[2],
+        .right_speed = (uint8_t)io->buf[4],
+    };
+    ttak_tlog_write (&telemetry_log, &record);
+}
+static void on_signal (int signo)
+{
+    (void)signo;
+    stop_requested = 1;
 }
-int main ()
+int main (int argc, char **argv)
 {
-    u_int32_t dist=0, irLeft =0, irRight=0, prev_dist = 0;
+    u_int32_t dist=0;
+    unsigned long bus_priority = 0;
+    if (argc == 3 && strcmp (argv[1], "--bus") == 0) {
+        bus_priority = strtoul (argv[2], NULL, 10);
+        bus_mode = bus_priority >= 1 && bus_priority <= MOTOR_BUS_MAX_PRIORITY;
+    }
+    if (argc != 1 && !bus_mode) {
+        fprintf (stderr, "usage: %s [--bus PRIORITY]\n", argv[0]);
+        return 2;
+    }
     puts ("Runner begins");
-    motor = open (DEVNAME, O_RDWR);
-    ir = open (IR, O_RDWR);
-    sr04 = open (SR04, O_RDWR);
-    signal (SIGINT, sigHandler);
+    if (bus_mode) {
+        HubLink_init (&hub_link);
+        if (!HubLink_join_bus (&hub_link, (uint32_t)bus_priority, "runner", now_ns ())) {
+            puts ("Motor bus unavailable; is sensor_hub running with /dev/motor?");
+            return 1;
+        }
+        motor = sr04 = ir = -1;
+    } else {
+        motor = open (DEVNAME, O_RDWR);
+        ir = open (IR, O_RDONLY | O_NONBLOCK);
+        sr04 = open (SR04, O_RDWR);
+    }
+    signal (SIGINT, on_signal);
     srand(time(NULL));
-    while (true) {
-        prev_dist = dist;
-        char buf[8];
-        char ir_flag[5];
-        read (sr04, buf, 8);
-        dist = atoi(buf);
-        read (ir, ir_flag, 5);
+    const ttak_tlog_config_t telemetry_config = {
+        .path = TELEMETRY_FILE,
+        .record_kind = TELEMETRY_KIND_RUNNER,
+        .record_size = sizeof (RunnerTelemetry_t),
+        .segment_records = 60000,
+        .keep_segments = 4,
+    };
+    if (!ttak_tlog_open (&telemetry_log, &telemetry_config, telemetry_slots, TELEMETRY_SLOTS)) {
+        puts ("Telemetry log unavailable");
+    }
+    while (!stop_requested) {
+        char ir_flag[1];
+        dist = read_distance ();
+        drain_ir ();
+        ir_flag[0] = ir_side ();
         struct ioctl_info io;
         io.buf[0] = 1;
         io.size = 5;
@@ -59,37 +188,34 @@ int main ()
         } else {
             io.buf[2] = io.buf[4] = 60;
         }
-        printf("distance is %d\n", dist);
         if (dist < AVOID_DIST) {
             if (dist < BACK_DIST) {
                 io.buf[1] = 0;
                 io.buf[3] = 0;
-                ioctl(motor, PI_CMD_IO, &io, &io);
-                printf("backward --> (%u)\n", dist);
-                while(dist < BACK_DIST) {
-                    read (sr04, buf, 8);
-                    dist = atoi(buf);
+                drive (&io);
+                log_action (dist, ir_flag[0], RUNNER_ACTION_BACKWARD, &io);
+                while(dist < BACK_DIST && !stop_requested) {
+                    dist = read_distance ();
                 }
             } else if (ir_flag[0] == 'L') {
                 io.buf[1] = 0;
                 io.buf[3] = 1;
-                ioctl(motor, PI_CMD_IO, &io);
-                printf("right --> (%u)\n", dist);
-                while(dist < AVOID_DIST) {
-                    read (sr04, buf, 8);
-                    dist = atoi(buf);
+                drive (&io);
+                log_action (dist, ir_flag[0], RUNNER_ACTION_RIGHT, &io);
+                while(dist < AVOID_DIST && !stop_requested) {
+                    dist = read_distance ();
                 }
             } else if (ir_flag[0] == 'R') {
                 io.buf[1] = 1;
                 io.buf[3] = 0;
-                ioctl(motor, PI_CMD_IO, &io);
-                printf("left --> (%u)\n", dist);
-                while(dist < AVOID_DIST) {
-                    read (sr04, buf, 8);
-                    dist = atoi(buf);
+                drive (&io);
+                log_action (dist, ir_flag[0], RUNNER_ACTION_LEFT, &io);
+                while(dist < AVOID_DIST && !stop_requested) {
+                    dist = read_distance ();
                 }
            } else if (!dist) {
-                ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
+                stop_car ();
+                log_action (dist, ir_flag[0], RUNNER_ACTION_STOP, &io);
             } else {
                 if(rand()%2) {
                     io.buf[1] = 0;
@@ -98,21 +224,31 @@ int main ()
                     io.buf[1] = 1;
                     io.buf[3] = 0;
                 }
-                ioctl(motor, PI_CMD_IO, &io);
-                printf("left (predefined) --> (%u)\n", dist);
-                while(dist < AVOID_DIST) {
-                    read (sr04, buf, 8);
-                    dist = atoi(buf);
+                drive (&io);
+                log_action (dist, ir_flag[0], RUNNER_ACTION_RANDOM_TURN, &io);
+                while(dist < AVOID_DIST && !stop_requested) {
+                    dist = read_distance ();
                 }
             }
         } else {
             io.buf[1] = 1;
             io.buf[3] = 1;
-            ioctl(motor, PI_CMD_IO, &io);
-            printf("forward --> (%u)\n", dist);
+            drive (&io);
+            log_action (dist, ir_flag[0], RUNNER_ACTION_FORWARD, &io);
         }
-	usleep(ONE_MILI_SEC * SLEEP_TIME);
+        // Sleep until the next cycle, but wake at once when an IR sensor changes
+        struct pollfd ir_wait = { .fd = ir, .events = POLLIN };
+        poll (&ir_wait, ir >= 0 ? 1 : 0, SLEEP_TIME);
     }
+    ttak_tlog_close (&telemetry_log);
+    stop_car ();
+    if (bus_mode) {
+        HubLink_close (&hub_link); // the hub stops the car once the slot is gone
+        return 0;
+    }
+    close (sr04);
+    close (ir);
+    close (motor);
     return 0;
 }
 
@@ -0,0 +1,457 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/hub/motor_bus.h"
+#include "../common/hub/sensor_hub.h"
+#include "../common/ir/ir_event.h"
+#include "../common/motor/ioctl_car_cmd.h"
+
+/*
+ * Owns the car's sensors and publishes them as one HubSnapshot_t. A
+ * ranging thread measures with the SR04 at a fixed rate, since a read
+ * blocks for the whole echo. The main thread sleeps in poll() on the IR
+ * edge queue and asks the motor driver for its last frame every
+ * MOTOR_POLL_MS. Each change is published at once, so readers see an IR
+ * edge without waiting for the next measurement.
+ *
+ * The main thread also runs the motor bus: it picks the owner among the
+ * controllers' slots and sends the owner's setpoints to /dev/motor. It
+ * resends the current one every MOTOR_REFRESH_NS, which feeds the hub's
+ * own motor watchdog, so the car stops if the hub itself hangs.
+ */
+
+#define MOTOR_DEVNAME "/dev/motor"
+#define SR04_DEVNAME "/dev/sr04"
+#define DEFAULT_RATE_HZ 20
+#define MAX_RATE_HZ 40 // an echo from 4 m takes about 24 ms
+#define MOTOR_POLL_MS 10
+#define MOTOR_REFRESH_NS 100000000ull
+#define MOTOR_WATCHDOG_MS (MOTOR_BUS_TIMEOUT_NS / 1000000u)
+
+typedef struct {
+    unsigned long long snapshots;
+    unsigned long long measurements;
+    unsigned long long no_echo;
+    unsigned long long held_off;
+    unsigned long long ir_records;
+    unsigned long long motor_frames;
+    unsigned long long setpoints;
+    unsigned long long handovers;
+    unsigned long long expired;
+} HubStats_t;
+
+// Only the main thread touches this
+typedef struct {
+    MotorBus_t* bus;
+    int motor;
+    int owner;                 // slot index, -1 for none
+    uint32_t owner_pid;
+    uint32_t takeover_seq;     // the owner's setpoint seq when it took over, never applied
+    uint32_t applied_seq;
+    uint64_t applied_ns;
+    MotorSetpoint_t applied;
+} Arbiter_t;
+
+typedef struct {
+    int fd;
+    int rate_hz;
+} Ranging_t;
+
+static volatile sig_atomic_t stop_requested = 0;
+static HubShm_t* hub = NULL;
+// Both threads publish; the lock keeps the seqlock single-writer
+static pthread_mutex_t publish_lock = PTHREAD_MUTEX_INITIALIZER;
+static HubSnapshot_t current;
+static HubStats_t stats;
+
+static void on_signal(int signo) {
+    (void)signo;
+    stop_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// publish_lock must be held
+static void publish_locked(void) {
+    current.publish_ns = now_ns();
+    hub_shm_publish(hub, &current);
+    stats.snapshots++;
+}
+
+static void* map_block(const char* name, size_t size, mode_t mode) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, mode);
+    if (fd < 0) {
+        fprintf(stderr, "shm_open %s: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    // shm_open is subject to the umask; controllers need to write their slots
+    fchmod(fd, mode);
+    if (ftruncate(fd, (off_t)size) != 0) {
+        fprintf(stderr, "ftruncate %s: %s\n", name, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "mmap %s: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    return map;
+}
+
+static HubShm_t* create_hub(void) {
+    HubShm_t* shm = map_block(HUB_SHM_NAME, sizeof(HubShm_t), 0644);
+    if (shm == NULL) {
+        return NULL;
+    }
+    // seq carries on from an earlier run, so a reader never sees it go back
+    __atomic_store_n(&shm->magic, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->writer_pid, (uint32_t)getpid(), __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->version, HUB_SNAPSHOT_VERSION, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->magic, HUB_SHM_MAGIC, __ATOMIC_RELEASE);
+    return shm;
+}
+
+static void* ranging_thread(void* arg) {
+    const Ranging_t* ranging = arg;
+    uint64_t period_ns = 1000000000ULL / (uint64_t)ranging->rate_hz;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!stop_requested) {
+        char dist_buf[16] = {0}; // the driver always copies 16 bytes
+        ssize_t got = read(ranging->fd, dist_buf, sizeof(dist_buf));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        // The driver holds ranging off while an ultrasonic frame is on air; the last distance stays published
+        bool held_off = got < 0 && errno == EBUSY;
+        uint64_t measured = now_ns();
+        pthread_mutex_lock(&publish_lock);
+        if (held_off) {
+            stats.held_off++;
+        } else {
+            current.distance_cm = got > 0 ? (uint32_t)strtoul(dist_buf, NULL, 10) : 0;
+            current.distance_ns = measured;
+            current.distance_seq++;
+            current.valid |= HUB_HAVE_DISTANCE;
+            stats.measurements++;
+            if (current.distance_cm == 0) {
+                stats.no_echo++;
+            }
+            publish_locked();
+        }
+        pthread_mutex_unlock(&publish_lock);
+
+        next.tv_nsec += (long)period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        // A late measurement starts the next one right away rather than catching up
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+            next = now;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR && !stop_requested) {
+        }
+    }
+    return NULL;
+}
+
+static bool drain_ir(int ir) {
+    struct ir_event events[8];
+    bool changed = false;
+    for (;;) {
+        ssize_t got = read(ir, events, sizeof(events));
+        if (got < (ssize_t)sizeof(events[0])) {
+            return changed;
+        }
+        const struct ir_event* last = &events[got / sizeof(events[0]) - 1];
+        pthread_mutex_lock(&publish_lock);
+        current.ir_state = last->state;
+        current.ir_ns = last->timestamp_ns;
+        current.valid |= HUB_HAVE_IR;
+        stats.ir_records += got / sizeof(events[0]);
+        pthread_mutex_unlock(&publish_lock);
+        changed = true;
+    }
+}
+
+static bool poll_motor(int motor) {
+    struct motor_frame frame;
+    if (ioctl(motor, PI_CMD_LAST_FRAME, &frame) != 0 || frame.timestamp_ns == 0) {
+        return false;
+    }
+    pthread_mutex_lock(&publish_lock);
+    bool changed = frame.timestamp_ns != current.motor_ns;
+    if (changed) {
+        memcpy(current.motor_frame, frame.buf, sizeof(current.motor_frame));
+        current.motor_ns = frame.timestamp_ns;
+        current.valid |= HUB_HAVE_MOTOR;
+        stats.motor_frames++;
+    }
+    pthread_mutex_unlock(&publish_lock);
+    return changed;
+}
+
+// Slots keep their setpoint seq across claims, so only the pid says who is who
+static MotorBus_t* create_bus(void) {
+    MotorBus_t* bus = map_block(MOTOR_BUS_SHM_NAME, sizeof(MotorBus_t), 0666);
+    if (bus == NULL) {
+        return NULL;
+    }
+    __atomic_store_n(&bus->magic, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&bus->hub_pid, (uint32_t)getpid(), __ATOMIC_RELAXED);
+    __atomic_store_n(&bus->version, MOTOR_BUS_VERSION, __ATOMIC_RELAXED);
+    __atomic_store_n(&bus->magic, MOTOR_BUS_MAGIC, __ATOMIC_RELEASE);
+    return bus;
+}
+
+static void free_slot(MotorBus_t* bus, int index, uint32_t pid) {
+    __atomic_store_n(&bus->slots[index].heartbeat_ns, 0, __ATOMIC_RELEASE);
+    __atomic_compare_exchange_n(&bus->slots[index].pid, &pid, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static bool send_frame(Arbiter_t* arbiter, const uint8_t frame[5]) {
+    struct ioctl_info io = {.size = 5};
+    memcpy(io.buf, frame, sizeof(io.buf));
+    // The driver answers a motion command with the command number, not 0
+    return ioctl(arbiter->motor, PI_CMD_IO, &io) >= 0;
+}
+
+/*
+ * Picks the owner and applies its newest setpoint. Returns true when the
+ * owner or the applied setpoint changed, so the snapshot needs publishing.
+ */
+static bool arbitrate(Arbiter_t* arbiter, uint64_t now) {
+    MotorBus_t* bus = arbiter->bus;
+    int best = -1;
+    uint32_t best_priority = 0;
+    for (int i = 0; i < MOTOR_BUS_SLOTS; ++i) {
+        MotorBusSlot_t* slot = &bus->slots[i];
+        uint32_t pid = __atomic_load_n(&slot->pid, __ATOMIC_ACQUIRE);
+        if (pid == 0) {
+            continue;
+        }
+        uint64_t beat = __atomic_load_n(&slot->heartbeat_ns, __ATOMIC_ACQUIRE);
+        bool gone = kill((pid_t)pid, 0) != 0 && errno == ESRCH;
+        if (gone || (beat != 0 && now > beat && now - beat > MOTOR_BUS_TIMEOUT_NS)) {
+            free_slot(bus, i, pid);
+            stats.expired++;
+            continue;
+        }
+        if (beat == 0) {
+            continue; // still being claimed
+        }
+        uint32_t priority = __atomic_load_n(&slot->priority, __ATOMIC_RELAXED);
+        bool keeps = i == arbiter->owner && pid == arbiter->owner_pid;
+        if (best < 0 || priority > best_priority || (priority == best_priority && keeps)) {
+            best = i;
+            best_priority = priority;
+        }
+    }
+
+    uint32_t best_pid = best >= 0 ? __atomic_load_n(&bus->slots[best].pid, __ATOMIC_RELAXED) : 0;
+    bool changed = false;
+    if (best != arbiter->owner || best_pid != arbiter->owner_pid) {
+        // Nothing the old owner asked for may outlive its ownership
+        if (arbiter->owner >= 0) {
+            ioctl(arbiter->motor, PI_CMD_STOP, sizeof(struct ioctl_info));
+        }
+        arbiter->owner = best;
+        arbiter->owner_pid = best_pid;
+        arbiter->applied_seq = 0;
+        arbiter->takeover_seq = 0;
+        MotorSetpoint_t pending;
+        if (best >= 0 && motor_bus_read_setpoint(bus, best, &pending)) {
+            arbiter->takeover_seq = pending.seq;
+        }
+        stats.handovers++;
+        changed = true;
+    }
+    if (arbiter->owner < 0) {
+        return changed;
+    }
+
+    MotorSetpoint_t setpoint;
+    if (!motor_bus_read_setpoint(bus, arbiter->owner, &setpoint) || setpoint.seq == 0 ||
+        setpoint.seq == arbiter->takeover_seq) {
+        return changed;
+    }
+    if (setpoint.seq != arbiter->applied_seq) {
+        if (send_frame(arbiter, setpoint.frame)) {
+            arbiter->applied = setpoint;
+            arbiter->applied_seq = setpoint.seq;
+            arbiter->applied_ns = now;
+            stats.setpoints++;
+            changed = true;
+        }
+    } else if (now - arbiter->applied_ns >= MOTOR_REFRESH_NS) {
+        if (send_frame(arbiter, arbiter->applied.frame)) {
+            arbiter->applied_ns = now;
+        }
+    }
+    return changed;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--rate HZ]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    int rate_hz = DEFAULT_RATE_HZ;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate_hz = atoi(argv[++i]);
+            if (rate_hz < 1 || rate_hz > MAX_RATE_HZ) {
+                fprintf(stderr, "--rate takes 1 to %d\n", MAX_RATE_HZ);
+                return 2;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Every source is optional so the hub also runs on a bench with one driver loaded
+    int sr04 = open(SR04_DEVNAME, O_RDWR);
+    if (sr04 < 0) {
+        perror(SR04_DEVNAME);
+    }
+    int ir = open(IR_DEVNAME, O_RDONLY | O_NONBLOCK);
+    if (ir < 0) {
+        perror(IR_DEVNAME);
+    }
+    int motor = open(MOTOR_DEVNAME, O_RDWR);
+    if (motor < 0) {
+        perror(MOTOR_DEVNAME);
+    }
+    if (sr04 < 0 && ir < 0 && motor < 0) {
+        fprintf(stderr, "No sensor to publish.\n");
+        return 1;
+    }
+    hub = create_hub();
+    if (hub == NULL) {
+        return 1;
+    }
+    current.owner_slot = HUB_NO_OWNER;
+    Arbiter_t arbiter = {.motor = motor, .owner = -1};
+    if (motor >= 0) {
+        arbiter.bus = create_bus();
+        // If the hub hangs, the driver stops whatever the owner asked for
+        struct motor_watchdog watchdog = {.timeout_ms = MOTOR_WATCHDOG_MS};
+        if (ioctl(motor, PI_CMD_WATCHDOG_SET, &watchdog) != 0) {
+            perror("Motor watchdog unavailable");
+        }
+    }
+
+    // No SA_RESTART, so the signal also breaks the ranging thread out of its read
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    pthread_mutex_lock(&publish_lock);
+    publish_locked();
+    pthread_mutex_unlock(&publish_lock);
+
+    Ranging_t ranging = {.fd = sr04, .rate_hz = rate_hz};
+    pthread_t ranging_tid;
+    bool ranging_started = sr04 >= 0 && pthread_create(&ranging_tid, NULL, ranging_thread, &ranging) == 0;
+
+    while (!stop_requested) {
+        struct pollfd pfd = {.fd = ir, .events = POLLIN};
+        // poll() with a negative fd only sleeps, which paces the motor queries
+        int ready = poll(&pfd, 1, MOTOR_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        bool changed = false;
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            changed |= drain_ir(ir);
+        }
+        if (arbiter.bus != NULL && arbitrate(&arbiter, now_ns())) {
+            pthread_mutex_lock(&publish_lock);
+            current.owner_pid = arbiter.owner_pid;
+            current.owner_slot = arbiter.owner >= 0 ? (uint8_t)arbiter.owner : HUB_NO_OWNER;
+            current.owner_applied = arbiter.applied_seq;
+            pthread_mutex_unlock(&publish_lock);
+            changed = true;
+        }
+        if (motor >= 0) {
+            changed |= poll_motor(motor);
+        }
+        // Republish now and then, so readers can tell a quiet hub from a dead one
+        if (!changed) {
+            pthread_mutex_lock(&publish_lock);
+            changed = now_ns() - current.publish_ns >= HUB_HEARTBEAT_NS;
+            pthread_mutex_unlock(&publish_lock);
+        }
+        if (changed) {
+            pthread_mutex_lock(&publish_lock);
+            publish_locked();
+            pthread_mutex_unlock(&publish_lock);
+        }
+    }
+
+    if (ranging_started) {
+        stop_requested = 1;
+        pthread_kill(ranging_tid, SIGINT);
+        pthread_join(ranging_tid, NULL);
+    }
+    if (arbiter.bus != NULL) {
+        if (arbiter.owner >= 0) {
+            ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
+        }
+        __atomic_store_n(&arbiter.bus->hub_pid, 0, __ATOMIC_RELEASE);
+        munmap(arbiter.bus, sizeof(MotorBus_t));
+    }
+    // Readers fall back to the devices as soon as they see nothing is valid
+    pthread_mutex_lock(&publish_lock);
+    current.valid = 0;
+    current.owner_pid = 0;
+    current.owner_slot = HUB_NO_OWNER;
+    publish_locked();
+    pthread_mutex_unlock(&publish_lock);
+
+    printf("Sensor hub: %llu snapshots, %llu measurements (%llu without echo, %llu held off for a frame), "
+           "%llu IR records, %llu motor frames\n",
+           stats.snapshots, stats.measurements, stats.no_echo, stats.held_off, stats.ir_records,
+           stats.motor_frames);
+    printf("Motor bus: %llu setpoints applied, %llu handovers, %llu slots expired\n",
+           stats.setpoints, stats.handovers, stats.expired);
+    munmap(hub, sizeof(HubShm_t));
+    if (sr04 >= 0) {
+        close(sr04);
+    }
+    if (ir >= 0) {
+        close(ir);
+    }
+    if (motor >= 0) {
+        close(motor);
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Harness shared by the benchmarks under bench/. Each case is timed with
+ * CLOCK_MONOTONIC and, where available, a cycle counter, then reported as
+ * one record:
+ *   text  aligned columns for reading (default)
+ *   csv   suite,case,param,ops,ns_per_op,cycles_per_op,counter,arch,commit
+ *   json  one object per line with the same fields
+ * Select the format with --format=text|csv|json; --header adds the CSV
+ * header line. The commit field comes from $BENCH_COMMIT. Notes printed
+ * with bench_note go to stderr in the machine-readable formats, so stdout
+ * only carries records.
+ */
+
+typedef struct {
+    uint64_t ns;
+    uint64_t cycles;
+} bench_stamp_t;
+
+/*
+ * Parses the harness options and opens the cycle counter. Unknown
+ * arguments are an error so typos do not silently produce text output.
+ */
+void bench_init(int argc, char** argv, const char* suite);
+
+bench_stamp_t bench_start(void);
+
+/*
+ * Reports one case measured since start. param describes the
+ * configuration (network size, allocation size, ...) and may be NULL.
+ */
+void bench_stop(const char* name, const char* param, uint64_t ops, bench_stamp_t start);
+
+void bench_note(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+void bench_finish(void);
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Keeps the compiler from discarding a value computed only for timing
+static inline void bench_consume(const void* value) {
+    __asm__ __volatile__("" : : "r"(value) : "memory");
+}
+
+#endif // BENCH_H
@@ -0,0 +1,139 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "neuron.h"
+
+#define SYNAPSES_PER_NEURON 23   // C. elegans: ~7000 chemical synapses over 302 neurons
+#define WARMUP_STEPS 200
+#define TIMED_STEPS 2000
+#define CONTROL_BUDGET_NS 100000000ULL
+#define NEURAL_BUDGET_NS 5000000ULL      // the control task's execution hint
+#define SUBSTEP_PROBE 8
+
+static ttak_arena_t arena;
+static uint32_t lcg_state = 12345u;
+
+static uint32_t lcg_next(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+static float lcg_signed(float amplitude) {
+    return ((float)(lcg_next() & 0xffff) / 32767.5f - 1.0f) * amplitude;
+}
+
+/*
+ * Random graph with the built-in bindings' shape: three bound sensory
+ * neurons, two bound motor neurons, 30% inhibitory interneurons.
+ */
+static bool write_synthetic_connectome(const char* path, size_t neuron_total) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < neuron_total; ++i) {
+        const char* type = i < 3 ? "sensory" : i >= neuron_total - 2 ? "motor"
+                         : (lcg_next() % 10) < 3 ? "inhibitory" : "excitatory";
+        fprintf(file, "neuron,N%zu,%s\n", i, type);
+    }
+    size_t synapse_total = neuron_total * SYNAPSES_PER_NEURON;
+    if (synapse_total > MAX_SYNAPSES) {
+        synapse_total = MAX_SYNAPSES;
+    }
+    for (size_t i = 0; i < synapse_total; ++i) {
+        size_t from = lcg_next() % (neuron_total - 2);
+        size_t to = 3 + lcg_next() % (neuron_total - 3);
+        fprintf(file, "synapse,N%zu,N%zu,%.4f\n", from, to, (double)lcg_signed(0.5f));
+    }
+    fprintf(file, "bind,dist,N0\nbind,host_l,N1\nbind,host_r,N2\n");
+    fprintf(file, "bind,motor_l,N%zu\nbind,motor_r,N%zu\n", neuron_total - 2, neuron_total - 1);
+    return fclose(file) == 0;
+}
+
+// Returns the mean step time in ns
+static uint64_t time_steps(const char* name, unsigned substeps) {
+    float input[NUM_SENSOR_INPUTS];
+    float output[2];
+    NeuralNet_set_substeps(substeps);
+    for (int i = 0; i < WARMUP_STEPS; ++i) {
+        input[0] = input[1] = input[2] = sinf((float)i * 0.1f);
+        NeuralNet_step(input, output);
+    }
+
+    uint64_t worst_ns = 0;
+    bench_stamp_t start = bench_start();
+    for (int i = 0; i < TIMED_STEPS; ++i) {
+        input[0] = sinf((float)i * 0.1f);
+        input[1] = cosf((float)i * 0.07f);
+        input[2] = sinf((float)i * 0.03f);
+        uint64_t step_start = bench_now_ns();
+        NeuralNet_step(input, output);
+        uint64_t step_ns = bench_now_ns() - step_start;
+        if (step_ns > worst_ns) {
+            worst_ns = step_ns;
+        }
+        bench_consume(output);
+    }
+    uint64_t elapsed = bench_now_ns() - start.ns;
+
+    NeuralPlasticityStats_t stats;
+    NeuralNet_plasticity_stats(&stats);
+    char param[64];
+    snprintf(param, sizeof(param), "net=%s;synapses=%zu;K=%u", name, stats.synapses, substeps);
+    bench_stop("NeuralNet_step", param, TIMED_STEPS, start);
+    bench_note("%-44s worst %.1f us, %.4f%% of the %llu ms control budget\n", "", (double)worst_ns / 1000.0,
+               100.0 * (double)worst_ns / (double)CONTROL_BUDGET_NS,
+               (unsigned long long)(CONTROL_BUDGET_NS / 1000000ULL));
+    return elapsed / TIMED_STEPS;
+}
+
+/*
+ * Fits step time = fixed + K * hop from K=1 and K=SUBSTEP_PROBE and
+ * reports the largest K that fits the neural budget.
+ */
+static void report_substeps(const char* name) {
+    uint64_t single = time_steps(name, 1);
+    uint64_t probe = time_steps(name, SUBSTEP_PROBE);
+    double hop = probe > single ? (double)(probe - single) / (SUBSTEP_PROBE - 1) : (double)single;
+    double fixed = (double)single - hop;
+    if (fixed < 0.0) {
+        fixed = 0.0;
+    }
+    double achievable = ((double)NEURAL_BUDGET_NS - fixed) / hop;
+    bench_note("%-44s %.1f us per hop, K within %llu ms: %.0f (capped at %d)\n", "", hop / 1000.0,
+               (unsigned long long)(NEURAL_BUDGET_NS / 1000000ULL), achievable, NEURAL_MAX_SUBSTEPS);
+}
+
+int main(int argc, char** argv) {
+    static const size_t sizes[] = {160, 302, MAX_NEURONS};
+
+    bench_init(argc, argv, "connectome");
+    ttak_arena_init_growable(&arena, NULL, 0, 1u << 20);
+    NeuralNet_init(&arena);
+    report_substeps("builtin-80");
+
+    char path[] = "/tmp/connectome_bench.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "random-%zu", sizes[i]);
+        if (!write_synthetic_connectome(path, sizes[i]) || !NeuralNet_use_connectome(path, &arena)) {
+            unlink(path);
+            return 1;
+        }
+        report_substeps(name);
+    }
+    unlink(path);
+    ttak_arena_destroy(&arena);
+    bench_finish();
+    return 0;
+}
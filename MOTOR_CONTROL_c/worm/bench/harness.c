@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+
+#include "bench.h"
+
+#include <linux/perf_event.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef enum {
+    FORMAT_TEXT,
+    FORMAT_CSV,
+    FORMAT_JSON
+} BenchFormat_t;
+
+typedef enum {
+    COUNTER_NONE,
+    COUNTER_PERF,    // core cycles from the PMU, user space only
+    COUNTER_TSC,     // x86 reference cycles, constant rate
+    COUNTER_CNTVCT   // ARM generic timer ticks, constant rate
+} BenchCounter_t;
+
+static const char* const counter_names[] = {"none", "perf", "tsc", "cntvct"};
+
+static struct {
+    BenchFormat_t format;
+    BenchCounter_t counter;
+    int perf_fd;
+    FILE* out;
+    const char* suite;
+    const char* commit;
+} harness = {.perf_fd = -1};
+
+static const char* arch_name(void) {
+#if defined(__x86_64__)
+    return "x86_64";
+#elif defined(__i386__)
+    return "i386";
+#elif defined(__aarch64__)
+    return "aarch64";
+#elif defined(__arm__)
+    return "arm";
+#else
+    return "unknown";
+#endif
+}
+
+// Raspberry Pi kernels expose the PMU through perf; user space cannot read it directly
+static int open_perf_cycles(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static BenchCounter_t open_counter(void) {
+    if (getenv("BENCH_NO_PERF") == NULL) {
+        harness.perf_fd = open_perf_cycles();
+        if (harness.perf_fd >= 0) {
+            return COUNTER_PERF;
+        }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    return COUNTER_TSC;
+#elif defined(__aarch64__)
+    return COUNTER_CNTVCT;
+#else
+    return COUNTER_NONE;
+#endif
+}
+
+static uint64_t read_counter(void) {
+    switch (harness.counter) {
+        case COUNTER_PERF: {
+            uint64_t value = 0;
+            if (read(harness.perf_fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) {
+                return 0;
+            }
+            return value;
+        }
+        case COUNTER_TSC:
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        case COUNTER_CNTVCT: {
+#if defined(__aarch64__)
+            uint64_t value;
+            __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(value) : : "memory");
+            return value;
+#else
+            return 0;
+#endif
+        }
+        case COUNTER_NONE:
+            break;
+    }
+    return 0;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--format=text|csv|json] [--header]\n", program);
+    exit(2);
+}
+
+void bench_init(int argc, char** argv, const char* suite) {
+    bool header = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--format=text") == 0) {
+            harness.format = FORMAT_TEXT;
+        } else if (strcmp(argv[i], "--format=csv") == 0) {
+            harness.format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            harness.format = FORMAT_JSON;
+        } else if (strcmp(argv[i], "--header") == 0) {
+            header = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    harness.out = stdout;
+    if (harness.format != FORMAT_TEXT) {
+        // Records keep the original stdout; anything else the code under test prints goes to stderr
+        int records_fd = dup(STDOUT_FILENO);
+        FILE* records = records_fd >= 0 ? fdopen(records_fd, "w") : NULL;
+        if (records != NULL && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0) {
+            harness.out = records;
+        }
+    }
+    harness.suite = suite;
+    harness.commit = getenv("BENCH_COMMIT");
+    if (harness.commit == NULL || harness.commit[0] == '\0') {
+        harness.commit = "unknown";
+    }
+    harness.counter = open_counter();
+
+    if (harness.format == FORMAT_CSV && header) {
+        fputs("suite,case,param,ops,ns_per_op,cycles_per_op,counter,arch,commit\n", harness.out);
+    } else if (harness.format == FORMAT_TEXT) {
+        printf("# %s on %s, cycle counter: %s\n", suite, arch_name(), counter_names[harness.counter]);
+    }
+}
+
+bench_stamp_t bench_start(void) {
+    bench_stamp_t stamp;
+    stamp.cycles = read_counter();
+    stamp.ns = bench_now_ns();
+    return stamp;
+}
+
+// Names and params are plain ASCII; quote anything that would split a CSV field
+static void print_csv_field(const char* value) {
+    if (strpbrk(value, ",\"") == NULL) {
+        fputs(value, harness.out);
+        return;
+    }
+    fputc('"', harness.out);
+    for (const char* c = value; *c != '\0'; ++c) {
+        if (*c == '"') {
+            fputc('"', harness.out);
+        }
+        fputc(*c, harness.out);
+    }
+    fputc('"', harness.out);
+}
+
+static void print_json_string(const char* value) {
+    fputc('"', harness.out);
+    for (const char* c = value; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', harness.out);
+        }
+        fputc(*c, harness.out);
+    }
+    fputc('"', harness.out);
+}
+
+void bench_stop(const char* name, const char* param, uint64_t ops, bench_stamp_t start) {
+    uint64_t elapsed_ns = bench_now_ns() - start.ns;
+    uint64_t cycles = read_counter() - start.cycles;
+    bool have_cycles = harness.counter != COUNTER_NONE && ops > 0;
+    double ns_per_op = ops ? (double)elapsed_ns / (double)ops : 0.0;
+    double cycles_per_op = have_cycles ? (double)cycles / (double)ops : 0.0;
+    if (param == NULL) {
+        param = "";
+    }
+
+    switch (harness.format) {
+        case FORMAT_TEXT: {
+            char label[96];
+            if (param[0] != '\0') {
+                snprintf(label, sizeof(label), "%s [%s]", name, param);
+            } else {
+                snprintf(label, sizeof(label), "%s", name);
+            }
+            fprintf(harness.out, "%-44s %10llu ops %10.3f ms %10.1f ns/op", label, (unsigned long long)ops,
+                    (double)elapsed_ns / 1e6, ns_per_op);
+            if (have_cycles) {
+                fprintf(harness.out, " %10.1f %s/op", cycles_per_op,
+                        harness.counter == COUNTER_PERF ? "cycles" : counter_names[harness.counter]);
+            }
+            fputc('\n', harness.out);
+            break;
+        }
+        case FORMAT_CSV:
+            print_csv_field(harness.suite);
+            fputc(',', harness.out);
+            print_csv_field(name);
+            fputc(',', harness.out);
+            print_csv_field(param);
+            fprintf(harness.out, ",%llu,%.3f,", (unsigned long long)ops, ns_per_op);
+            if (have_cycles) {
+                fprintf(harness.out, "%.3f", cycles_per_op);
+            }
+            fprintf(harness.out, ",%s,%s,", counter_names[harness.counter], arch_name());
+            print_csv_field(harness.commit);
+            fputc('\n', harness.out);
+            break;
+        case FORMAT_JSON:
+            fputs("{\"suite\":", harness.out);
+            print_json_string(harness.suite);
+            fputs(",\"case\":", harness.out);
+            print_json_string(name);
+            fputs(",\"param\":", harness.out);
+            print_json_string(param);
+            fprintf(harness.out, ",\"ops\":%llu,\"ns_per_op\":%.3f,\"cycles_per_op\":",
+                    (unsigned long long)ops, ns_per_op);
+            if (have_cycles) {
+                fprintf(harness.out, "%.3f", cycles_per_op);
+            } else {
+                fputs("null", harness.out);
+            }
+            fprintf(harness.out, ",\"counter\":\"%s\",\"arch\":\"%s\",\"commit\":",
+                    counter_names[harness.counter], arch_name());
+            print_json_string(harness.commit);
+            fputs("}\n", harness.out);
+            break;
+    }
+    fflush(harness.out);
+}
+
+void bench_note(const char* format, ...) {
+    FILE* out = harness.format == FORMAT_TEXT ? stdout : stderr;
+    va_list args;
+    va_start(args, format);
+    vfprintf(out, format, args);
+    va_end(args);
+}
+
+void bench_finish(void) {
+    fflush(stdout);
+    if (harness.out != NULL && harness.out != stdout) {
+        fclose(harness.out);
+        harness.out = stdout;
+    }
+    if (harness.perf_fd >= 0) {
+        close(harness.perf_fd);
+        harness.perf_fd = -1;
+    }
+}
@@ -0,0 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "libttak/math/fx.h"
+#include "libttak/mem/arena.h"
+#include "libttak/sched.h"
+#include "neuron.h"
+
+#define FX_VALUES 4096                 // 16 KiB per operand array, stays in L1/L2
+#define FX_ROUNDS 2000
+#define ARENA_ALLOCS 4000000
+#define ARENA_FRAME_ALLOCS 256         // allocations between frame resets, like a control tick
+#define SCHED_CALLS 200000
+#define NEUROMOD_ROUNDS 2000000
+
+static uint32_t lcg_state = 12345u;
+
+static uint32_t lcg_next(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+// Activations and weights the network actually sees: roughly -2..2
+static ttak_fx_t random_fx(void) {
+    return (ttak_fx_t)(lcg_next() & 0x3ffff) - 0x20000;
+}
+
+static ttak_fx_t fx_a[FX_VALUES];
+static ttak_fx_t fx_b[FX_VALUES];
+
+typedef ttak_fx_t (*fx_binary_fn)(ttak_fx_t a, ttak_fx_t b);
+typedef ttak_fx_t (*fx_unary_fn)(ttak_fx_t x);
+
+static ttak_fx_t fx_mul(ttak_fx_t a, ttak_fx_t b) { return ttak_fx_mul(a, b); }
+static ttak_fx_t fx_div(ttak_fx_t a, ttak_fx_t b) { return ttak_fx_div(a, b | 1); }
+static ttak_fx_t fx_mix(ttak_fx_t a, ttak_fx_t b) { return ttak_fx_mix(a, b, TTAK_FX_ONE / 3); }
+static ttak_fx_t fx_sigmoid(ttak_fx_t x) { return ttak_fx_sigmoid(x); }
+static ttak_fx_t fx_swish(ttak_fx_t x) { return ttak_fx_swish(x); }
+
+/*
+ * The wrappers are static and called through a constant, so they inline
+ * into the loop; the accumulator keeps the results live.
+ */
+static inline __attribute__((always_inline)) void run_fx_binary(const char* name, fx_binary_fn fn) {
+    ttak_fx_t acc = 0;
+    bench_stamp_t start = bench_start();
+    for (int round = 0; round < FX_ROUNDS; ++round) {
+        for (int i = 0; i < FX_VALUES; ++i) {
+            acc += fn(fx_a[i], fx_b[i]);
+        }
+        bench_consume(&acc);
+    }
+    bench_stop(name, NULL, (uint64_t)FX_ROUNDS * FX_VALUES, start);
+}
+
+static inline __attribute__((always_inline)) void run_fx_unary(const char* name, fx_unary_fn fn) {
+    ttak_fx_t acc = 0;
+    bench_stamp_t start = bench_start();
+    for (int round = 0; round < FX_ROUNDS; ++round) {
+        for (int i = 0; i < FX_VALUES; ++i) {
+            acc += fn(fx_a[i]);
+        }
+        bench_consume(&acc);
+    }
+    bench_stop(name, NULL, (uint64_t)FX_ROUNDS * FX_VALUES, start);
+}
+
+static void bench_fx(void) {
+    for (int i = 0; i < FX_VALUES; ++i) {
+        fx_a[i] = random_fx();
+        fx_b[i] = random_fx();
+    }
+    run_fx_binary("ttak_fx_mul", fx_mul);
+    run_fx_binary("ttak_fx_div", fx_div);
+    run_fx_binary("ttak_fx_mix", fx_mix);
+    run_fx_unary("ttak_fx_sigmoid", fx_sigmoid);
+    run_fx_unary("ttak_fx_swish", fx_swish);
+}
+
+static void bench_neuromod(void) {
+    NeuroModulators_t levels = {{0}};
+    NeuroModDelta_t delta;
+    NeuroMod_delta_init(&delta);
+    NeuroMod_scale(&delta, NEUROMOD_SEROTONIN, TTAK_FX_CONST(0.99f));
+    NeuroMod_add(&delta, NEUROMOD_NOREPINEPHRINE, TTAK_FX_CONST(0.1f));
+    bench_stamp_t start = bench_start();
+    for (int i = 0; i < NEUROMOD_ROUNDS; ++i) {
+        NeuroMod_apply(&levels, &delta);
+        bench_consume(&levels);
+    }
+    bench_stop("NeuroMod_apply", NULL, NEUROMOD_ROUNDS, start);
+}
+
+// Per-tick scratch pattern: a run of small allocations, then a frame reset
+static void bench_arena(size_t size, bool zeroed) {
+    static uint8_t backing[ARENA_FRAME_ALLOCS * 1024];
+    ttak_arena_t arena;
+    ttak_arena_init(&arena, backing, sizeof(backing));
+
+    bench_stamp_t start = bench_start();
+    for (int i = 0; i < ARENA_ALLOCS; i += ARENA_FRAME_ALLOCS) {
+        ttak_arena_mark_t mark = ttak_arena_mark(&arena);
+        for (int j = 0; j < ARENA_FRAME_ALLOCS; ++j) {
+            void* ptr = zeroed ? ttak_arena_alloc(&arena, size, sizeof(void*))
+                               : ttak_arena_alloc_uninit(&arena, size, sizeof(void*));
+            bench_consume(ptr);
+        }
+        ttak_arena_restore(&arena, mark);
+    }
+    char param[32];
+    snprintf(param, sizeof(param), "size=%zu", size);
+    bench_stop(zeroed ? "ttak_arena_alloc" : "ttak_arena_alloc_uninit", param, ARENA_ALLOCS, start);
+}
+
+static void count_run(void* ctx) {
+    ++*(uint64_t*)ctx;
+}
+
+/*
+ * Dispatch cost of ttak_sched_run_once: with a zero interval every task is
+ * due on each call, so ops counts task runs. The idle case measures a call
+ * that finds nothing due.
+ */
+static void bench_sched(size_t task_count, bool idle) {
+    static ttak_task_t tasks[TTAK_SCHED_MAX_TASKS];
+    ttak_scheduler_t sched;
+    ttak_sched_init(&sched, tasks, TTAK_SCHED_MAX_TASKS);
+    uint64_t runs = 0;
+    for (size_t i = 0; i < task_count; ++i) {
+        ttak_sched_add_task(&sched, count_run, &runs, idle ? 1000000u : 0u, TTAK_CATCHUP_DRIFT);
+    }
+
+    bench_stamp_t start = bench_start();
+    for (int i = 0; i < SCHED_CALLS; ++i) {
+        ttak_sched_run_once(&sched);
+    }
+    char param[32];
+    snprintf(param, sizeof(param), "tasks=%zu", task_count);
+    bench_stop(idle ? "ttak_sched_run_once idle" : "ttak_sched_run_once per task", param,
+               idle ? SCHED_CALLS : runs, start);
+    ttak_sched_destroy(&sched);
+}
+
+int main(int argc, char** argv) {
+    static const size_t arena_sizes[] = {16, 64, 256, 1024};
+    static const size_t task_counts[] = {1, 8, TTAK_SCHED_MAX_TASKS};
+
+    bench_init(argc, argv, "libsoul");
+
+    bench_fx();
+    bench_neuromod();
+    for (size_t i = 0; i < sizeof(arena_sizes) / sizeof(arena_sizes[0]); ++i) {
+        bench_arena(arena_sizes[i], true);
+        bench_arena(arena_sizes[i], false);
+    }
+    bench_sched(TTAK_SCHED_MAX_TASKS, true);
+    for (size_t i = 0; i < sizeof(task_counts) / sizeof(task_counts[0]); ++i) {
+        bench_sched(task_counts[i], false);
+    }
+
+    bench_finish();
+    return 0;
+}
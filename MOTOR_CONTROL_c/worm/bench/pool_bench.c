@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "libttak/mem/arena.h"
+#include "libttak/mem/pool.h"
+#include "libttak/ring.h"
+
+#define OBJECT_SIZE 48
+#define BATCH 64
+#define ROUNDS 200000
+#define HANDOFF_OPS 2000000
+#define HANDOFF_RING_SLOTS 1024
+
+typedef struct {
+    uint8_t payload[OBJECT_SIZE];
+} Object_t;
+
+TTAK_OBJPOOL_DEFINE(object_pool, Object_t)
+
+static ttak_arena_t arena;
+
+// Allocate a batch, touch it, free it in reverse: the shape of per-tick temporaries
+static void bench_batch_malloc(void) {
+    Object_t* objects[BATCH];
+    bench_stamp_t start = bench_start();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < BATCH; ++i) {
+            objects[i] = (Object_t*)malloc(sizeof(Object_t));
+            objects[i]->payload[0] = (uint8_t)i;
+        }
+        for (int i = BATCH - 1; i >= 0; --i) {
+            free(objects[i]);
+        }
+    }
+    bench_stop("batch malloc/free", NULL, (uint64_t)ROUNDS * BATCH, start);
+}
+
+static void bench_batch_pool(bool concurrent) {
+    ttak_objpool_t pool;
+    object_pool_init(&pool, &arena, BATCH, concurrent);
+    Object_t* objects[BATCH];
+    bench_stamp_t start = bench_start();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < BATCH; ++i) {
+            objects[i] = object_pool_alloc(&pool);
+            objects[i]->payload[0] = (uint8_t)i;
+        }
+        for (int i = BATCH - 1; i >= 0; --i) {
+            object_pool_free(&pool, objects[i]);
+        }
+    }
+    bench_stop(concurrent ? "batch pool (concurrent)" : "batch pool", NULL, (uint64_t)ROUNDS * BATCH, start);
+}
+
+/*
+ * Cross-thread handoff: the producer allocates and passes pointers through
+ * an SPSC ring, the consumer frees them. This is the telemetry/packet path.
+ */
+typedef struct {
+    ttak_ring_t ring;
+    ttak_objpool_t* pool;   // NULL selects malloc/free
+    _Atomic bool done;
+} Handoff_t;
+
+static void* handoff_consumer(void* arg) {
+    Handoff_t* handoff = (Handoff_t*)arg;
+    uint64_t freed = 0;
+    while (freed < HANDOFF_OPS) {
+        Object_t* object;
+        if (!ttak_ring_pop(&handoff->ring, &object)) {
+            sched_yield();
+            continue;
+        }
+        bench_consume(object);
+        if (handoff->pool != NULL) {
+            object_pool_free(handoff->pool, object);
+        } else {
+            free(object);
+        }
+        ++freed;
+    }
+    return NULL;
+}
+
+static void bench_handoff(ttak_objpool_t* pool) {
+    static Object_t* ring_backing[HANDOFF_RING_SLOTS];
+    Handoff_t handoff = {.pool = pool};
+    ttak_ring_init(&handoff.ring, ring_backing, sizeof(Object_t*), HANDOFF_RING_SLOTS);
+
+    pthread_t consumer;
+    // Only the producer thread's cycles are counted
+    bench_stamp_t start = bench_start();
+    pthread_create(&consumer, NULL, handoff_consumer, &handoff);
+    for (uint64_t i = 0; i < HANDOFF_OPS; ++i) {
+        Object_t* object = NULL;
+        while (object == NULL) {
+            object = pool != NULL ? object_pool_alloc(pool) : (Object_t*)malloc(sizeof(Object_t));
+        }
+        object->payload[0] = (uint8_t)i;
+        while (!ttak_ring_push(&handoff.ring, &object)) {
+            sched_yield();
+        }
+    }
+    pthread_join(consumer, NULL);
+    bench_stop(pool != NULL ? "handoff pool (concurrent)" : "handoff malloc/free", NULL, HANDOFF_OPS, start);
+}
+
+int main(int argc, char** argv) {
+    bench_init(argc, argv, "pool");
+    ttak_arena_init_growable(&arena, NULL, 0, 1u << 20);
+
+    bench_batch_malloc();
+    bench_batch_pool(false);
+    bench_batch_pool(true);
+
+    bench_handoff(NULL);
+    ttak_objpool_t shared;
+    object_pool_init(&shared, &arena, HANDOFF_RING_SLOTS * 2, true);
+    bench_handoff(&shared);
+    bench_note("shared pool: peak %u of %u slots in use, %llu failed allocations\n",
+               ttak_objpool_peak(&shared), shared.capacity, (unsigned long long)ttak_objpool_failures(&shared));
+
+    ttak_arena_destroy(&arena);
+    bench_finish();
+    return 0;
+}
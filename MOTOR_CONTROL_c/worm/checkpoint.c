@@ -0,0 +1,195 @@
+#define _GNU_SOURCE
+
+#include "checkpoint.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "neuron.h"
+
+#define CHECKPOINT_PAGE_SIZE 4096u
+
+static bool pwrite_all(int fd, const uint8_t* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+        offset += written;
+    }
+    return true;
+}
+
+static bool pread_all(int fd, uint8_t* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t got = pread(fd, data, size, offset);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (got == 0) {
+            memset(data, 0, size);
+            return true;
+        }
+        data += got;
+        size -= (size_t)got;
+        offset += got;
+    }
+    return true;
+}
+
+void NeuralCheckpoint_restore(const char* base_path, ttak_arena_t* arena) {
+    char paths[CHECKPOINT_SLOTS + 1][CHECKPOINT_PATH_MAX];
+    uint64_t sequences[CHECKPOINT_SLOTS + 1];
+    bool present[CHECKPOINT_SLOTS + 1];
+
+    snprintf(paths[0], sizeof(paths[0]), "%s", base_path);
+    for (int slot = 0; slot < CHECKPOINT_SLOTS; ++slot) {
+        snprintf(paths[slot + 1], sizeof(paths[slot + 1]), "%s.%d", base_path, slot);
+    }
+    for (int i = 0; i <= CHECKPOINT_SLOTS; ++i) {
+        present[i] = NeuralNet_snapshot_sequence(paths[i], &sequences[i]);
+    }
+
+    // Newest first; a slot that fails validation falls through to the next one
+    for (;;) {
+        int best = -1;
+        for (int i = 0; i <= CHECKPOINT_SLOTS; ++i) {
+            if (present[i] && (best < 0 || sequences[i] > sequences[best])) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        if (NeuralNet_map(paths[best], arena)) {
+            return;
+        }
+        present[best] = false;
+    }
+
+    NeuralNet_load(base_path, arena);
+}
+
+bool NeuralCheckpoint_init(NeuralCheckpoint_t* checkpoint, const char* base_path, size_t page_budget) {
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    for (int slot = 0; slot < CHECKPOINT_SLOTS; ++slot) {
+        checkpoint->fds[slot] = -1;
+    }
+    checkpoint->image_size = NeuralNet_snapshot_size();
+    checkpoint->page_size = CHECKPOINT_PAGE_SIZE;
+    checkpoint->page_budget = page_budget > 1 ? page_budget : 2;
+
+    checkpoint->staging = (uint8_t*)malloc(checkpoint->image_size);
+    if (checkpoint->staging == NULL) {
+        NeuralCheckpoint_destroy(checkpoint);
+        return false;
+    }
+
+    for (int slot = 0; slot < CHECKPOINT_SLOTS; ++slot) {
+        snprintf(checkpoint->paths[slot], sizeof(checkpoint->paths[slot]), "%s.%d", base_path, slot);
+        if (!NeuralNet_snapshot_sequence(checkpoint->paths[slot], &checkpoint->slot_sequence[slot])) {
+            checkpoint->slot_sequence[slot] = 0;
+        }
+
+        // Never truncate: the live network may be a private mapping of this file
+        int fd = open(checkpoint->paths[slot], O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            perror("Failed to open checkpoint slot");
+            if (fd >= 0) {
+                close(fd);
+            }
+            NeuralCheckpoint_destroy(checkpoint);
+            return false;
+        }
+        checkpoint->fds[slot] = fd;
+        if ((size_t)st.st_size != checkpoint->image_size &&
+            ftruncate(fd, (off_t)checkpoint->image_size) != 0) {
+            perror("Failed to size checkpoint slot");
+            NeuralCheckpoint_destroy(checkpoint);
+            return false;
+        }
+
+        checkpoint->slot_images[slot] = (uint8_t*)malloc(checkpoint->image_size);
+        if (checkpoint->slot_images[slot] == NULL ||
+            !pread_all(fd, checkpoint->slot_images[slot], checkpoint->image_size, 0)) {
+            NeuralCheckpoint_destroy(checkpoint);
+            return false;
+        }
+    }
+
+    checkpoint->target_slot = checkpoint->slot_sequence[0] <= checkpoint->slot_sequence[1] ? 0 : 1;
+    return true;
+}
+
+bool NeuralCheckpoint_run_once(NeuralCheckpoint_t* checkpoint) {
+    if (!checkpoint->capture_valid) {
+        if (!NeuralNet_snapshot_capture(checkpoint->staging, checkpoint->image_size)) {
+            checkpoint->capture_failures++;
+            return false;
+        }
+        checkpoint->capture_valid = true;
+        checkpoint->cursor_page = 1; // header page goes last
+    }
+
+    const int slot = checkpoint->target_slot;
+    const int fd = checkpoint->fds[slot];
+    uint8_t* image = checkpoint->slot_images[slot];
+    const size_t page_size = checkpoint->page_size;
+    const size_t page_total = checkpoint->image_size / page_size;
+    size_t budget = checkpoint->page_budget;
+
+    while (checkpoint->cursor_page < page_total && budget > 0) {
+        size_t offset = checkpoint->cursor_page * page_size;
+        if (memcmp(checkpoint->staging + offset, image + offset, page_size) != 0) {
+            if (!pwrite_all(fd, checkpoint->staging + offset, page_size, (off_t)offset)) {
+                return false;
+            }
+            memcpy(image + offset, checkpoint->staging + offset, page_size);
+            checkpoint->pages_written++;
+            --budget;
+        }
+        checkpoint->cursor_page++;
+    }
+    if (checkpoint->cursor_page < page_total || budget == 0) {
+        return false;
+    }
+
+    if (fdatasync(fd) != 0 ||
+        !pwrite_all(fd, checkpoint->staging, page_size, 0) ||
+        fdatasync(fd) != 0) {
+        return false;
+    }
+    memcpy(image, checkpoint->staging, page_size);
+    checkpoint->pages_written++;
+    checkpoint->checkpoints_completed++;
+    checkpoint->capture_valid = false;
+    checkpoint->target_slot = 1 - slot;
+    return true;
+}
+
+void NeuralCheckpoint_destroy(NeuralCheckpoint_t* checkpoint) {
+    for (int slot = 0; slot < CHECKPOINT_SLOTS; ++slot) {
+        if (checkpoint->fds[slot] >= 0) {
+            close(checkpoint->fds[slot]);
+            checkpoint->fds[slot] = -1;
+        }
+        free(checkpoint->slot_images[slot]);
+        checkpoint->slot_images[slot] = NULL;
+    }
+    free(checkpoint->staging);
+    checkpoint->staging = NULL;
+}
@@ -0,0 +1,55 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libttak/mem/arena.h"
+
+#define CHECKPOINT_SLOTS 2
+#define CHECKPOINT_PATH_MAX 256
+
+/*
+ * Background checkpointer for learned weights.
+ *
+ * A consistent snapshot image is captured from the running network and
+ * written into one of two slot files (<base>.0 / <base>.1), alternating
+ * between them. Only pages that differ from what the slot already holds
+ * are written, at most page_budget pages per run. Data pages are
+ * synced before the header page, so a slot is either a complete snapshot
+ * or fails its checksum, and the other slot still holds the previous one.
+ */
+typedef struct {
+    char paths[CHECKPOINT_SLOTS][CHECKPOINT_PATH_MAX];
+    int fds[CHECKPOINT_SLOTS];
+    uint64_t slot_sequence[CHECKPOINT_SLOTS];
+    uint8_t* slot_images[CHECKPOINT_SLOTS];
+    uint8_t* staging;
+    size_t image_size;
+    size_t page_size;
+    size_t page_budget;
+    int target_slot;
+    size_t cursor_page;
+    bool capture_valid;
+    uint64_t checkpoints_completed;
+    uint64_t pages_written;
+    uint64_t capture_failures;
+} NeuralCheckpoint_t;
+
+/*
+ * Restores the newest valid snapshot among <base>, <base>.0 and <base>.1,
+ * falling back to NeuralNet_load(base) when none of them can be mapped.
+ */
+void NeuralCheckpoint_restore(const char* base_path, ttak_arena_t* arena);
+
+bool NeuralCheckpoint_init(NeuralCheckpoint_t* checkpoint, const char* base_path, size_t page_budget);
+
+/*
+ * Performs one interval worth of checkpoint work. Returns true when a slot was completed.
+ */
+bool NeuralCheckpoint_run_once(NeuralCheckpoint_t* checkpoint);
+
+void NeuralCheckpoint_destroy(NeuralCheckpoint_t* checkpoint);
+
+#endif // CHECKPOINT_H
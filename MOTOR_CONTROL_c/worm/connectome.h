@@ -0,0 +1,21 @@
+#ifndef CONNECTOME_H
+#define CONNECTOME_H
+
+#include <stdint.h>
+
+#include "neuron.h"
+#include "connectome_gen.h"
+
+/*
+ * Initial connectome, generated at build time by tools/gen_connectome.c
+ * into $(BUILD_DIR)/generated. The tables are const and stay in read-only
+ * memory; only connectome_initial_state is copied into the live network.
+ * Edges are sorted by presynaptic neuron.
+ */
+extern const SynapseEdge_t connectome_edges[CONNECTOME_SYNAPSES];
+extern const SynapseState_t connectome_initial_state[CONNECTOME_SYNAPSES];
+
+// Position of each sorted edge in the original generation order
+extern const uint16_t connectome_legacy_index[CONNECTOME_SYNAPSES];
+
+#endif // CONNECTOME_H
@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "hub.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+void HubLink_init(HubLink_t* link) {
+    memset(link, 0, sizeof(*link));
+    link->slot = -1;
+}
+
+static void try_map(HubLink_t* link) {
+    int fd = shm_open(HUB_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        return;
+    }
+    void* map = mmap(NULL, sizeof(HubShm_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    link->shm = (const HubShm_t*)map;
+}
+
+static bool read_snapshot(HubLink_t* link, uint64_t now_ns, HubSnapshot_t* snapshot) {
+    if (link->shm == NULL) {
+        if (now_ns < link->next_attempt_ns) {
+            return false;
+        }
+        link->next_attempt_ns = now_ns + HUB_RETRY_NS;
+        try_map(link);
+        if (link->shm == NULL) {
+            return false;
+        }
+    }
+    return hub_shm_read(link->shm, snapshot);
+}
+
+bool HubLink_distance(HubLink_t* link, uint64_t now_ns, uint32_t* distance_cm) {
+    HubSnapshot_t snapshot;
+    if (!read_snapshot(link, now_ns, &snapshot)) {
+        return false;
+    }
+    uint64_t age_ns = now_ns > snapshot.distance_ns ? now_ns - snapshot.distance_ns : 0;
+    if (!(snapshot.valid & HUB_HAVE_DISTANCE) || age_ns > HUB_MAX_DISTANCE_AGE_NS) {
+        link->stats.stale++;
+        return false;
+    }
+    *distance_cm = snapshot.distance_cm;
+    link->stats.fresh++;
+    link->stats.age_sum_ns += age_ns;
+    if (age_ns > link->stats.max_age_ns) {
+        link->stats.max_age_ns = age_ns;
+    }
+    return true;
+}
+
+bool HubLink_snapshot(HubLink_t* link, uint64_t now_ns, HubSnapshot_t* snapshot) {
+    if (!read_snapshot(link, now_ns, snapshot)) {
+        return false;
+    }
+    return now_ns <= snapshot->publish_ns || now_ns - snapshot->publish_ns <= HUB_MAX_SILENCE_NS;
+}
+
+bool HubLink_join_bus(HubLink_t* link, uint32_t priority, const char* name, uint64_t now_ns) {
+    HubSnapshot_t snapshot;
+    if (!HubLink_snapshot(link, now_ns, &snapshot)) {
+        return false;
+    }
+    int fd = shm_open(MOTOR_BUS_SHM_NAME, O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    void* map = mmap(NULL, sizeof(MotorBus_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    MotorBus_t* bus = (MotorBus_t*)map;
+    if (!motor_bus_valid(bus) || __atomic_load_n(&bus->hub_pid, __ATOMIC_RELAXED) == 0) {
+        munmap(map, sizeof(MotorBus_t));
+        return false;
+    }
+    link->bus = bus;
+    link->pid = (uint32_t)getpid();
+    link->priority = priority;
+    snprintf(link->name, sizeof(link->name), "%s", name);
+    link->slot = motor_bus_claim(bus, link->pid, priority, link->name, now_ns);
+    if (link->slot < 0) {
+        munmap(map, sizeof(MotorBus_t));
+        link->bus = NULL;
+        return false;
+    }
+    return true;
+}
+
+static bool ensure_slot(HubLink_t* link, uint64_t now_ns) {
+    if (link->bus == NULL) {
+        return false;
+    }
+    if (link->slot < 0 || !motor_bus_beat(link->bus, link->slot, link->pid, now_ns)) {
+        link->slot = motor_bus_claim(link->bus, link->pid, link->priority, link->name, now_ns);
+        if (link->slot < 0) {
+            return false;
+        }
+        link->stats.reclaims++;
+    }
+    return true;
+}
+
+bool HubLink_post(HubLink_t* link, const char frame[5], uint64_t now_ns) {
+    if (!ensure_slot(link, now_ns)) {
+        return false;
+    }
+    MotorSetpoint_t setpoint = {.seq = ++link->setpoint_seq};
+    if (setpoint.seq == 0) {
+        setpoint.seq = link->setpoint_seq = 1; // 0 means nothing posted yet
+    }
+    memcpy(setpoint.frame, frame, sizeof(setpoint.frame));
+    if (!motor_bus_post(link->bus, link->slot, link->pid, &setpoint, now_ns)) {
+        link->slot = -1;
+        return false;
+    }
+    link->stats.posted++;
+    HubSnapshot_t snapshot;
+    bool owner = HubLink_snapshot(link, now_ns, &snapshot) && snapshot.owner_pid == link->pid;
+    if (owner) {
+        link->stats.owned++;
+    }
+    return owner;
+}
+
+void HubLink_beat(HubLink_t* link, uint64_t now_ns) {
+    ensure_slot(link, now_ns);
+}
+
+void HubLink_stats(const HubLink_t* link, HubLinkStats_t* stats) {
+    *stats = link->stats;
+}
+
+void HubLink_close(HubLink_t* link) {
+    if (link->bus != NULL) {
+        if (link->slot >= 0) {
+            motor_bus_release(link->bus, link->slot, link->pid);
+            link->slot = -1;
+        }
+        munmap(link->bus, sizeof(MotorBus_t));
+        link->bus = NULL;
+    }
+    if (link->shm != NULL) {
+        munmap((void*)link->shm, sizeof(HubShm_t));
+        link->shm = NULL;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef HUB_H
+#define HUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../common/hub/motor_bus.h"
+#include "../../common/hub/sensor_hub.h"
+
+// A distance older than this at the tick is no longer trusted
+#define HUB_MAX_DISTANCE_AGE_NS 250000000ull
+// How often a missing hub block is looked for again
+#define HUB_RETRY_NS 1000000000ull
+// A snapshot older than this means the hub is gone
+#define HUB_MAX_SILENCE_NS (4 * HUB_HEARTBEAT_NS)
+
+typedef struct {
+    uint64_t fresh;           // ticks whose distance came from the hub
+    uint64_t stale;           // ticks that found the hub but not a recent distance
+    uint64_t age_sum_ns;      // measurement-to-neuron latency of the fresh distances
+    uint64_t max_age_ns;
+    uint64_t posted;          // setpoints put on the motor bus
+    uint64_t owned;           // of those, posted while the hub named us owner
+    uint64_t reclaims;        // slots taken again after the hub expired ours
+} HubLinkStats_t;
+
+/*
+ * Read side of the sensor_hub daemon's snapshot block. Like the vision
+ * link it maps lazily, so the worm reads the devices itself until a hub
+ * shows up and again whenever the hub stops measuring.
+ *
+ * A controller that joins the motor bus drives through the hub instead of
+ * opening /dev/motor, so another controller can take over without anyone
+ * reopening a device.
+ */
+typedef struct {
+    const HubShm_t* shm;
+    uint64_t next_attempt_ns;
+    MotorBus_t* bus;
+    int slot;                 // -1 while not on the bus
+    uint32_t pid;
+    uint32_t priority;
+    char name[MOTOR_BUS_NAME_LEN];
+    uint32_t setpoint_seq;
+    HubLinkStats_t stats;
+} HubLink_t;
+
+void HubLink_init(HubLink_t* link);
+
+/*
+ * Fetches the hub's distance if it was measured at most
+ * HUB_MAX_DISTANCE_AGE_NS before now_ns (CLOCK_MONOTONIC). Never blocks.
+ */
+bool HubLink_distance(HubLink_t* link, uint64_t now_ns, uint32_t* distance_cm);
+
+// Latest snapshot, or false when there is no hub or it has gone quiet
+bool HubLink_snapshot(HubLink_t* link, uint64_t now_ns, HubSnapshot_t* snapshot);
+
+/*
+ * Claims a motor bus slot. Fails when no hub is driving the motors or
+ * every slot is taken.
+ */
+bool HubLink_join_bus(HubLink_t* link, uint32_t priority, const char* name, uint64_t now_ns);
+
+/*
+ * Posts a struct ioctl_info frame for the hub to apply and beats the
+ * heartbeat. Returns true if the last snapshot named this process owner;
+ * a controller that was outbid keeps posting and takes over again once
+ * the other one leaves.
+ */
+bool HubLink_post(HubLink_t* link, const char frame[5], uint64_t now_ns);
+
+// Keeps the slot while a controller has nothing new to post
+void HubLink_beat(HubLink_t* link, uint64_t now_ns);
+
+void HubLink_stats(const HubLink_t* link, HubLinkStats_t* stats);
+void HubLink_close(HubLink_t* link);
+
+#endif // HUB_H
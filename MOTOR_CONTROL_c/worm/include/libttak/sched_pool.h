@@ -0,0 +1,3 @@
+#pragma once
+
+#include "../../libsoul/sched_pool.h"
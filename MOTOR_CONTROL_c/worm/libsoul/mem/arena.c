@@ -1,29 +1,172 @@
+#define _DEFAULT_SOURCE
+
 #include "arena.h"
 
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-void ttak_arena_init(ttak_arena_t* arena, void* backing, size_t capacity) {
-    arena->base = (uint8_t*)backing;
-    arena->capacity = capacity;
-    arena->offset = 0;
-}
+#define ARENA_BLOCK_HEADER_ALIGN 64
+
+struct ttak_arena_block {
+    ttak_arena_block_t* prev;
+    size_t map_size;
+};
 
 static size_t align_offset(size_t offset, size_t alignment) {
     size_t mask = alignment - 1;
     return (offset + mask) & ~mask;
 }
 
-void* ttak_arena_alloc(ttak_arena_t* arena, size_t size, size_t alignment) {
-    size_t aligned_offset = align_offset(arena->offset, alignment);
+static size_t block_header_size(void) {
+    return align_offset(sizeof(ttak_arena_block_t), ARENA_BLOCK_HEADER_ALIGN);
+}
+
+static void enter_block(ttak_arena_t* arena, ttak_arena_block_t* block) {
+    if (block == NULL) {
+        arena->base = arena->initial_base;
+        arena->capacity = arena->initial_capacity;
+    } else {
+        arena->base = (uint8_t*)block + block_header_size();
+        arena->capacity = block->map_size - block_header_size();
+    }
+}
+
+static void release_block(ttak_arena_t* arena, ttak_arena_block_t* block) {
+    // Keep the larger block as a spare so a per-tick frame that crosses a block boundary does not mmap every tick
+    ttak_arena_block_t* evicted = block;
+    if (arena->spare == NULL || block->map_size > arena->spare->map_size) {
+        evicted = arena->spare;
+        arena->spare = block;
+    }
+    if (evicted != NULL) {
+        arena->block_count--;
+        arena->mapped_bytes -= evicted->map_size;
+        munmap(evicted, evicted->map_size);
+    }
+}
+
+static bool grow(ttak_arena_t* arena, size_t size, size_t alignment) {
+    if (arena->block_size == 0) {
+        return false;
+    }
+    size_t need = block_header_size() + size + alignment;
+    ttak_arena_block_t* block = NULL;
+    if (arena->spare != NULL && arena->spare->map_size >= need) {
+        block = arena->spare;
+        arena->spare = NULL;
+    } else {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t map_size = align_offset(need > arena->block_size ? need : arena->block_size, page);
+        void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        block = (ttak_arena_block_t*)map;
+        block->map_size = map_size;
+        arena->block_count++;
+        arena->mapped_bytes += map_size;
+    }
+
+    // The unused tail of the current block stays counted until it is released
+    arena->used_before += arena->capacity;
+    block->prev = arena->blocks;
+    arena->blocks = block;
+    enter_block(arena, block);
+    arena->offset = 0;
+    return true;
+}
+
+void ttak_arena_init_growable(ttak_arena_t* arena, void* backing, size_t capacity, size_t block_size) {
+    memset(arena, 0, sizeof(*arena));
+    arena->initial_base = (uint8_t*)backing;
+    arena->initial_capacity = backing != NULL ? capacity : 0;
+    arena->block_size = block_size;
+    enter_block(arena, NULL);
+}
+
+void ttak_arena_init(ttak_arena_t* arena, void* backing, size_t capacity) {
+    ttak_arena_init_growable(arena, backing, capacity, 0);
+}
+
+// Aligns the address rather than the offset, so caller buffers need not be aligned themselves
+static size_t aligned_offset_in(const ttak_arena_t* arena, size_t alignment) {
+    uintptr_t base = (uintptr_t)arena->base;
+    return align_offset((size_t)(base + arena->offset), alignment) - (size_t)base;
+}
+
+void* ttak_arena_alloc_uninit(ttak_arena_t* arena, size_t size, size_t alignment) {
+    size_t aligned_offset = aligned_offset_in(arena, alignment);
     if (aligned_offset + size > arena->capacity) {
-        return NULL;
+        if (!grow(arena, size, alignment)) {
+            return NULL;
+        }
+        aligned_offset = aligned_offset_in(arena, alignment);
     }
     void* ptr = arena->base + aligned_offset;
-    memset(ptr, 0, size);
     arena->offset = aligned_offset + size;
+    size_t used = arena->used_before + arena->offset;
+    if (used > arena->high_watermark) {
+        arena->high_watermark = used;
+    }
+    return ptr;
+}
+
+void* ttak_arena_alloc(ttak_arena_t* arena, size_t size, size_t alignment) {
+    void* ptr = ttak_arena_alloc_uninit(arena, size, alignment);
+    if (ptr != NULL) {
+        memset(ptr, 0, size);
+    }
     return ptr;
 }
 
+ttak_arena_mark_t ttak_arena_mark(const ttak_arena_t* arena) {
+    ttak_arena_mark_t mark = {
+        .block = arena->blocks,
+        .offset = arena->offset,
+        .used_before = arena->used_before,
+    };
+    return mark;
+}
+
+void ttak_arena_restore(ttak_arena_t* arena, ttak_arena_mark_t mark) {
+    while (arena->blocks != NULL && arena->blocks != mark.block) {
+        ttak_arena_block_t* block = arena->blocks;
+        arena->blocks = block->prev;
+        release_block(arena, block);
+    }
+    enter_block(arena, arena->blocks);
+    arena->offset = mark.offset;
+    arena->used_before = mark.used_before;
+}
+
 void ttak_arena_reset(ttak_arena_t* arena) {
-    arena->offset = 0;
+    const ttak_arena_mark_t start = {0};
+    ttak_arena_restore(arena, start);
+}
+
+void ttak_arena_destroy(ttak_arena_t* arena) {
+    ttak_arena_reset(arena);
+    if (arena->spare != NULL) {
+        arena->block_count--;
+        arena->mapped_bytes -= arena->spare->map_size;
+        munmap(arena->spare, arena->spare->map_size);
+        arena->spare = NULL;
+    }
+}
+
+size_t ttak_arena_used(const ttak_arena_t* arena) {
+    return arena->used_before + arena->offset;
+}
+
+ttak_arena_frame_t ttak_arena_frame_begin(ttak_arena_t* arena) {
+    ttak_arena_frame_t frame = {
+        .arena = arena,
+        .mark = ttak_arena_mark(arena),
+    };
+    return frame;
+}
+
+void ttak_arena_frame_end(ttak_arena_frame_t* frame) {
+    ttak_arena_restore(frame->arena, frame->mark);
 }
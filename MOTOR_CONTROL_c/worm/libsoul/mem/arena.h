@@ -1,17 +1,95 @@
 #ifndef LIBTTAK_MEM_ARENA_H
 #define LIBTTAK_MEM_ARENA_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+typedef struct ttak_arena_block ttak_arena_block_t;
+
+/*
+ * Bump allocator over a caller-provided buffer. A growable arena chains
+ * mmap'd blocks (at least block_size bytes each) once the buffer is full;
+ * allocations never move, so pointers stay valid until reset/restore.
+ * Not thread-safe: each arena has a single owner.
+ */
 typedef struct {
     uint8_t* base;
     size_t capacity;
     size_t offset;
+
+    uint8_t* initial_base;
+    size_t initial_capacity;
+    ttak_arena_block_t* blocks;   // grown blocks, newest first
+    ttak_arena_block_t* spare;    // last released block, reused before mapping a new one
+    size_t block_size;            // 0 disables growth
+    size_t used_before;           // bytes consumed by the blocks behind the current one
+
+    size_t high_watermark;
+    size_t block_count;
+    size_t mapped_bytes;
 } ttak_arena_t;
 
+typedef struct {
+    ttak_arena_block_t* block;
+    size_t offset;
+    size_t used_before;
+} ttak_arena_mark_t;
+
 void ttak_arena_init(ttak_arena_t* arena, void* backing, size_t capacity);
+
+/*
+ * backing may be NULL with capacity 0, in which case every allocation
+ * comes from mmap'd blocks.
+ */
+void ttak_arena_init_growable(ttak_arena_t* arena, void* backing, size_t capacity, size_t block_size);
+
+/*
+ * Returns zeroed memory, or NULL when the arena is full and cannot grow.
+ */
 void* ttak_arena_alloc(ttak_arena_t* arena, size_t size, size_t alignment);
+
+/*
+ * Same as ttak_arena_alloc without the memset, for buffers the caller
+ * overwrites completely.
+ */
+void* ttak_arena_alloc_uninit(ttak_arena_t* arena, size_t size, size_t alignment);
+
+/*
+ * Markers: everything allocated after ttak_arena_mark is released by
+ * ttak_arena_restore, including blocks grown in between.
+ */
+ttak_arena_mark_t ttak_arena_mark(const ttak_arena_t* arena);
+void ttak_arena_restore(ttak_arena_t* arena, ttak_arena_mark_t mark);
+
 void ttak_arena_reset(ttak_arena_t* arena);
 
+/*
+ * Unmaps every grown block. The caller-provided buffer is left alone.
+ */
+void ttak_arena_destroy(ttak_arena_t* arena);
+
+/*
+ * Bytes currently allocated, counting alignment padding and block tails.
+ */
+size_t ttak_arena_used(const ttak_arena_t* arena);
+
+typedef struct {
+    ttak_arena_t* arena;
+    ttak_arena_mark_t mark;
+} ttak_arena_frame_t;
+
+ttak_arena_frame_t ttak_arena_frame_begin(ttak_arena_t* arena);
+void ttak_arena_frame_end(ttak_arena_frame_t* frame);
+
+/*
+ * Scoped scratch frame: allocations made after this line are released when
+ * the enclosing block exits, including through return or break.
+ *
+ *     TTAK_ARENA_FRAME(scratch, &arena);
+ *     float* tmp = ttak_arena_alloc_uninit(&arena, n * sizeof(float), sizeof(float));
+ */
+#define TTAK_ARENA_FRAME(name, arena_ptr) \
+    ttak_arena_frame_t name __attribute__((cleanup(ttak_arena_frame_end))) = ttak_arena_frame_begin(arena_ptr)
+
 #endif // LIBTTAK_MEM_ARENA_H
@@ -0,0 +1,139 @@
+#include "pool.h"
+
+#define POOL_EMPTY UINT32_MAX
+
+static uint64_t pack_head(uint32_t tag, uint32_t index) {
+    return ((uint64_t)tag << 32) | index;
+}
+
+static uint32_t head_index(uint64_t head) {
+    return (uint32_t)head;
+}
+
+static uint32_t head_tag(uint64_t head) {
+    return (uint32_t)(head >> 32);
+}
+
+// The plain variant has a single owner, so its counters avoid read-modify-write instructions
+static void count_delta(ttak_objpool_t* pool, int32_t delta) {
+    uint32_t in_use;
+    if (pool->concurrent) {
+        in_use = atomic_fetch_add_explicit(&pool->in_use, (uint32_t)delta, memory_order_relaxed) + (uint32_t)delta;
+    } else {
+        in_use = atomic_load_explicit(&pool->in_use, memory_order_relaxed) + (uint32_t)delta;
+        atomic_store_explicit(&pool->in_use, in_use, memory_order_relaxed);
+    }
+    if (delta < 0) {
+        return;
+    }
+    uint32_t peak = atomic_load_explicit(&pool->peak_in_use, memory_order_relaxed);
+    if (!pool->concurrent) {
+        if (in_use > peak) {
+            atomic_store_explicit(&pool->peak_in_use, in_use, memory_order_relaxed);
+        }
+        return;
+    }
+    while (in_use > peak &&
+           !atomic_compare_exchange_weak_explicit(&pool->peak_in_use, &peak, in_use,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static void count_failure(ttak_objpool_t* pool) {
+    if (pool->concurrent) {
+        atomic_fetch_add_explicit(&pool->alloc_failures, 1, memory_order_relaxed);
+    } else {
+        uint64_t failures = atomic_load_explicit(&pool->alloc_failures, memory_order_relaxed);
+        atomic_store_explicit(&pool->alloc_failures, failures + 1, memory_order_relaxed);
+    }
+}
+
+bool ttak_objpool_init(ttak_objpool_t* pool, ttak_arena_t* arena, size_t object_size,
+                       uint32_t capacity, bool concurrent) {
+    if (object_size == 0 || capacity == 0 || capacity == POOL_EMPTY) {
+        return false;
+    }
+    size_t slot_size = (object_size + TTAK_OBJPOOL_ALIGN - 1) & ~(size_t)(TTAK_OBJPOOL_ALIGN - 1);
+    uint8_t* slots = (uint8_t*)ttak_arena_alloc_uninit(arena, slot_size * capacity, TTAK_OBJPOOL_ALIGN);
+    _Atomic uint32_t* next = (_Atomic uint32_t*)ttak_arena_alloc_uninit(arena, sizeof(*next) * capacity,
+                                                                         sizeof(*next));
+    if (slots == NULL || next == NULL) {
+        return false;
+    }
+
+    pool->slots = slots;
+    pool->slot_size = slot_size;
+    pool->capacity = capacity;
+    pool->concurrent = concurrent;
+    pool->next = next;
+    for (uint32_t i = 0; i < capacity; ++i) {
+        atomic_init(&next[i], i + 1 < capacity ? i + 1 : POOL_EMPTY);
+    }
+    atomic_init(&pool->head, pack_head(0, 0));
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->peak_in_use, 0);
+    atomic_init(&pool->alloc_failures, 0);
+    return true;
+}
+
+void* ttak_objpool_alloc(ttak_objpool_t* pool) {
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_acquire);
+    uint32_t index;
+    if (pool->concurrent) {
+        for (;;) {
+            index = head_index(head);
+            if (index == POOL_EMPTY) {
+                break;
+            }
+            // A stale next is harmless: the tag makes the CAS fail if the slot was recycled meanwhile
+            uint32_t next = atomic_load_explicit(&pool->next[index], memory_order_relaxed);
+            if (atomic_compare_exchange_weak_explicit(&pool->head, &head, pack_head(head_tag(head) + 1, next),
+                                                      memory_order_acquire, memory_order_acquire)) {
+                break;
+            }
+        }
+    } else {
+        index = head_index(head);
+        if (index != POOL_EMPTY) {
+            uint32_t next = atomic_load_explicit(&pool->next[index], memory_order_relaxed);
+            atomic_store_explicit(&pool->head, pack_head(0, next), memory_order_relaxed);
+        }
+    }
+
+    if (index == POOL_EMPTY) {
+        count_failure(pool);
+        return NULL;
+    }
+    count_delta(pool, 1);
+    return pool->slots + (size_t)index * pool->slot_size;
+}
+
+void ttak_objpool_free(ttak_objpool_t* pool, void* object) {
+    if (object == NULL) {
+        return;
+    }
+    uint32_t index = (uint32_t)(((uint8_t*)object - pool->slots) / pool->slot_size);
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    if (pool->concurrent) {
+        do {
+            atomic_store_explicit(&pool->next[index], head_index(head), memory_order_relaxed);
+        } while (!atomic_compare_exchange_weak_explicit(&pool->head, &head, pack_head(head_tag(head) + 1, index),
+                                                        memory_order_release, memory_order_relaxed));
+    } else {
+        atomic_store_explicit(&pool->next[index], head_index(head), memory_order_relaxed);
+        atomic_store_explicit(&pool->head, pack_head(0, index), memory_order_relaxed);
+    }
+    count_delta(pool, -1);
+}
+
+uint32_t ttak_objpool_in_use(const ttak_objpool_t* pool) {
+    return atomic_load_explicit(&pool->in_use, memory_order_relaxed);
+}
+
+uint32_t ttak_objpool_peak(const ttak_objpool_t* pool) {
+    return atomic_load_explicit(&pool->peak_in_use, memory_order_relaxed);
+}
+
+uint64_t ttak_objpool_failures(const ttak_objpool_t* pool) {
+    return atomic_load_explicit(&pool->alloc_failures, memory_order_relaxed);
+}
@@ -0,0 +1,63 @@
+#ifndef LIBTTAK_MEM_POOL_H
+#define LIBTTAK_MEM_POOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+#define TTAK_OBJPOOL_ALIGN 64
+
+/*
+ * Fixed-size object pool carved out of an arena. Every slot starts on its
+ * own cache line, and free slots are linked through a side array of
+ * indices, so objects are never written by the pool.
+ *
+ * The concurrent variant is a Treiber stack whose head packs a 32-bit ABA
+ * tag with the slot index, so any thread may alloc or free. The plain
+ * variant must stay on one thread and skips the compare-and-swap.
+ */
+typedef struct {
+    uint8_t* slots;
+    size_t slot_size;
+    uint32_t capacity;
+    bool concurrent;
+    _Atomic uint32_t* next;
+    _Alignas(TTAK_OBJPOOL_ALIGN) _Atomic uint64_t head;
+    _Alignas(TTAK_OBJPOOL_ALIGN) _Atomic uint32_t in_use;
+    _Atomic uint32_t peak_in_use;
+    _Atomic uint64_t alloc_failures;
+} ttak_objpool_t;
+
+bool ttak_objpool_init(ttak_objpool_t* pool, ttak_arena_t* arena, size_t object_size,
+                       uint32_t capacity, bool concurrent);
+
+/*
+ * Returns an uninitialised object, or NULL when every slot is taken.
+ */
+void* ttak_objpool_alloc(ttak_objpool_t* pool);
+void ttak_objpool_free(ttak_objpool_t* pool, void* object);
+
+uint32_t ttak_objpool_in_use(const ttak_objpool_t* pool);
+uint32_t ttak_objpool_peak(const ttak_objpool_t* pool);
+uint64_t ttak_objpool_failures(const ttak_objpool_t* pool);
+
+/*
+ * Typed wrappers: TTAK_OBJPOOL_DEFINE(packet_pool, Packet_t) defines
+ * packet_pool_init/alloc/free working on Packet_t pointers.
+ */
+#define TTAK_OBJPOOL_DEFINE(name, type)                                                        \
+    static inline bool name##_init(ttak_objpool_t* pool, ttak_arena_t* arena, uint32_t capacity, \
+                                   bool concurrent) {                                         \
+        return ttak_objpool_init(pool, arena, sizeof(type), capacity, concurrent);            \
+    }                                                                                          \
+    static inline type* name##_alloc(ttak_objpool_t* pool) {                                   \
+        return (type*)ttak_objpool_alloc(pool);                                                \
+    }                                                                                          \
+    static inline void name##_free(ttak_objpool_t* pool, type* object) {                       \
+        ttak_objpool_free(pool, object);                                                       \
+    }
+
+#endif // LIBTTAK_MEM_POOL_H
@@ -0,0 +1,49 @@
+#include "ring.h"
+
+#include <string.h>
+
+bool ttak_ring_init(ttak_ring_t* ring, void* backing, size_t slot_size, size_t slot_count) {
+    if (backing == NULL || slot_size == 0 || slot_count == 0 || (slot_count & (slot_count - 1)) != 0) {
+        return false;
+    }
+    ring->slots = (uint8_t*)backing;
+    ring->slot_size = slot_size;
+    ring->mask = slot_count - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    return true;
+}
+
+bool ttak_ring_push(ttak_ring_t* ring, const void* record) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    memcpy(ring->slots + (head & ring->mask) * ring->slot_size, record, ring->slot_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool ttak_ring_pop(ttak_ring_t* ring, void* record) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    memcpy(record, ring->slots + (tail & ring->mask) * ring->slot_size, ring->slot_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+size_t ttak_ring_size(const ttak_ring_t* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+uint64_t ttak_ring_dropped(const ttak_ring_t* ring) {
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
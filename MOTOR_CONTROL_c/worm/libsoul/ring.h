@@ -0,0 +1,34 @@
+#ifndef LIBTTAK_RING_H
+#define LIBTTAK_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TTAK_CACHE_LINE 64
+
+/*
+ * Lock-free single-producer/single-consumer ring of fixed-size records.
+ * The producer only touches head, the consumer only touches tail, so
+ * pushing a record costs one memcpy and a release store.
+ */
+typedef struct {
+    uint8_t* slots;
+    size_t slot_size;
+    size_t mask;
+    _Alignas(TTAK_CACHE_LINE) _Atomic size_t head;
+    _Alignas(TTAK_CACHE_LINE) _Atomic size_t tail;
+    _Atomic uint64_t dropped;
+} ttak_ring_t;
+
+/*
+ * slot_count must be a power of two; backing must hold slot_size * slot_count bytes.
+ */
+bool ttak_ring_init(ttak_ring_t* ring, void* backing, size_t slot_size, size_t slot_count);
+bool ttak_ring_push(ttak_ring_t* ring, const void* record);
+bool ttak_ring_pop(ttak_ring_t* ring, void* record);
+size_t ttak_ring_size(const ttak_ring_t* ring);
+uint64_t ttak_ring_dropped(const ttak_ring_t* ring);
+
+#endif // LIBTTAK_RING_H
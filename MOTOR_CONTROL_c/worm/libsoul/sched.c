@@ -2,24 +2,36 @@
 
 #include "sched.h"
 
+#include <errno.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
+#define EVENT_TAG_TIMER UINT64_MAX
+#define EVENT_TAG_WAKE (UINT64_MAX - 1)
+
 static struct timespec now_monotonic(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     return ts;
 }
 
-static struct timespec timespec_add_us(struct timespec ts, uint32_t us) {
-    ts.tv_nsec += us * 1000ULL;
-    while (ts.tv_nsec >= 1000000000L) {
+static struct timespec timespec_add_ns(struct timespec ts, uint64_t ns) {
+    ts.tv_sec += (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec += (long)(ns % 1000000000ULL);
+    if (ts.tv_nsec >= 1000000000L) {
         ts.tv_sec += 1;
         ts.tv_nsec -= 1000000000L;
     }
     return ts;
 }
 
+static struct timespec timespec_add_us(struct timespec ts, uint32_t us) {
+    return timespec_add_ns(ts, (uint64_t)us * 1000ULL);
+}
+
 static bool timespec_greater(const struct timespec* a, const struct timespec* b) {
     if (a->tv_sec == b->tv_sec) {
         return a->tv_nsec > b->tv_nsec;
@@ -27,45 +39,298 @@ static bool timespec_greater(const struct timespec* a, const struct timespec* b)
     return a->tv_sec > b->tv_sec;
 }
 
+static int64_t timespec_diff_ns(const struct timespec* a, const struct timespec* b) {
+    return ((int64_t)a->tv_sec - (int64_t)b->tv_sec) * 1000000000LL +
+           ((int64_t)a->tv_nsec - (int64_t)b->tv_nsec);
+}
+
+static bool heap_less(const ttak_scheduler_t* sched, size_t a, size_t b) {
+    return timespec_greater(&sched->tasks[sched->heap[b]].next_run,
+                            &sched->tasks[sched->heap[a]].next_run);
+}
+
+static void heap_swap(ttak_scheduler_t* sched, size_t a, size_t b) {
+    uint16_t tmp = sched->heap[a];
+    sched->heap[a] = sched->heap[b];
+    sched->heap[b] = tmp;
+}
+
+static void heap_push(ttak_scheduler_t* sched, uint16_t task_index) {
+    size_t pos = sched->heap_size++;
+    sched->heap[pos] = task_index;
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!heap_less(sched, pos, parent)) {
+            break;
+        }
+        heap_swap(sched, pos, parent);
+        pos = parent;
+    }
+}
+
+static uint16_t heap_pop(ttak_scheduler_t* sched) {
+    uint16_t top = sched->heap[0];
+    sched->heap[0] = sched->heap[--sched->heap_size];
+    size_t pos = 0;
+    for (;;) {
+        size_t left = pos * 2 + 1;
+        size_t right = left + 1;
+        size_t smallest = pos;
+        if (left < sched->heap_size && heap_less(sched, left, smallest)) {
+            smallest = left;
+        }
+        if (right < sched->heap_size && heap_less(sched, right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            break;
+        }
+        heap_swap(sched, pos, smallest);
+        pos = smallest;
+    }
+    return top;
+}
+
+static void reschedule(ttak_task_t* task, const struct timespec* started, const struct timespec* finished) {
+    const uint64_t interval_ns = (uint64_t)task->interval_us * 1000ULL;
+    int64_t lateness = timespec_diff_ns(started, &task->next_run);
+    if (lateness < 0) {
+        lateness = 0;
+    }
+
+    uint64_t exec_ns = (uint64_t)timespec_diff_ns(finished, started);
+
+    task->stats.runs++;
+    task->stats.total_lateness_ns += (uint64_t)lateness;
+    if ((uint64_t)lateness > task->stats.max_lateness_ns) {
+        task->stats.max_lateness_ns = (uint64_t)lateness;
+    }
+    task->stats.total_exec_ns += exec_ns;
+    if (exec_ns > task->stats.max_exec_ns) {
+        task->stats.max_exec_ns = exec_ns;
+    }
+
+    struct timespec now = *finished;
+    struct timespec next = timespec_add_ns(task->next_run, interval_ns);
+    if (timespec_greater(&next, &now) || interval_ns == 0) {
+        task->next_run = next;
+        return;
+    }
+
+    // The next period is already due: the task has overrun its slot
+    task->stats.overruns++;
+    uint64_t behind_ns = (uint64_t)timespec_diff_ns(&now, &next);
+    switch (task->catchup) {
+        case TTAK_CATCHUP_BURST:
+            task->next_run = next;
+            break;
+        case TTAK_CATCHUP_DRIFT:
+            task->next_run = timespec_add_ns(now, interval_ns);
+            break;
+        case TTAK_CATCHUP_SKIP:
+        default: {
+            uint64_t missed = behind_ns / interval_ns + 1;
+            task->stats.skipped_periods += missed;
+            task->next_run = timespec_add_ns(next, missed * interval_ns);
+            break;
+        }
+    }
+}
+
+static void close_event_fds(ttak_scheduler_t* sched) {
+    int* fds[] = {&sched->epoll_fd, &sched->timer_fd, &sched->wake_fd};
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); ++i) {
+        if (*fds[i] >= 0) {
+            close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+}
+
+static bool epoll_add(int epoll_fd, int fd, uint32_t events, uint64_t tag) {
+    struct epoll_event event = {.events = events, .data.u64 = tag};
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+static void open_event_fds(ttak_scheduler_t* sched) {
+    sched->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    sched->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    sched->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sched->epoll_fd < 0 || sched->timer_fd < 0 || sched->wake_fd < 0 ||
+        !epoll_add(sched->epoll_fd, sched->timer_fd, EPOLLIN, EVENT_TAG_TIMER) ||
+        !epoll_add(sched->epoll_fd, sched->wake_fd, EPOLLIN, EVENT_TAG_WAKE)) {
+        // run_loop falls back to clock_nanosleep and fd tasks are refused
+        close_event_fds(sched);
+    }
+}
+
+static void drain_counter_fd(int fd) {
+    uint64_t count;
+    while (read(fd, &count, sizeof(count)) == (ssize_t)sizeof(count)) {
+    }
+}
+
+static void arm_timer(ttak_scheduler_t* sched) {
+    struct itimerspec spec = {0};
+    if (sched->heap_size > 0) {
+        spec.it_value = sched->tasks[sched->heap[0]].next_run;
+    }
+    timerfd_settime(sched->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+static void dispatch_fd(ttak_scheduler_t* sched, ttak_fd_task_t* task, uint32_t events) {
+    struct timespec started = now_monotonic();
+    task->fn(task->fd, events, task->ctx);
+    struct timespec finished = now_monotonic();
+    uint64_t exec_ns = (uint64_t)timespec_diff_ns(&finished, &started);
+    task->stats.runs++;
+    task->stats.total_exec_ns += exec_ns;
+    if (exec_ns > task->stats.max_exec_ns) {
+        task->stats.max_exec_ns = exec_ns;
+    }
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        // Level-triggered hangups would otherwise spin the loop; the callback has seen them
+        epoll_ctl(sched->epoll_fd, EPOLL_CTL_DEL, task->fd, NULL);
+    }
+}
+
 void ttak_sched_init(ttak_scheduler_t* sched, ttak_task_t* buffer, size_t capacity) {
+    if (capacity > TTAK_SCHED_MAX_TASKS) {
+        capacity = TTAK_SCHED_MAX_TASKS;
+    }
     memset(buffer, 0, sizeof(ttak_task_t) * capacity);
     sched->tasks = buffer;
     sched->task_capacity = capacity;
     sched->task_count = 0;
+    sched->heap_size = 0;
+    memset(sched->fd_tasks, 0, sizeof(sched->fd_tasks));
+    sched->fd_task_count = 0;
+    atomic_init(&sched->stop_requested, false);
+    open_event_fds(sched);
 }
 
-bool ttak_sched_add(ttak_scheduler_t* sched, ttak_task_fn fn, void* ctx, uint32_t interval_us) {
+ttak_task_t* ttak_sched_add_task(ttak_scheduler_t* sched, ttak_task_fn fn, void* ctx,
+                                 uint32_t interval_us, ttak_catchup_t catchup) {
     if (sched->task_count >= sched->task_capacity) {
-        return false;
+        return NULL;
     }
-    ttak_task_t* task = &sched->tasks[sched->task_count++];
+    uint16_t index = (uint16_t)sched->task_count++;
+    ttak_task_t* task = &sched->tasks[index];
     task->fn = fn;
     task->ctx = ctx;
     task->interval_us = interval_us;
     task->next_run = timespec_add_us(now_monotonic(), interval_us);
     task->active = true;
-    return true;
+    task->catchup = catchup;
+    memset(&task->stats, 0, sizeof(task->stats));
+    heap_push(sched, index);
+    return task;
+}
+
+ttak_fd_task_t* ttak_sched_add_fd(ttak_scheduler_t* sched, int fd, uint32_t events,
+                                  ttak_fd_fn fn, void* ctx) {
+    if (sched->epoll_fd < 0 || sched->fd_task_count >= TTAK_SCHED_MAX_FD_TASKS) {
+        return NULL;
+    }
+    size_t index = sched->fd_task_count;
+    if (!epoll_add(sched->epoll_fd, fd, events, index)) {
+        return NULL;
+    }
+    ttak_fd_task_t* task = &sched->fd_tasks[index];
+    task->fd = fd;
+    task->events = events;
+    task->fn = fn;
+    task->ctx = ctx;
+    memset(&task->stats, 0, sizeof(task->stats));
+    sched->fd_task_count++;
+    return task;
+}
+
+bool ttak_sched_add(ttak_scheduler_t* sched, ttak_task_fn fn, void* ctx, uint32_t interval_us) {
+    return ttak_sched_add_task(sched, fn, ctx, interval_us, TTAK_CATCHUP_SKIP) != NULL;
 }
 
 void ttak_sched_run_once(ttak_scheduler_t* sched) {
     struct timespec current = now_monotonic();
-    for (size_t i = 0; i < sched->task_count; ++i) {
-        ttak_task_t* task = &sched->tasks[i];
+    // Each due task runs at most once per call, so BURST cannot starve the others
+    uint16_t ran[TTAK_SCHED_MAX_TASKS];
+    size_t ran_count = 0;
+    while (sched->heap_size > 0) {
+        ttak_task_t* top = &sched->tasks[sched->heap[0]];
+        if (timespec_greater(&top->next_run, &current)) {
+            break;
+        }
+        uint16_t index = heap_pop(sched);
+        ttak_task_t* task = &sched->tasks[index];
         if (!task->active) {
             continue;
         }
-        if (!timespec_greater(&task->next_run, &current)) {
-            task->fn(task->ctx);
-            task->next_run = timespec_add_us(task->next_run, task->interval_us);
-            current = now_monotonic();
-        }
+        task->fn(task->ctx);
+        struct timespec finished = now_monotonic();
+        reschedule(task, &current, &finished);
+        ran[ran_count++] = index;
+        current = finished;
+    }
+    for (size_t i = 0; i < ran_count; ++i) {
+        heap_push(sched, ran[i]);
+    }
+}
+
+static bool stop_requested(const ttak_scheduler_t* sched) {
+    return atomic_load_explicit(&sched->stop_requested, memory_order_acquire);
+}
+
+static void sleep_loop(ttak_scheduler_t* sched) {
+    while (!stop_requested(sched) && sched->heap_size > 0) {
+        struct timespec deadline = sched->tasks[sched->heap[0]].next_run;
+        int rc;
+        do {
+            rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        } while (rc == EINTR && !stop_requested(sched));
+        ttak_sched_run_once(sched);
     }
 }
 
 void ttak_sched_run_loop(ttak_scheduler_t* sched) {
-    const struct timespec sleep_ts = {0, 1000 * 1000};
-    while (true) {
+    if (sched->epoll_fd < 0) {
+        sleep_loop(sched);
+        return;
+    }
+    struct epoll_event events[TTAK_SCHED_MAX_FD_TASKS + 2];
+    while (!stop_requested(sched) && (sched->heap_size > 0 || sched->fd_task_count > 0)) {
+        arm_timer(sched);
+        int ready = epoll_wait(sched->epoll_fd, events, (int)(sizeof(events) / sizeof(events[0])), -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // Fresh input first, so timer tasks due in the same wakeup see it
+        for (int i = 0; i < ready; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == EVENT_TAG_TIMER) {
+                drain_counter_fd(sched->timer_fd);
+            } else if (tag == EVENT_TAG_WAKE) {
+                drain_counter_fd(sched->wake_fd);
+            } else if (tag < sched->fd_task_count) {
+                dispatch_fd(sched, &sched->fd_tasks[tag], events[i].events);
+            }
+        }
         ttak_sched_run_once(sched);
-        nanosleep(&sleep_ts, NULL);
     }
 }
+
+void ttak_sched_stop(ttak_scheduler_t* sched) {
+    atomic_store_explicit(&sched->stop_requested, true, memory_order_release);
+    if (sched->wake_fd >= 0) {
+        const uint64_t one = 1;
+        if (write(sched->wake_fd, &one, sizeof(one)) < 0) {
+            // The counter can only overflow if nobody is waiting on it
+        }
+    }
+}
+
+void ttak_sched_destroy(ttak_scheduler_t* sched) {
+    close_event_fds(sched);
+}
@@ -1,12 +1,39 @@
 #ifndef LIBTTAK_SCHED_H
 #define LIBTTAK_SCHED_H
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
 
+#define TTAK_SCHED_MAX_TASKS 32
+#define TTAK_SCHED_MAX_FD_TASKS 8
+
 typedef void (*ttak_task_fn)(void* ctx);
+typedef void (*ttak_fd_fn)(int fd, uint32_t events, void* ctx);
+
+/*
+ * What to do when a task is found more than one interval behind:
+ * - SKIP:  drop the missed periods and stay on the original time grid
+ * - BURST: run once per missed period until caught up
+ * - DRIFT: restart the grid one interval after the late run
+ */
+typedef enum {
+    TTAK_CATCHUP_SKIP,
+    TTAK_CATCHUP_BURST,
+    TTAK_CATCHUP_DRIFT
+} ttak_catchup_t;
+
+typedef struct {
+    uint64_t runs;
+    uint64_t overruns;
+    uint64_t skipped_periods;
+    uint64_t total_lateness_ns;
+    uint64_t max_lateness_ns;
+    uint64_t total_exec_ns;
+    uint64_t max_exec_ns;
+} ttak_task_stats_t;
 
 typedef struct {
     ttak_task_fn fn;
@@ -14,17 +41,64 @@ typedef struct {
     uint32_t interval_us;
     struct timespec next_run;
     bool active;
+    ttak_catchup_t catchup;
+    ttak_task_stats_t stats;
 } ttak_task_t;
 
+typedef struct {
+    int fd;
+    uint32_t events;
+    ttak_fd_fn fn;
+    void* ctx;
+    ttak_task_stats_t stats;  // runs and exec time only
+} ttak_fd_task_t;
+
+/*
+ * Timer and fd scheduler. Active timer tasks sit in a binary min-heap
+ * keyed on next_run. The run loop waits in epoll on the registered fds,
+ * a timerfd armed to the earliest deadline and an eventfd that
+ * ttak_sched_stop signals, so fd callbacks run as soon as data arrives.
+ * Without epoll it falls back to an absolute clock_nanosleep per deadline.
+ */
 typedef struct {
     ttak_task_t* tasks;
     size_t task_count;
     size_t task_capacity;
+    uint16_t heap[TTAK_SCHED_MAX_TASKS];
+    size_t heap_size;
+    ttak_fd_task_t fd_tasks[TTAK_SCHED_MAX_FD_TASKS];
+    size_t fd_task_count;
+    int epoll_fd;
+    int timer_fd;
+    int wake_fd;
+    _Atomic bool stop_requested;
 } ttak_scheduler_t;
 
 void ttak_sched_init(ttak_scheduler_t* sched, ttak_task_t* buffer, size_t capacity);
 bool ttak_sched_add(ttak_scheduler_t* sched, ttak_task_fn fn, void* ctx, uint32_t interval_us);
+ttak_task_t* ttak_sched_add_task(ttak_scheduler_t* sched, ttak_task_fn fn, void* ctx,
+                                 uint32_t interval_us, ttak_catchup_t catchup);
+
+/*
+ * Calls fn from the run loop whenever fd reports any of events (EPOLLIN,
+ * ...). Returns NULL when the fd cannot be polled, e.g. a driver without a
+ * poll handler; the caller then has to fall back to a timer task.
+ */
+ttak_fd_task_t* ttak_sched_add_fd(ttak_scheduler_t* sched, int fd, uint32_t events,
+                                  ttak_fd_fn fn, void* ctx);
 void ttak_sched_run_once(ttak_scheduler_t* sched);
+
 void ttak_sched_run_loop(ttak_scheduler_t* sched);
 
+/*
+ * Makes run_loop return after the current task, or right away if it has
+ * not started yet. Async-signal-safe and callable from any thread.
+ */
+void ttak_sched_stop(ttak_scheduler_t* sched);
+
+/*
+ * Closes the epoll, timer and wake descriptors. Registered fds are not closed.
+ */
+void ttak_sched_destroy(ttak_scheduler_t* sched);
+
 #endif // LIBTTAK_SCHED_H
@@ -0,0 +1,152 @@
+#define _GNU_SOURCE
+
+#include "sched_pool.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+static bool apply_policy(const ttak_worker_t* worker) {
+    struct sched_param param = {0};
+    int policy = SCHED_OTHER;
+    switch (worker->attr.policy) {
+        case TTAK_WORKER_FIFO:
+            policy = SCHED_FIFO;
+            param.sched_priority = worker->attr.rt_priority;
+            break;
+        case TTAK_WORKER_IDLE:
+            policy = SCHED_IDLE;
+            break;
+        case TTAK_WORKER_NORMAL:
+        default:
+            break;
+    }
+    bool applied = true;
+    if (policy != SCHED_OTHER) {
+        int rc = pthread_setschedparam(pthread_self(), policy, &param);
+        if (rc != 0) {
+            fprintf(stderr, "sched pool: worker keeps SCHED_OTHER (%s)\n", strerror(rc));
+            applied = false;
+        }
+    }
+    if (worker->attr.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker->attr.cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            fprintf(stderr, "sched pool: worker not pinned to cpu %d (%s)\n",
+                    worker->attr.cpu, strerror(rc));
+            applied = false;
+        }
+    }
+    return applied;
+}
+
+static void* worker_main(void* arg) {
+    ttak_worker_t* worker = (ttak_worker_t*)arg;
+    worker->policy_applied = apply_policy(worker);
+    ttak_sched_run_loop(&worker->sched);
+    return NULL;
+}
+
+bool ttak_pool_init(ttak_sched_pool_t* pool, size_t worker_count, const ttak_worker_attr_t* attrs) {
+    memset(pool, 0, sizeof(*pool));
+    if (worker_count == 0 || worker_count > TTAK_POOL_MAX_WORKERS) {
+        return false;
+    }
+    pool->worker_count = worker_count;
+    for (size_t i = 0; i < worker_count; ++i) {
+        ttak_worker_t* worker = &pool->workers[i];
+        ttak_sched_init(&worker->sched, worker->tasks, TTAK_POOL_TASKS_PER_WORKER);
+        if (attrs != NULL) {
+            worker->attr = attrs[i];
+        } else {
+            worker->attr.policy = TTAK_WORKER_NORMAL;
+            worker->attr.cpu = -1;
+        }
+    }
+    return true;
+}
+
+ttak_task_t* ttak_pool_add_task(ttak_sched_pool_t* pool, int worker, ttak_task_fn fn, void* ctx,
+                                uint32_t interval_us, uint32_t exec_hint_us, ttak_catchup_t catchup) {
+    size_t index = 0;
+    if (worker >= 0) {
+        if ((size_t)worker >= pool->worker_count) {
+            return NULL;
+        }
+        index = (size_t)worker;
+    } else {
+        // Least loaded worker that still has a free slot; only NORMAL workers take unplaced tasks
+        bool found = false;
+        for (size_t i = 0; i < pool->worker_count; ++i) {
+            const ttak_worker_t* candidate = &pool->workers[i];
+            if (candidate->attr.policy != TTAK_WORKER_NORMAL ||
+                candidate->sched.task_count >= candidate->sched.task_capacity) {
+                continue;
+            }
+            if (!found || candidate->load_ppm < pool->workers[index].load_ppm) {
+                index = i;
+                found = true;
+            }
+        }
+        if (!found) {
+            return NULL;
+        }
+    }
+
+    ttak_worker_t* target = &pool->workers[index];
+    ttak_task_t* task = ttak_sched_add_task(&target->sched, fn, ctx, interval_us, catchup);
+    if (task != NULL && interval_us > 0) {
+        uint64_t exec_us = exec_hint_us ? exec_hint_us : interval_us / 100u;
+        target->load_ppm += exec_us * 1000000ULL / interval_us;
+    }
+    return task;
+}
+
+ttak_fd_task_t* ttak_pool_add_fd(ttak_sched_pool_t* pool, int worker, int fd, uint32_t events,
+                                 ttak_fd_fn fn, void* ctx) {
+    if (worker < 0 || (size_t)worker >= pool->worker_count) {
+        return NULL;
+    }
+    return ttak_sched_add_fd(&pool->workers[worker].sched, fd, events, fn, ctx);
+}
+
+bool ttak_pool_start(ttak_sched_pool_t* pool) {
+    // Workers never handle signals; the thread that started the pool does
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+
+    bool ok = true;
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        ttak_worker_t* worker = &pool->workers[i];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            ok = false;
+            break;
+        }
+        worker->started = true;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (!ok) {
+        ttak_pool_stop(pool);
+    }
+    return ok;
+}
+
+void ttak_pool_stop(ttak_sched_pool_t* pool) {
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        ttak_sched_stop(&pool->workers[i].sched);
+    }
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        ttak_worker_t* worker = &pool->workers[i];
+        if (worker->started) {
+            pthread_join(worker->thread, NULL);
+            worker->started = false;
+        }
+        ttak_sched_destroy(&worker->sched);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef LIBTTAK_SCHED_POOL_H
+#define LIBTTAK_SCHED_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sched.h"
+
+#define TTAK_POOL_MAX_WORKERS 4
+#define TTAK_POOL_TASKS_PER_WORKER 8
+#define TTAK_POOL_ANY_WORKER (-1)
+
+typedef enum {
+    TTAK_WORKER_NORMAL,  // SCHED_OTHER
+    TTAK_WORKER_FIFO,    // SCHED_FIFO at rt_priority, for the control loop
+    TTAK_WORKER_IDLE     // SCHED_IDLE, for background work such as checkpoints
+} ttak_worker_policy_t;
+
+typedef struct {
+    ttak_worker_policy_t policy;
+    int rt_priority;
+    int cpu;             // -1 leaves the worker unpinned
+} ttak_worker_attr_t;
+
+typedef struct {
+    ttak_scheduler_t sched;
+    ttak_task_t tasks[TTAK_POOL_TASKS_PER_WORKER];
+    ttak_worker_attr_t attr;
+    uint64_t load_ppm;   // summed utilisation estimate of the placed tasks
+    pthread_t thread;
+    bool started;
+    bool policy_applied;  // false when the RT policy or affinity was refused
+} ttak_worker_t;
+
+/*
+ * Scheduler pool: each worker thread owns a ttak_scheduler_t and runs its
+ * heap independently, so a slow task only delays the tasks placed on the
+ * same worker. Tasks are either pinned to a worker or placed on the least
+ * loaded one when added. Timer and fd tasks must be added before
+ * ttak_pool_start; workers do not migrate tasks between each other once
+ * running.
+ */
+typedef struct {
+    ttak_worker_t workers[TTAK_POOL_MAX_WORKERS];
+    size_t worker_count;
+} ttak_sched_pool_t;
+
+/*
+ * attrs may be NULL for worker_count unpinned SCHED_OTHER workers.
+ */
+bool ttak_pool_init(ttak_sched_pool_t* pool, size_t worker_count, const ttak_worker_attr_t* attrs);
+
+/*
+ * worker is an index or TTAK_POOL_ANY_WORKER. exec_hint_us is the expected
+ * run time of one call and only steers placement; 0 counts as 1% of the
+ * interval.
+ */
+ttak_task_t* ttak_pool_add_task(ttak_sched_pool_t* pool, int worker, ttak_task_fn fn, void* ctx,
+                                uint32_t interval_us, uint32_t exec_hint_us, ttak_catchup_t catchup);
+
+/*
+ * fd tasks run on the given worker; there is no automatic placement since
+ * the callback usually shares state with that worker's timer tasks.
+ */
+ttak_fd_task_t* ttak_pool_add_fd(ttak_sched_pool_t* pool, int worker, int fd, uint32_t events,
+                                 ttak_fd_fn fn, void* ctx);
+
+/*
+ * Starts the worker threads. Real-time policies that cannot be applied
+ * (EPERM without CAP_SYS_NICE) fall back to SCHED_OTHER with a warning.
+ */
+bool ttak_pool_start(ttak_sched_pool_t* pool);
+
+/*
+ * Stops and joins every worker, then releases their descriptors. Each
+ * worker is woken immediately and exits after its current task returns.
+ */
+void ttak_pool_stop(ttak_sched_pool_t* pool);
+
+#endif // LIBTTAK_SCHED_POOL_H
@@ -0,0 +1,175 @@
+#define _GNU_SOURCE
+
+#include "tlog.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TLOG_DRAIN_BATCH 64
+
+static uint64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void rotate_files(ttak_tlog_t* log) {
+    char from[TTAK_TLOG_PATH_MAX + 16];
+    char to[TTAK_TLOG_PATH_MAX + 16];
+    if (log->keep_segments == 0) {
+        unlink(log->path);
+        return;
+    }
+    for (unsigned i = log->keep_segments; i > 1; --i) {
+        snprintf(from, sizeof(from), "%s.%u", log->path, i - 1);
+        snprintf(to, sizeof(to), "%s.%u", log->path, i);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", log->path);
+    rename(log->path, to);
+}
+
+static void close_segment(ttak_tlog_t* log) {
+    if (log->map != NULL) {
+        msync(log->map, log->map_size, MS_SYNC);
+        munmap(log->map, log->map_size);
+        log->map = NULL;
+        log->header = NULL;
+    }
+    if (log->fd >= 0) {
+        close(log->fd);
+        log->fd = -1;
+    }
+}
+
+static bool open_segment(ttak_tlog_t* log) {
+    log->map_size = sizeof(ttak_tlog_header_t) + log->record_size * log->segment_records;
+    log->fd = open(log->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (log->fd < 0) {
+        perror("tlog: open segment");
+        return false;
+    }
+    if (ftruncate(log->fd, (off_t)log->map_size) != 0) {
+        perror("tlog: size segment");
+        close(log->fd);
+        log->fd = -1;
+        return false;
+    }
+    void* map = mmap(NULL, log->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("tlog: map segment");
+        close(log->fd);
+        log->fd = -1;
+        return false;
+    }
+    log->map = (uint8_t*)map;
+    log->header = (ttak_tlog_header_t*)map;
+    memcpy(log->header->magic, TTAK_TLOG_MAGIC, sizeof(log->header->magic));
+    log->header->version = TTAK_TLOG_VERSION;
+    log->header->record_kind = log->record_kind;
+    log->header->record_size = (uint32_t)log->record_size;
+    log->header->segment_index = log->segment_index++;
+    log->header->record_capacity = log->segment_records;
+    log->header->record_count = 0;
+    log->header->dropped = 0;
+    log->header->created_realtime_ns = realtime_ns();
+    return true;
+}
+
+static size_t drain(ttak_tlog_t* log) {
+    size_t drained = 0;
+    while (log->header != NULL) {
+        if (log->header->record_count >= log->header->record_capacity) {
+            close_segment(log);
+            rotate_files(log);
+            if (!open_segment(log)) {
+                break;
+            }
+        }
+        uint8_t* slot = log->map + sizeof(ttak_tlog_header_t) +
+                        log->header->record_count * log->record_size;
+        if (!ttak_ring_pop(&log->ring, slot)) {
+            break;
+        }
+        log->header->record_count++;
+        log->header->dropped = ttak_ring_dropped(&log->ring);
+        if (++drained % TLOG_DRAIN_BATCH == 0) {
+            msync(log->map, log->map_size, MS_ASYNC);
+        }
+    }
+    return drained;
+}
+
+static void* writer_main(void* arg) {
+    ttak_tlog_t* log = (ttak_tlog_t*)arg;
+#ifdef SCHED_IDLE
+    struct sched_param param = {0};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+    const struct timespec period = {
+        .tv_sec = log->flush_interval_us / 1000000u,
+        .tv_nsec = (long)(log->flush_interval_us % 1000000u) * 1000L
+    };
+    while (atomic_load_explicit(&log->running, memory_order_acquire)) {
+        if (drain(log) > 0) {
+            msync(log->map, log->map_size, MS_ASYNC);
+        }
+        nanosleep(&period, NULL);
+    }
+    drain(log);
+    return NULL;
+}
+
+bool ttak_tlog_open(ttak_tlog_t* log, const ttak_tlog_config_t* config, void* ring_backing, size_t ring_slots) {
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    if (config->path == NULL || strlen(config->path) >= sizeof(log->path) ||
+        config->record_size == 0 || config->segment_records == 0) {
+        return false;
+    }
+    if (!ttak_ring_init(&log->ring, ring_backing, config->record_size, ring_slots)) {
+        return false;
+    }
+    strcpy(log->path, config->path);
+    log->record_kind = config->record_kind;
+    log->record_size = config->record_size;
+    log->segment_records = config->segment_records;
+    log->keep_segments = config->keep_segments;
+    log->flush_interval_us = config->flush_interval_us ? config->flush_interval_us : 200000u;
+
+    rotate_files(log);
+    if (!open_segment(log)) {
+        return false;
+    }
+    atomic_store(&log->running, true);
+    if (pthread_create(&log->writer, NULL, writer_main, log) != 0) {
+        atomic_store(&log->running, false);
+        close_segment(log);
+        return false;
+    }
+    log->started = true;
+    return true;
+}
+
+bool ttak_tlog_write(ttak_tlog_t* log, const void* record) {
+    if (!log->started) {
+        return false;
+    }
+    return ttak_ring_push(&log->ring, record);
+}
+
+void ttak_tlog_close(ttak_tlog_t* log) {
+    if (!log->started) {
+        return;
+    }
+    atomic_store_explicit(&log->running, false, memory_order_release);
+    pthread_join(log->writer, NULL);
+    log->started = false;
+    close_segment(log);
+}
@@ -0,0 +1,72 @@
+#ifndef LIBTTAK_TLOG_H
+#define LIBTTAK_TLOG_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ring.h"
+
+#define TTAK_TLOG_MAGIC "TTLG"
+#define TTAK_TLOG_VERSION 1u
+#define TTAK_TLOG_PATH_MAX 256
+
+/*
+ * On-disk segment header. Records follow immediately after it; only the
+ * first record_count records of a segment are valid.
+ */
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_kind;
+    uint32_t record_size;
+    uint32_t segment_index;
+    uint64_t record_capacity;
+    uint64_t record_count;
+    uint64_t dropped;
+    uint64_t created_realtime_ns;
+    uint8_t reserved[16];
+} ttak_tlog_header_t;
+
+typedef struct {
+    const char* path;
+    uint16_t record_kind;
+    size_t record_size;
+    size_t segment_records;
+    unsigned keep_segments;
+    uint32_t flush_interval_us;
+} ttak_tlog_config_t;
+
+/*
+ * Binary telemetry logger. Producers hand fixed-size records to an SPSC
+ * ring; a SCHED_IDLE writer thread drains it into an mmap'd segment file
+ * and rotates path -> path.1 -> ... -> path.<keep_segments> when full.
+ */
+typedef struct {
+    ttak_ring_t ring;
+    pthread_t writer;
+    _Atomic bool running;
+    bool started;
+    char path[TTAK_TLOG_PATH_MAX];
+    uint16_t record_kind;
+    size_t record_size;
+    size_t segment_records;
+    unsigned keep_segments;
+    uint32_t flush_interval_us;
+    uint32_t segment_index;
+    int fd;
+    uint8_t* map;
+    size_t map_size;
+    ttak_tlog_header_t* header;
+} ttak_tlog_t;
+
+/*
+ * ring_backing must hold config->record_size * ring_slots bytes, ring_slots a power of two.
+ */
+bool ttak_tlog_open(ttak_tlog_t* log, const ttak_tlog_config_t* config, void* ring_backing, size_t ring_slots);
+bool ttak_tlog_write(ttak_tlog_t* log, const void* record);
+void ttak_tlog_close(ttak_tlog_t* log);
+
+#endif // LIBTTAK_TLOG_H
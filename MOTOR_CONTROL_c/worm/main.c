@@ -3,12 +3,14 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <time.h>
@@ -16,12 +18,23 @@
 
 #include "libttak/mem/arena.h"
 #include "libttak/sched.h"
+#include "libttak/sched_pool.h"
+#include "libttak/tlog.h"
+#include "checkpoint.h"
+#include "hub.h"
 #include "neuron.h"
+#include "remote.h"
+#include "trace.h"
+#include "ultrasonic.h"
+#include "vision.h"
 #include "../../common/motor/ioctl_car_cmd.h"
+#include "../../common/telemetry/records.h"
 
 #define DEVNAME "/dev/motor"
 #define SR04 "/dev/sr04"
+#define SR04_COMM ULTRA_COMM_DEVNAME
 #define NN_SAVE_FILE "neural_net.dat"
+#define TELEMETRY_FILE "telemetry.bin"
 
 #define MOTOR_SPEED_MAX 100
 #define SENSOR_DIST_MAX_CM 500
@@ -29,23 +42,44 @@
 #define RPE_LEARNING_RATE 0.1f
 
 #define CONTROL_INTERVAL_US 100000
-#define ARENA_HEAP_SIZE (sizeof(Neuron_t) * MAX_NEURONS + sizeof(Synapse_t) * MAX_SYNAPSES + sizeof(ttak_task_t) * 4 + 32768)
+// The driver stops the car if the control loop misses this many ticks in a row
+#define MOTOR_WATCHDOG_MS (5 * CONTROL_INTERVAL_US / 1000)
+#define CONTROL_EXEC_HINT_US 5000
+#define CONTROL_RT_PRIORITY 50
+#define CONTROL_WORKER 0
+#define BACKGROUND_WORKER 1
+#define TELEMETRY_RING_SLOTS 256
+#define TELEMETRY_SEGMENT_RECORDS 36000
+#define TELEMETRY_KEEP_SEGMENTS 4
+#define TRACE_RING_SLOTS 512
+#define CHECKPOINT_INTERVAL_MS 2000
+#define CHECKPOINT_PAGE_BUDGET 16
+#define PLASTICITY_INTERVAL_MS 5000
+#define ARENA_BLOCK_SIZE (64u * 1024u)
 
-#define ATP_LEVEL_MAX 100.0f
 #define ATP_REST_THRESHOLD 20.0f
 #define ATP_BASE_CONSUMPTION 0.2f
 #define ATP_MOTOR_CONSUMPTION 1.5f
 #define ATP_RECOVERY_RATE 1.2f
 #define SOCIAL_VOCAL_ATP_GATE 30.0f
 
-#define ULTRA_PACKET_BITS 7
-#define ULTRA_START_BIT (1u << 6)
-#define ULTRA_STOP_BIT 0x01u
-#define ULTRA_PULSE_SHORT_US 1200
-#define ULTRA_PULSE_LONG_US 3200
-#define ULTRA_INTERVAL_ZERO_NS 100000000L
-#define ULTRA_INTERVAL_ONE_NS 200000000L
+// Above the control task: a 1.2 ms pulse must not stretch behind a 5 ms tick
+#define ULTRA_SENDER_RT_PRIORITY (CONTROL_RT_PRIORITY + 1)
 #define ULTRA_VOCALIZE_COOLDOWN_NS 1500000000L
+#define ULTRA_PENDING_MAX 16
+// Received emotions act at full strength while fresh and fade out until stale
+#define ULTRA_AGE_FRESH_MS 500u
+#define ULTRA_AGE_STALE_MS 3000u
+// Traces store the packet in the low byte and its age in milliseconds above it
+#define ULTRA_TRACE_AGE_SHIFT 8
+#define ULTRA_TRACE_AGE_MAX_MS 0xFFFFFFu
+
+#define REMOTE_DEFAULT_RATE_HZ 10
+#define REMOTE_MAX_RATE_HZ 100
+// Traces store the station's left speed in the low byte and the right speed above it
+#define REMOTE_TRACE_RIGHT_SHIFT 8
+
+_Static_assert(TELEMETRY_NEUROMOD_CHANNELS == NEUROMOD_COUNT, "worm telemetry record out of step with NeuroModulator_t");
 
 typedef struct WormRuntime {
     float sensory_input[3];
@@ -61,42 +95,80 @@ typedef struct {
 } MotorTelemetry_t;
 
 static ttak_arena_t neural_arena;
-static uint8_t neural_heap[ARENA_HEAP_SIZE];
 static WormRuntime_t* worm_runtime = NULL;
-static ttak_scheduler_t scheduler;
-static ttak_task_t* scheduler_slots = NULL;
+static ttak_sched_pool_t sched_pool;
+static ttak_task_t* control_task = NULL;
+static ttak_task_t* checkpoint_task = NULL;
+static ttak_task_t* plasticity_task = NULL;
+static ttak_task_t* remote_task = NULL;
+static ttak_tlog_t telemetry_log;
+static NeuralCheckpoint_t checkpoint;
+static WormTrace_t trace;
+static uint64_t tick_now_ns = 0;
 
 static int motor = -1;
 static int sr04_sensor = -1;
 static int sr04_comm = -1;
 static bool sr04_comm_is_alias = false;
+static UltraSender_t ultra_sender;
+static UltraRxFilter_t ultra_rx_filter;
+static uint8_t social_id = 0;
+static VisionLink_t vision_link;
+static HubLink_t hub_link;
+// On the motor bus the hub owns /dev/motor and the worm only posts setpoints
+static bool bus_enabled = false;
+static uint32_t last_distance_cm = 0;
+
+// State frames are built from the last tick's snapshot; both run on the control worker
+static RemoteLink_t remote_link = {.fd = -1};
+static bool remote_enabled = false;
+static CarLinkState_t remote_state;
+
+// Packets read by the fd task, consumed in order by the next control tick
+static struct ultra_rx_packet ultra_pending[ULTRA_PENDING_MAX];
+static size_t ultra_pending_head = 0;
+static size_t ultra_pending_count = 0;
+static bool ultra_fd_driven = false;
 
 static float expected_reward = 0.0f;
 static float exploration_drive = 0.0f;
-static struct timespec last_vocalization_ts = {0};
+static uint64_t last_vocalization_ns = 0;
 static bool last_vocalization_valid = false;
 
 static void read_sensors(float* sensory_input);
+static uint32_t read_distance_direct(void);
 static float get_exploration_noise(void);
-static MotorTelemetry_t send_motor_outputs(const float* motor_output, bool rest_mode);
+static MotorTelemetry_t send_motor_outputs(const float* motor_output, bool rest_mode, const RemoteDrive_t* drive);
 static void worm_task(void* ctx);
 static void update_energy_budget(float left_speed, float right_speed, bool rest_mode);
 static void worm_vocalize(void);
 static void worm_listen(void);
-static void send_ultrasonic_packet(uint8_t packet);
-static uint8_t receive_ultrasonic_packet(void);
+static bool receive_ultrasonic_packet(uint8_t* packet, uint32_t* age_ms);
 static uint8_t determine_emotion_code(void);
 static uint8_t determine_intensity_bits(uint8_t emotion_code);
-static void apply_received_emotion(uint8_t emotion_code, uint8_t intensity_bits);
+static void apply_received_emotion(uint8_t emotion_code, uint8_t intensity_bits, uint32_t age_ms);
 static struct timespec monotonic_now(void);
-static int64_t timespec_diff_ns(const struct timespec* now, const struct timespec* past);
-static void nanosleep_ns(long nanoseconds);
+static void report_schedule_stats(void);
 
-void sigHandler(int dummy) {
-    (void)dummy;
+/*
+ * Runs on the main thread once SIGINT/SIGTERM arrives. The pool is joined
+ * first, so nothing below races with a control tick or a checkpoint.
+ */
+static void shutdown_worm(void) {
     puts("Exiting...");
+    ttak_pool_stop(&sched_pool);
+    UltraSender_stop(&ultra_sender);
+    report_schedule_stats();
+    VisionLink_close(&vision_link);
+    HubLink_close(&hub_link);
+    RemoteLink_close(&remote_link);
+    NeuralCheckpoint_destroy(&checkpoint);
     NeuralNet_save(NN_SAVE_FILE);
-    ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
+    WormTrace_close(&trace);
+    ttak_tlog_close(&telemetry_log);
+    if (motor >= 0) {
+        ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
+    }
     if (sr04_sensor >= 0) {
         close(sr04_sensor);
         sr04_sensor = -1;
@@ -108,17 +180,38 @@ void sigHandler(int dummy) {
         close(motor);
         motor = -1;
     }
-    exit(0);
+}
+
+// Ranges with the worm's own descriptor while no sensor hub is measuring
+static uint32_t read_distance_direct(void) {
+    char dist_buf[16] = {0}; // the driver always copies 16 bytes
+    if (sr04_sensor < 0) {
+        sr04_sensor = open(SR04, O_RDWR);
+        if (sr04_sensor < 0) {
+            return 0;
+        }
+    }
+    ssize_t got = read(sr04_sensor, dist_buf, sizeof(dist_buf));
+    if (got < 0 && errno == EBUSY) {
+        // The driver holds ranging off while an ultrasonic frame is on air
+        return last_distance_cm;
+    }
+    return got > 0 ? (uint32_t)atoi(dist_buf) : 0;
 }
 
 void read_sensors(float* sensory_input) {
     static float prev_raw_dist = 0.0f;
-    char dist_buf[8] = {0};
     u_int32_t dist = 0;
 
-    if (read(sr04_sensor, dist_buf, sizeof(dist_buf)) > 0) {
-        dist = (u_int32_t)atoi(dist_buf);
+    if (trace.replaying) {
+        WormTrace_take(&trace, TRACE_EVENT_DISTANCE, &dist);
+    } else {
+        if (!HubLink_distance(&hub_link, tick_now_ns, &dist)) {
+            dist = read_distance_direct();
+        }
+        WormTrace_record_event(&trace, TRACE_EVENT_DISTANCE, dist);
     }
+    last_distance_cm = dist;
 
     float normalized_dist = 0.0f;
     if (dist > 0 && dist < SENSOR_DIST_MAX_CM) {
@@ -131,7 +224,10 @@ void read_sensors(float* sensory_input) {
         if (decayed <= 0.0005f) {
             sensory_input[SENSOR_NEURON_DIST_IDX] = 0.0f;
             if (exploration_drive < 0.5f) {
-                norepinephrine_level = fminf(1.0f, norepinephrine_level + 0.3f);
+                NeuroModDelta_t delta;
+                NeuroMod_delta_init(&delta);
+                NeuroMod_add(&delta, NEUROMOD_NOREPINEPHRINE, TTAK_FX_CONST(0.3f));
+                NeuralNet_modulate(&delta);
                 exploration_drive = 1.0f;
             }
         } else {
@@ -142,7 +238,24 @@ void read_sensors(float* sensory_input) {
     }
     prev_raw_dist = normalized_dist;
 
-    if (normalized_dist > 0.5f) {
+    // Camera salience drives the host neurons; without a fresh frame they fall back to the distance guess
+    uint32_t vision = 0;
+    bool have_vision = false;
+    if (trace.replaying) {
+        have_vision = WormTrace_take(&trace, TRACE_EVENT_VISION, &vision);
+    } else {
+        VisionSample_t sample;
+        if (VisionLink_poll(&vision_link, tick_now_ns, &sample)) {
+            vision = (uint32_t)sample.salience_l | (uint32_t)sample.salience_r << 16;
+            WormTrace_record_event(&trace, TRACE_EVENT_VISION, vision);
+            have_vision = true;
+        }
+    }
+
+    if (have_vision) {
+        sensory_input[SENSOR_NEURON_HOST_L_IDX] = (float)(vision & 0xFFFFu) / (float)VISION_SALIENCE_ONE;
+        sensory_input[SENSOR_NEURON_HOST_R_IDX] = (float)(vision >> 16) / (float)VISION_SALIENCE_ONE;
+    } else if (normalized_dist > 0.5f) {
         float left_host_signal = 1.0f - (normalized_dist * 0.5f);
         float right_host_signal = 1.0f - (normalized_dist * 0.5f);
         if (rand() % 2 == 0) {
@@ -158,18 +271,23 @@ void read_sensors(float* sensory_input) {
     }
 }
 
+static float modulator(NeuroModulator_t channel) {
+    return ttak_fx_to_float(NeuralNet_modulators()->level[channel]);
+}
+
 float get_exploration_noise(void) {
-    float serotonin_noise = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * (serotonin_level * 0.5f);
+    float serotonin_noise = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * (modulator(NEUROMOD_SEROTONIN) * 0.5f);
     float norepi_component = 0.0f;
     if (exploration_drive > 0.0f) {
         norepi_component = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) *
-                           (norepinephrine_level * exploration_drive);
+                           (modulator(NEUROMOD_NOREPINEPHRINE) * exploration_drive);
         exploration_drive = fmaxf(0.0f, exploration_drive - 0.05f);
     }
     return serotonin_noise + norepi_component;
 }
 
-MotorTelemetry_t send_motor_outputs(const float* motor_output, bool rest_mode) {
+// A station drive replaces the network's speeds but not the noise draws, so replays stay in step
+MotorTelemetry_t send_motor_outputs(const float* motor_output, bool rest_mode, const RemoteDrive_t* drive) {
     MotorTelemetry_t telemetry = {0, 0};
     struct ioctl_info io = {0};
     io.size = 5;
@@ -187,6 +305,11 @@ MotorTelemetry_t send_motor_outputs(const float* motor_output, bool rest_mode) {
         if (abs(right_speed) < 5) right_speed = 0;
     }
 
+    if (drive != NULL) {
+        left_speed = drive->left_speed;
+        right_speed = drive->right_speed;
+    }
+
     if (left_speed < -MOTOR_SPEED_MAX) left_speed = -MOTOR_SPEED_MAX;
     if (right_speed < -MOTOR_SPEED_MAX) right_speed = -MOTOR_SPEED_MAX;
     if (left_speed > MOTOR_SPEED_MAX) left_speed = MOTOR_SPEED_MAX;
@@ -198,27 +321,41 @@ MotorTelemetry_t send_motor_outputs(const float* motor_output, bool rest_mode) {
     io.buf[3] = (right_speed >= 0);
     io.buf[4] = abs(right_speed);
 
-    ioctl(motor, PI_CMD_IO, &io);
+    if (trace.replaying) {
+        printf("%u,%d,%d,%d\n", trace.tick, left_speed, right_speed, rest_mode ? 1 : 0);
+    } else if (bus_enabled) {
+        HubLink_post(&hub_link, io.buf, tick_now_ns);
+    } else {
+        ioctl(motor, PI_CMD_IO, &io);
+    }
 
     telemetry.left_speed = left_speed;
     telemetry.right_speed = right_speed;
 
-    printf("L: %d, R: %d | ATP: %.1f | Rest: %s | Dopamine: %.2f | Serotonin: %.2f | Norepi: %.2f | Cortisol: %.2f | Stability: %.2f\n",
-           left_speed, right_speed, atp_level, rest_mode ? "YES" : "NO",
-           dopamine_level, serotonin_level, norepinephrine_level, cortisol_level, stability_level);
+    WormTelemetry_t record = {
+        .timestamp_ns = tick_now_ns,
+        .left_speed = (int16_t)left_speed,
+        .right_speed = (int16_t)right_speed,
+        .rest_mode = rest_mode ? 1 : 0,
+    };
+    memcpy(record.neuromod_fx, NeuralNet_modulators()->level, sizeof(record.neuromod_fx));
+    ttak_tlog_write(&telemetry_log, &record);
 
     return telemetry;
 }
 
 void update_energy_budget(float left_speed, float right_speed, bool rest_mode) {
+    NeuroModDelta_t delta;
+    NeuroMod_delta_init(&delta);
     float movement = (fabsf(left_speed) + fabsf(right_speed)) / (2.0f * MOTOR_SPEED_MAX);
     if (movement > 0.05f && !rest_mode) {
         float consumption = ATP_BASE_CONSUMPTION + movement * ATP_MOTOR_CONSUMPTION;
-        atp_level = fmaxf(0.0f, atp_level - consumption);
+        NeuroMod_add(&delta, NEUROMOD_ATP, ttak_fx_from_float(-consumption));
     } else {
         float recovery = rest_mode ? ATP_RECOVERY_RATE * 1.5f : ATP_RECOVERY_RATE;
-        atp_level = fminf(ATP_LEVEL_MAX, atp_level + recovery);
+        NeuroMod_add(&delta, NEUROMOD_ATP, ttak_fx_from_float(recovery));
     }
+    NeuralNet_modulate(&delta);
 }
 
 static struct timespec monotonic_now(void) {
@@ -227,46 +364,57 @@ static struct timespec monotonic_now(void) {
     return ts;
 }
 
-static int64_t timespec_diff_ns(const struct timespec* now, const struct timespec* past) {
-    int64_t sec = (int64_t)now->tv_sec - (int64_t)past->tv_sec;
-    int64_t nsec = (int64_t)now->tv_nsec - (int64_t)past->tv_nsec;
-    return sec * 1000000000LL + nsec;
+static uint64_t monotonic_now_ns(void) {
+    struct timespec ts = monotonic_now();
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
-static void nanosleep_ns(long nanoseconds) {
-    struct timespec ts = {
-        .tv_sec = nanoseconds / 1000000000L,
-        .tv_nsec = nanoseconds % 1000000000L
-    };
-    nanosleep(&ts, NULL);
+/*
+ * The station's drive for this tick, if it holds one. The trace keeps it,
+ * so replays follow the same commands without the network.
+ */
+static bool take_remote_drive(RemoteDrive_t* drive) {
+    uint32_t recorded = 0;
+    if (trace.replaying) {
+        if (!WormTrace_take(&trace, TRACE_EVENT_REMOTE_DRIVE, &recorded)) {
+            return false;
+        }
+    } else {
+        if (!remote_enabled || !RemoteLink_drive(&remote_link, tick_now_ns, drive)) {
+            return false;
+        }
+        recorded = (uint32_t)(uint8_t)drive->left_speed |
+                   (uint32_t)(uint8_t)drive->right_speed << REMOTE_TRACE_RIGHT_SHIFT;
+        WormTrace_record_event(&trace, TRACE_EVENT_REMOTE_DRIVE, recorded);
+    }
+    drive->left_speed = (int8_t)(uint8_t)recorded;
+    drive->right_speed = (int8_t)(uint8_t)(recorded >> REMOTE_TRACE_RIGHT_SHIFT);
+    return true;
 }
 
-static void sr04_toggle_trigger(bool high) {
-    if (sr04_comm < 0) {
-        return;
-    }
-    const char value = high ? '1' : '0';
-    if (write(sr04_comm, &value, 1) < 0) {
-        // Ignore write failures to keep control loop running
-    }
+static void update_remote_state(const WormRuntime_t* runtime, const MotorTelemetry_t* telemetry,
+                                bool rest_mode, bool remote) {
+    remote_state.distance_cm = last_distance_cm > UINT16_MAX ? UINT16_MAX : (uint16_t)last_distance_cm;
+    remote_state.left_speed = (int8_t)telemetry->left_speed;
+    remote_state.right_speed = (int8_t)telemetry->right_speed;
+    remote_state.salience_l = (uint8_t)(fminf(fmaxf(runtime->sensory_input[SENSOR_NEURON_HOST_L_IDX], 0.0f), 1.0f) * 255.0f);
+    remote_state.salience_r = (uint8_t)(fminf(fmaxf(runtime->sensory_input[SENSOR_NEURON_HOST_R_IDX], 0.0f), 1.0f) * 255.0f);
+    float atp = ttak_fx_to_float(NeuralNet_modulators()->level[NEUROMOD_ATP]);
+    remote_state.atp = (uint8_t)fminf(fmaxf(atp, 0.0f), 100.0f);
+    remote_state.flags = (rest_mode ? CAR_LINK_STATE_REST : 0) | (remote ? CAR_LINK_STATE_REMOTE : 0);
 }
 
-static void sr04_emit_pulse(bool long_pulse) {
-    sr04_toggle_trigger(true);
-    nanosleep_ns((long)(long_pulse ? ULTRA_PULSE_LONG_US : ULTRA_PULSE_SHORT_US) * 1000L);
-    sr04_toggle_trigger(false);
+static void on_remote_readable(int fd, uint32_t events, void* ctx) {
+    (void)fd;
+    (void)events;
+    (void)ctx;
+    RemoteLink_receive(&remote_link, monotonic_now_ns());
 }
 
-static void send_ultrasonic_bit(bool bit) {
-    if (!bit) {
-        sr04_emit_pulse(false);
-        nanosleep_ns(ULTRA_INTERVAL_ZERO_NS);
-        sr04_emit_pulse(false);
-        nanosleep_ns(ULTRA_INTERVAL_ZERO_NS);
-    } else {
-        sr04_emit_pulse(true);
-        nanosleep_ns(ULTRA_INTERVAL_ONE_NS);
-    }
+static void remote_tick(void* ctx) {
+    (void)ctx;
+    CarLinkState_t state = remote_state;
+    RemoteLink_send_state(&remote_link, monotonic_now_ns(), &state);
 }
 
 static uint8_t compose_emotion_packet(uint8_t emotion_code, uint8_t intensity_bits) {
@@ -279,28 +427,29 @@ static uint8_t compose_emotion_packet(uint8_t emotion_code, uint8_t intensity_bi
 }
 
 static uint8_t determine_emotion_code(void) {
-    if (epinephrine_level > 0.85f && cortisol_level > 0.8f) {
+    const ttak_fx_t* level = NeuralNet_modulators()->level;
+    if (level[NEUROMOD_EPINEPHRINE] > TTAK_FX_CONST(0.85f) && level[NEUROMOD_CORTISOL] > TTAK_FX_CONST(0.8f)) {
         return 0x06; // Terror
     }
-    if (cortisol_level > 0.8f) {
+    if (level[NEUROMOD_CORTISOL] > TTAK_FX_CONST(0.8f)) {
         return 0x03; // Pain
     }
-    if (dopamine_level > 0.5f && oxytocin_level > 0.5f) {
+    if (level[NEUROMOD_DOPAMINE] > TTAK_FX_CONST(0.5f) && level[NEUROMOD_OXYTOCIN] > TTAK_FX_CONST(0.5f)) {
         return 0x02; // Bond
     }
-    if (gaba_level > 0.65f && stability_level < 0.3f) {
+    if (level[NEUROMOD_GABA] > TTAK_FX_CONST(0.65f) && level[NEUROMOD_STABILITY] < TTAK_FX_CONST(0.3f)) {
         return 0x05; // Repel
     }
-    if (dopamine_level > 0.4f && acetylcholine_level > 0.5f) {
+    if (level[NEUROMOD_DOPAMINE] > TTAK_FX_CONST(0.4f) && level[NEUROMOD_ACETYLCHOLINE] > TTAK_FX_CONST(0.5f)) {
         return 0x04; // Attract
     }
-    if (atp_level < 10.0f || serotonin_level < 0.2f) {
+    if (level[NEUROMOD_ATP] < TTAK_FX_CONST(10.0f) || level[NEUROMOD_SEROTONIN] < TTAK_FX_CONST(0.2f)) {
         return 0x01; // Empty
     }
-    if (stability_level > 0.6f && serotonin_level > 0.4f) {
+    if (level[NEUROMOD_STABILITY] > TTAK_FX_CONST(0.6f) && level[NEUROMOD_SEROTONIN] > TTAK_FX_CONST(0.4f)) {
         return 0x00; // Fine
     }
-    if (norepinephrine_level > 0.7f) {
+    if (level[NEUROMOD_NOREPINEPHRINE] > TTAK_FX_CONST(0.7f)) {
         return 0x06; // Terror fallback
     }
     return 0x00;
@@ -309,13 +458,13 @@ static uint8_t determine_emotion_code(void) {
 static uint8_t determine_intensity_bits(uint8_t emotion_code) {
     float measure = 0.0f;
     switch (emotion_code) {
-        case 0x00: measure = stability_level; break;
-        case 0x01: measure = 1.0f - fminf(1.0f, serotonin_level); break;
-        case 0x02: measure = (dopamine_level + oxytocin_level) * 0.5f; break;
-        case 0x03: measure = fmaxf(cortisol_level, epinephrine_level); break;
-        case 0x04: measure = fmaxf(dopamine_level, acetylcholine_level); break;
-        case 0x05: measure = fmaxf(gaba_level, 1.0f - stability_level); break;
-        case 0x06: measure = fmaxf(norepinephrine_level, epinephrine_level); break;
+        case 0x00: measure = modulator(NEUROMOD_STABILITY); break;
+        case 0x01: measure = 1.0f - modulator(NEUROMOD_SEROTONIN); break;
+        case 0x02: measure = (modulator(NEUROMOD_DOPAMINE) + modulator(NEUROMOD_OXYTOCIN)) * 0.5f; break;
+        case 0x03: measure = fmaxf(modulator(NEUROMOD_CORTISOL), modulator(NEUROMOD_EPINEPHRINE)); break;
+        case 0x04: measure = fmaxf(modulator(NEUROMOD_DOPAMINE), modulator(NEUROMOD_ACETYLCHOLINE)); break;
+        case 0x05: measure = fmaxf(modulator(NEUROMOD_GABA), 1.0f - modulator(NEUROMOD_STABILITY)); break;
+        case 0x06: measure = fmaxf(modulator(NEUROMOD_NOREPINEPHRINE), modulator(NEUROMOD_EPINEPHRINE)); break;
         default: measure = 0.0f; break;
     }
     if (measure < 0.0f) measure = 0.0f;
@@ -326,23 +475,12 @@ static uint8_t determine_intensity_bits(uint8_t emotion_code) {
     return (uint8_t)level;
 }
 
-static void send_ultrasonic_packet(uint8_t packet) {
-    if (sr04_comm < 0) {
-        return;
-    }
-    for (int bit = ULTRA_PACKET_BITS - 1; bit >= 0; --bit) {
-        bool bit_value = ((packet >> bit) & 0x1u) != 0;
-        send_ultrasonic_bit(bit_value);
-    }
-}
-
 static void worm_vocalize(void) {
-    if (atp_level > SOCIAL_VOCAL_ATP_GATE || sr04_comm < 0) {
+    if (NeuralNet_modulators()->level[NEUROMOD_ATP] > TTAK_FX_CONST(SOCIAL_VOCAL_ATP_GATE) || sr04_comm < 0) {
         return;
     }
-    struct timespec now = monotonic_now();
     if (last_vocalization_valid) {
-        int64_t delta = timespec_diff_ns(&now, &last_vocalization_ts);
+        int64_t delta = (int64_t)(tick_now_ns - last_vocalization_ns);
         if (delta < ULTRA_VOCALIZE_COOLDOWN_NS) {
             return;
         }
@@ -350,8 +488,11 @@ static void worm_vocalize(void) {
     uint8_t emotion_code = determine_emotion_code();
     uint8_t intensity_bits = determine_intensity_bits(emotion_code);
     uint8_t packet = compose_emotion_packet(emotion_code, intensity_bits);
-    send_ultrasonic_packet(packet);
-    last_vocalization_ts = now;
+    // A packet still on air keeps the cooldown open, so the next tick retries
+    if (!UltraSender_submit(&ultra_sender, packet)) {
+        return;
+    }
+    last_vocalization_ns = tick_now_ns;
     last_vocalization_valid = true;
 }
 
@@ -365,77 +506,163 @@ static float intensity_scalar(uint8_t intensity_bits) {
     return 0.25f;
 }
 
-static uint8_t receive_ultrasonic_packet(void) {
+/*
+ * Runs on the control worker as soon as sr04_comm is readable, so packets
+ * are picked up between ticks instead of only when a tick happens to poll.
+ */
+static void on_ultrasonic_readable(int fd, uint32_t events, void* ctx) {
+    (void)events;
+    (void)ctx;
+    struct ultra_rx_packet rx;
+    while (read(fd, &rx, sizeof(rx)) == (ssize_t)sizeof(rx)) {
+        if (ultra_pending_count == ULTRA_PENDING_MAX) {
+            // Keep the newest packets
+            ultra_pending_head = (ultra_pending_head + 1) % ULTRA_PENDING_MAX;
+            ultra_pending_count--;
+        }
+        ultra_pending[(ultra_pending_head + ultra_pending_count) % ULTRA_PENDING_MAX] = rx;
+        ultra_pending_count++;
+    }
+}
+
+static bool next_live_packet(struct ultra_rx_packet* rx) {
+    if (ultra_fd_driven) {
+        if (ultra_pending_count == 0) {
+            return false;
+        }
+        *rx = ultra_pending[ultra_pending_head];
+        ultra_pending_head = (ultra_pending_head + 1) % ULTRA_PENDING_MAX;
+        ultra_pending_count--;
+        return true;
+    }
     if (sr04_comm < 0 || sr04_comm_is_alias) {
-        return 0xFFu;
+        return false;
     }
-    uint8_t raw = 0;
-    ssize_t bytes = read(sr04_comm, &raw, sizeof(raw));
-    if (bytes <= 0) {
-        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-            return 0xFFu;
+    return read(sr04_comm, rx, sizeof(*rx)) == (ssize_t)sizeof(*rx);
+}
+
+// Age as of this tick: what the sender and the air added, plus our own queueing
+static uint32_t packet_age_ms(const struct ultra_rx_packet* rx) {
+    uint64_t age_ns = rx->age_ns;
+    if (tick_now_ns > rx->rx_ns) {
+        age_ns += tick_now_ns - rx->rx_ns;
+    }
+    uint64_t age_ms = age_ns / 1000000u;
+    return age_ms > ULTRA_TRACE_AGE_MAX_MS ? ULTRA_TRACE_AGE_MAX_MS : (uint32_t)age_ms;
+}
+
+/*
+ * Returns the next packet with its age. The trace keeps both, so replays
+ * apply the same age; traces from before ages existed replay as fresh.
+ */
+static bool receive_ultrasonic_packet(uint8_t* packet, uint32_t* age_ms) {
+    uint32_t recorded = 0;
+    if (trace.replaying) {
+        if (!WormTrace_take(&trace, TRACE_EVENT_ULTRA_PACKET, &recorded)) {
+            return false;
         }
-        return 0xFFu;
+    } else {
+        struct ultra_rx_packet rx;
+        // Dropped frames never reach the trace, so replays see the same traffic
+        do {
+            if (!next_live_packet(&rx)) {
+                return false;
+            }
+        } while (!UltraRxFilter_accept(&ultra_rx_filter, &rx));
+        recorded = (uint32_t)rx.packet | packet_age_ms(&rx) << ULTRA_TRACE_AGE_SHIFT;
+        WormTrace_record_event(&trace, TRACE_EVENT_ULTRA_PACKET, recorded);
     }
-    if ((raw & ULTRA_START_BIT) == 0 || (raw & ULTRA_STOP_BIT) == 0) {
-        return 0xFFu;
+    uint8_t raw = (uint8_t)recorded;
+    *age_ms = recorded >> ULTRA_TRACE_AGE_SHIFT;
+    *packet = (raw & ULTRA_START_BIT) && (raw & ULTRA_STOP_BIT) ? raw & 0x7Fu : 0xFFu;
+    return true;
+}
+
+// 1 while fresh, fading linearly to 0 at ULTRA_AGE_STALE_MS
+static float freshness(uint32_t age_ms) {
+    if (age_ms <= ULTRA_AGE_FRESH_MS) {
+        return 1.0f;
+    }
+    if (age_ms >= ULTRA_AGE_STALE_MS) {
+        return 0.0f;
     }
-    return raw & 0x7Fu;
+    return (float)(ULTRA_AGE_STALE_MS - age_ms) / (float)(ULTRA_AGE_STALE_MS - ULTRA_AGE_FRESH_MS);
 }
 
-static void apply_received_emotion(uint8_t emotion_code, uint8_t intensity_bits) {
-    float scalar = intensity_scalar(intensity_bits);
+static void apply_received_emotion(uint8_t emotion_code, uint8_t intensity_bits, uint32_t age_ms) {
+    float scalar = intensity_scalar(intensity_bits) * freshness(age_ms);
+    if (scalar <= 0.0f) {
+        return;
+    }
+    NeuroModDelta_t delta;
+    NeuroMod_delta_init(&delta);
     switch (emotion_code & 0x7u) {
         case 0x00: // Fine
-            serotonin_level = fminf(1.0f, serotonin_level + 0.05f * scalar);
-            stability_level = fminf(1.0f, stability_level + 0.03f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_SEROTONIN, ttak_fx_from_float(0.05f * scalar));
+            NeuroMod_add(&delta, NEUROMOD_STABILITY, ttak_fx_from_float(0.03f * scalar));
             break;
         case 0x01: // Empty
             exploration_drive = fminf(1.5f, exploration_drive + 0.2f * scalar);
-            norepinephrine_level = fminf(1.0f, norepinephrine_level + 0.05f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_NOREPINEPHRINE, ttak_fx_from_float(0.05f * scalar));
             break;
         case 0x02: // Bond
-            oxytocin_level = fminf(1.0f, oxytocin_level + 0.1f * scalar);
-            stability_level = fminf(1.0f, stability_level + 0.08f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_OXYTOCIN, ttak_fx_from_float(0.1f * scalar));
+            NeuroMod_add(&delta, NEUROMOD_STABILITY, ttak_fx_from_float(0.08f * scalar));
             break;
         case 0x03: // Pain
-            cortisol_level = fminf(1.0f, cortisol_level + 0.15f * scalar);
-            epinephrine_level = fminf(1.0f, epinephrine_level + 0.2f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_CORTISOL, ttak_fx_from_float(0.15f * scalar));
+            NeuroMod_add(&delta, NEUROMOD_EPINEPHRINE, ttak_fx_from_float(0.2f * scalar));
             break;
         case 0x04: // Attract
-            dopamine_level = fminf(1.0f, dopamine_level + 0.08f * scalar);
-            acetylcholine_level = fminf(1.0f, acetylcholine_level + 0.05f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_DOPAMINE, ttak_fx_from_float(0.08f * scalar));
+            NeuroMod_ceiling(&delta, NEUROMOD_DOPAMINE, TTAK_FX_ONE);
+            NeuroMod_add(&delta, NEUROMOD_ACETYLCHOLINE, ttak_fx_from_float(0.05f * scalar));
             break;
         case 0x05: // Repel
-            dopamine_level = fmaxf(-1.0f, dopamine_level - 0.05f * scalar);
-            stability_level = fmaxf(0.0f, stability_level - 0.07f * scalar);
-            gaba_level = fminf(1.0f, gaba_level + 0.04f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_DOPAMINE, ttak_fx_from_float(-0.05f * scalar));
+            NeuroMod_floor(&delta, NEUROMOD_DOPAMINE, -TTAK_FX_ONE);
+            NeuroMod_add(&delta, NEUROMOD_STABILITY, ttak_fx_from_float(-0.07f * scalar));
+            NeuroMod_add(&delta, NEUROMOD_GABA, ttak_fx_from_float(0.04f * scalar));
             break;
         case 0x06: // Terror
-            epinephrine_level = fminf(1.0f, epinephrine_level + 0.25f * scalar);
-            cortisol_level = fminf(1.0f, cortisol_level + 0.2f * scalar);
-            stability_level = fmaxf(0.0f, stability_level - 0.15f * scalar);
+            NeuroMod_add(&delta, NEUROMOD_EPINEPHRINE, ttak_fx_from_float(0.25f * scalar));
+            NeuroMod_add(&delta, NEUROMOD_CORTISOL, ttak_fx_from_float(0.2f * scalar));
+            NeuroMod_add(&delta, NEUROMOD_STABILITY, ttak_fx_from_float(-0.15f * scalar));
             break;
         default:
-            break;
+            return;
     }
+    NeuralNet_modulate(&delta);
 }
 
 static void worm_listen(void) {
-    for (int i = 0; i < 4; ++i) {
-        uint8_t packet = receive_ultrasonic_packet();
-        if (packet == 0xFFu) {
+    // Polling reads at most four packets per tick; the fd task queue is drained completely
+    int budget = ultra_fd_driven ? ULTRA_PENDING_MAX : 4;
+    for (int i = 0; i < budget; ++i) {
+        uint8_t packet = 0;
+        uint32_t age_ms = 0;
+        if (!receive_ultrasonic_packet(&packet, &age_ms)) {
             break;
         }
+        if (packet == 0xFFu) {
+            continue;
+        }
         uint8_t emotion = (packet >> 3) & 0x7u;
         uint8_t intensity = (packet >> 1) & 0x3u;
-        apply_received_emotion(emotion, intensity);
+        apply_received_emotion(emotion, intensity, age_ms);
     }
 }
 
 void worm_task(void* ctx) {
     WormRuntime_t* runtime = (WormRuntime_t*)ctx;
 
+    if (trace.replaying) {
+        tick_now_ns = trace.tick_ns;
+    } else {
+        tick_now_ns = monotonic_now_ns();
+        WormTrace_record_tick(&trace, tick_now_ns);
+    }
+
     runtime->prev_dist_input = runtime->sensory_input[SENSOR_NEURON_DIST_IDX];
     runtime->prev_host_input_l = runtime->sensory_input[SENSOR_NEURON_HOST_L_IDX];
     runtime->prev_host_input_r = runtime->sensory_input[SENSOR_NEURON_HOST_R_IDX];
@@ -445,27 +672,30 @@ void worm_task(void* ctx) {
     float max_sensory_input = fmaxf(runtime->sensory_input[SENSOR_NEURON_DIST_IDX],
                                     fmaxf(runtime->sensory_input[SENSOR_NEURON_HOST_L_IDX],
                                           runtime->sensory_input[SENSOR_NEURON_HOST_R_IDX]));
-    acetylcholine_level = fminf(1.0f, max_sensory_input * 1.5f);
+    // The tick's modulator changes are collected into one delta and applied together
+    NeuroModDelta_t delta;
+    NeuroMod_delta_init(&delta);
+    NeuroMod_set(&delta, NEUROMOD_ACETYLCHOLINE, ttak_fx_from_float(max_sensory_input * 1.5f));
 
     float conflicting_signals = fabsf(runtime->sensory_input[SENSOR_NEURON_DIST_IDX] -
                                       (runtime->sensory_input[SENSOR_NEURON_HOST_L_IDX] +
                                        runtime->sensory_input[SENSOR_NEURON_HOST_R_IDX]) / 2.0f);
-    gaba_level = fminf(1.0f, conflicting_signals);
+    NeuroMod_set(&delta, NEUROMOD_GABA, ttak_fx_from_float(conflicting_signals));
 
     if (runtime->sensory_input[SENSOR_NEURON_DIST_IDX] > 0.9f) {
-        epinephrine_level = 1.0f;
-        cortisol_level = fminf(1.0f, cortisol_level + 0.2f);
+        NeuroMod_set(&delta, NEUROMOD_EPINEPHRINE, TTAK_FX_ONE);
+        NeuroMod_add(&delta, NEUROMOD_CORTISOL, TTAK_FX_CONST(0.2f));
     } else {
-        epinephrine_level *= 0.99f;
-        cortisol_level *= 0.995f;
+        NeuroMod_scale(&delta, NEUROMOD_EPINEPHRINE, TTAK_FX_CONST(0.99f));
+        NeuroMod_scale(&delta, NEUROMOD_CORTISOL, TTAK_FX_CONST(0.995f));
     }
 
     if (max_sensory_input > 0.5f) {
-        norepinephrine_level = fminf(1.0f, norepinephrine_level + 0.1f);
-        glutamate_level = fminf(1.0f, glutamate_level + 0.1f);
+        NeuroMod_add(&delta, NEUROMOD_NOREPINEPHRINE, TTAK_FX_CONST(0.1f));
+        NeuroMod_add(&delta, NEUROMOD_GLUTAMATE, TTAK_FX_CONST(0.1f));
     } else {
-        norepinephrine_level *= 0.99f;
-        glutamate_level *= 0.99f;
+        NeuroMod_scale(&delta, NEUROMOD_NOREPINEPHRINE, TTAK_FX_CONST(0.99f));
+        NeuroMod_scale(&delta, NEUROMOD_GLUTAMATE, TTAK_FX_CONST(0.99f));
     }
 
     bool getting_closer_to_obstacle = (runtime->sensory_input[SENSOR_NEURON_DIST_IDX] >
@@ -482,41 +712,46 @@ void worm_task(void* ctx) {
     float actual_reward = 0.0f;
     if (getting_closer_to_host) {
         actual_reward = 1.0f;
-        endorphin_level = fminf(1.0f, endorphin_level + 0.1f);
-        oxytocin_level = fminf(1.0f, oxytocin_level + 0.1f);
+        NeuroMod_add(&delta, NEUROMOD_ENDORPHIN, TTAK_FX_CONST(0.1f));
+        NeuroMod_add(&delta, NEUROMOD_OXYTOCIN, TTAK_FX_CONST(0.1f));
     } else if (getting_further_from_host) {
         actual_reward = -0.5f;
-        endorphin_level *= 0.99f;
-        oxytocin_level *= 0.99f;
+        NeuroMod_scale(&delta, NEUROMOD_ENDORPHIN, TTAK_FX_CONST(0.99f));
+        NeuroMod_scale(&delta, NEUROMOD_OXYTOCIN, TTAK_FX_CONST(0.99f));
     } else if (getting_closer_to_obstacle) {
         actual_reward = -1.0f;
-        endorphin_level *= 0.99f;
-        oxytocin_level *= 0.99f;
+        NeuroMod_scale(&delta, NEUROMOD_ENDORPHIN, TTAK_FX_CONST(0.99f));
+        NeuroMod_scale(&delta, NEUROMOD_OXYTOCIN, TTAK_FX_CONST(0.99f));
     } else {
-        endorphin_level *= 0.995f;
-        oxytocin_level *= 0.995f;
+        NeuroMod_scale(&delta, NEUROMOD_ENDORPHIN, TTAK_FX_CONST(0.995f));
+        NeuroMod_scale(&delta, NEUROMOD_OXYTOCIN, TTAK_FX_CONST(0.995f));
     }
 
-    dopamine_level = actual_reward - expected_reward;
-    expected_reward = expected_reward + RPE_LEARNING_RATE * dopamine_level;
+    float reward_error = actual_reward - expected_reward;
+    expected_reward = expected_reward + RPE_LEARNING_RATE * reward_error;
+    NeuroMod_set(&delta, NEUROMOD_DOPAMINE, ttak_fx_from_float(reward_error));
 
-    if (dopamine_level > 0.0f) {
-        serotonin_level *= 0.99f;
+    if (reward_error > 0.0f) {
+        NeuroMod_scale(&delta, NEUROMOD_SEROTONIN, TTAK_FX_CONST(0.99f));
     } else {
-        serotonin_level = fminf(1.0f, serotonin_level + 0.01f);
+        NeuroMod_add(&delta, NEUROMOD_SEROTONIN, TTAK_FX_CONST(0.01f));
     }
 
-    float hormonal_flux = fabsf(dopamine_level) + fabsf(serotonin_level);
+    // Stability reacts to this tick's serotonin, so preview the delta on a copy
+    NeuroModulators_t next = *NeuralNet_modulators();
+    NeuroMod_apply(&next, &delta);
+    float hormonal_flux = fabsf(reward_error) + ttak_fx_to_float(next.level[NEUROMOD_SEROTONIN]);
     if (hormonal_flux < 0.2f && actual_reward >= 0.0f) {
-        stability_level = fminf(1.0f, stability_level + 0.05f);
+        NeuroMod_add(&delta, NEUROMOD_STABILITY, TTAK_FX_CONST(0.05f));
     } else {
-        stability_level = fmaxf(0.0f, stability_level - 0.1f);
+        NeuroMod_add(&delta, NEUROMOD_STABILITY, TTAK_FX_CONST(-0.1f));
     }
 
-    bool rest_mode = (atp_level <= ATP_REST_THRESHOLD);
+    bool rest_mode = next.level[NEUROMOD_ATP] <= TTAK_FX_CONST(ATP_REST_THRESHOLD);
     if (rest_mode) {
-        serotonin_level = fminf(1.0f, fmaxf(serotonin_level, 0.8f));
+        NeuroMod_floor(&delta, NEUROMOD_SEROTONIN, TTAK_FX_CONST(0.8f));
     }
+    NeuralNet_modulate(&delta);
 
     worm_listen();
     worm_vocalize();
@@ -526,7 +761,7 @@ void worm_task(void* ctx) {
     float final_left_output = runtime->motor_output[0];
     float final_right_output = runtime->motor_output[1];
 
-    if (epinephrine_level > 0.5f) {
+    if (NeuralNet_modulators()->level[NEUROMOD_EPINEPHRINE] > TTAK_FX_CONST(0.5f)) {
         final_left_output = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
         final_right_output = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
     }
@@ -537,47 +772,468 @@ void worm_task(void* ctx) {
     }
 
     float final_motor_output[2] = {final_left_output, final_right_output};
-    MotorTelemetry_t telemetry = send_motor_outputs(final_motor_output, rest_mode);
+    RemoteDrive_t drive;
+    bool remote = take_remote_drive(&drive);
+    MotorTelemetry_t telemetry = send_motor_outputs(final_motor_output, rest_mode, remote ? &drive : NULL);
+    if (remote_enabled) {
+        update_remote_state(runtime, &telemetry, rest_mode, remote);
+    }
 
     update_energy_budget((float)telemetry.left_speed, (float)telemetry.right_speed, rest_mode);
 }
 
-int main(void) {
-    motor = open(DEVNAME, O_RDWR);
-    if (motor < 0) { perror("Failed to open motor device"); return -1; }
-    sr04_sensor = open(SR04, O_RDWR);
-    if (sr04_sensor < 0) { perror("Failed to open sr04 device"); close(motor); return -1; }
-    sr04_comm = open(SR04, O_RDWR | O_NONBLOCK);
+static void report_task_stats(const char* name, const ttak_task_t* task) {
+    if (task == NULL || task->stats.runs == 0) {
+        return;
+    }
+    const ttak_task_stats_t* stats = &task->stats;
+    printf("%s task: %llu runs, %llu overruns, %llu skipped periods, "
+           "lateness avg %.1f us max %.1f us, exec avg %.1f us max %.1f us\n",
+           name, (unsigned long long)stats->runs, (unsigned long long)stats->overruns,
+           (unsigned long long)stats->skipped_periods,
+           (double)stats->total_lateness_ns / (double)stats->runs / 1000.0,
+           (double)stats->max_lateness_ns / 1000.0,
+           (double)stats->total_exec_ns / (double)stats->runs / 1000.0,
+           (double)stats->max_exec_ns / 1000.0);
+}
+
+static void report_plasticity_stats(void);
+static void report_vocalization_stats(void);
+static void report_vision_stats(void);
+static void report_hub_stats(void);
+static void report_bus_stats(void);
+static void report_remote_stats(void);
+static void report_motor_watchdog(void);
+
+static void report_schedule_stats(void) {
+    report_task_stats("Control", control_task);
+    report_task_stats("Checkpoint", checkpoint_task);
+    report_task_stats("Plasticity", plasticity_task);
+    report_plasticity_stats();
+    report_vocalization_stats();
+    report_vision_stats();
+    report_hub_stats();
+    report_bus_stats();
+    report_remote_stats();
+    report_motor_watchdog();
+    printf("Arena: %zu bytes in use, peak %zu, %zu blocks mapped (%zu bytes)\n",
+           ttak_arena_used(&neural_arena), neural_arena.high_watermark,
+           neural_arena.block_count, neural_arena.mapped_bytes);
+}
+
+static void report_plasticity_stats(void) {
+    NeuralPlasticityStats_t stats;
+    NeuralNet_plasticity_stats(&stats);
+    printf("Plasticity: %llu plans applied, %llu synapses pruned, %llu grown, %zu live\n",
+           (unsigned long long)stats.applied, (unsigned long long)stats.pruned,
+           (unsigned long long)stats.grown, stats.synapses);
+}
+
+static void report_vocalization_stats(void) {
+    UltraSenderStats_t stats;
+    UltraSender_stats(&ultra_sender, &stats);
+    printf("Vocalization: %llu packets sent, %llu aborted, %llu refused while busy, %llu trigger writes failed, "
+           "worst edge %.1f us late\n",
+           (unsigned long long)stats.packets, (unsigned long long)stats.aborted, (unsigned long long)stats.busy,
+           (unsigned long long)stats.failed_edges, (double)stats.max_edge_late_ns / 1000.0);
+    printf("Heard: %llu own frames and %llu repeated frames dropped\n",
+           (unsigned long long)ultra_rx_filter.own, (unsigned long long)ultra_rx_filter.repeats);
+}
+
+static void report_vision_stats(void) {
+    VisionLinkStats_t stats;
+    VisionLink_stats(&vision_link, &stats);
+    printf("Vision: %llu fresh samples, %llu stale, frame-to-neuron latency avg %.1f ms max %.1f ms\n",
+           (unsigned long long)stats.fresh, (unsigned long long)stats.stale,
+           stats.fresh ? (double)stats.age_sum_ns / (double)stats.fresh / 1e6 : 0.0,
+           (double)stats.max_age_ns / 1e6);
+}
+
+static void report_hub_stats(void) {
+    HubLinkStats_t stats;
+    HubLink_stats(&hub_link, &stats);
+    printf("Sensor hub: %llu distances from the hub, %llu stale, measurement-to-neuron latency avg %.1f ms max %.1f ms\n",
+           (unsigned long long)stats.fresh, (unsigned long long)stats.stale,
+           stats.fresh ? (double)stats.age_sum_ns / (double)stats.fresh / 1e6 : 0.0,
+           (double)stats.max_age_ns / 1e6);
+}
+
+static void report_bus_stats(void) {
+    if (!bus_enabled) {
+        return;
+    }
+    HubLinkStats_t stats;
+    HubLink_stats(&hub_link, &stats);
+    printf("Motor bus: %llu setpoints posted, %llu while owner, %llu slots reclaimed\n",
+           (unsigned long long)stats.posted, (unsigned long long)stats.owned, (unsigned long long)stats.reclaims);
+}
+
+static void report_remote_stats(void) {
+    if (!remote_enabled) {
+        return;
+    }
+    report_task_stats("Remote", remote_task);
+    const RemoteLinkStats_t* stats = &remote_link.stats;
+    printf("Remote link: %llu states sent, %llu dropped, %llu commands accepted, %llu stale, "
+           "%llu out of order, %llu malformed, oldest accepted basis %.1f ms\n",
+           (unsigned long long)stats->states_sent, (unsigned long long)stats->send_dropped,
+           (unsigned long long)stats->commands, (unsigned long long)stats->stale,
+           (unsigned long long)stats->out_of_order, (unsigned long long)stats->malformed,
+           (double)stats->max_command_age_ns / 1e6);
+}
+
+static void report_motor_watchdog(void) {
+    struct motor_watchdog watchdog = {0};
+    if (motor < 0 || ioctl(motor, PI_CMD_WATCHDOG_GET, &watchdog) != 0) {
+        return;
+    }
+    printf("Motor watchdog: %u ms, %u stops this run, %u since the driver loaded\n",
+           watchdog.timeout_ms, watchdog.trips, watchdog.total_trips);
+}
+
+static void plasticity_tick(void* ctx) {
+    (void)ctx;
+    NeuralNet_plasticity_plan();
+}
+
+static void checkpoint_tick(void* ctx) {
+    NeuralCheckpoint_run_once((NeuralCheckpoint_t*)ctx);
+}
+
+/*
+ * Control loop on a SCHED_FIFO worker pinned to the last core, background
+ * work on a SCHED_IDLE worker. The telemetry writer keeps its own thread.
+ */
+static void setup_pool(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const ttak_worker_attr_t attrs[2] = {
+        [CONTROL_WORKER] = {
+            .policy = TTAK_WORKER_FIFO,
+            .rt_priority = CONTROL_RT_PRIORITY,
+            .cpu = cpus > 1 ? (int)cpus - 1 : -1,
+        },
+        [BACKGROUND_WORKER] = {
+            .policy = TTAK_WORKER_IDLE,
+            .cpu = -1,
+        },
+    };
+    // Every task below is added to this pool, so there is nothing to run without it
+    const size_t workers = sizeof(attrs) / sizeof(attrs[0]);
+    if (!ttak_pool_init(&sched_pool, workers, attrs)) {
+        fprintf(stderr, "Failed to set up the scheduling pool: %zu workers requested, at most %d supported\n",
+                workers, TTAK_POOL_MAX_WORKERS);
+        exit(1);
+    }
+}
+
+static void setup_runtime(void) {
+    // Grows in mmap'd blocks as the network, rings and runtime are allocated
+    ttak_arena_init_growable(&neural_arena, NULL, 0, ARENA_BLOCK_SIZE);
+    worm_runtime = (WormRuntime_t*)ttak_arena_alloc(&neural_arena, sizeof(WormRuntime_t), sizeof(void*));
+    if (worm_runtime == NULL) {
+        perror("Failed to allocate worm runtime");
+        exit(1);
+    }
+}
+
+/*
+ * Feeds a recorded trace through worm_task as fast as possible and prints
+ * the resulting motor commands as CSV, for diffing controller changes.
+ */
+static int run_replay(const char* trace_path) {
+    uint32_t seed = 0;
+    if (!WormTrace_replay_open(&trace, trace_path, &seed)) {
+        return 1;
+    }
+    srand(seed);
+    setup_runtime();
+
+    char net_path[512];
+    snprintf(net_path, sizeof(net_path), "%s.net", trace_path);
+    NeuralNet_load(net_path, &neural_arena);
+    NeuralNet_plasticity_init(&neural_arena);
+
+    /*
+     * Plans run inline every plasticity_ticks ticks, so replays are
+     * deterministic. A live run plans on the background worker by the wall
+     * clock and applies the plan at whatever step comes next, and the trace
+     * does not record either point, so topology changes only approximate
+     * the recorded run's.
+     */
+    const size_t plasticity_ticks = PLASTICITY_INTERVAL_MS * 1000u / CONTROL_INTERVAL_US;
+    puts("tick,left,right,rest");
+    uint64_t start_ns = monotonic_now_ns();
+    size_t ticks = 0;
+    while (WormTrace_next_tick(&trace)) {
+        worm_task(worm_runtime);
+        ++ticks;
+        if (ticks % plasticity_ticks == 0) {
+            NeuralNet_plasticity_plan();
+        }
+    }
+    double elapsed_s = (double)(monotonic_now_ns() - start_ns) / 1e9;
+    fprintf(stderr, "Replayed %zu ticks in %.3f s (%.0f ticks/s)\n",
+            ticks, elapsed_s, elapsed_s > 0.0 ? (double)ticks / elapsed_s : 0.0);
+    NeuralPlasticityStats_t plasticity;
+    NeuralNet_plasticity_stats(&plasticity);
+    fprintf(stderr, "Plasticity: %llu plans applied, %llu synapses pruned, %llu grown, %zu live\n",
+            (unsigned long long)plasticity.applied, (unsigned long long)plasticity.pruned,
+            (unsigned long long)plasticity.grown, plasticity.synapses);
+    if (plasticity.applied > 0) {
+        fprintf(stderr, "Plans ran every %zu ticks here, not when the live planner ran, so the output only "
+                "approximates the recorded run from the first plan on\n", plasticity_ticks);
+    }
+    WormTrace_close(&trace);
+    return 0;
+}
+
+/*
+ * Writes the saved network as a connectome CSV, e.g. to edit it and load
+ * it back with --connectome. Needs no devices.
+ */
+static int run_export(const char* export_path, const char* connectome_path) {
+    setup_runtime();
+    NeuralCheckpoint_restore(NN_SAVE_FILE, &neural_arena);
+    if (connectome_path != NULL && !NeuralNet_use_connectome(connectome_path, &neural_arena)) {
+        return 1;
+    }
+    if (!NeuralNet_export_connectome(export_path)) {
+        return 1;
+    }
+    printf("Connectome written to '%s'.\n", export_path);
+    return 0;
+}
+
+// Cars differ in their hostname, so fold an FNV-1a hash of it into the sender byte
+static uint8_t default_social_id(void) {
+    char host[256] = {0};
+    uint32_t hash = 2166136261u;
+    if (gethostname(host, sizeof(host) - 1) == 0) {
+        for (const char* c = host; *c != '\0'; ++c) {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        }
+    }
+    return (uint8_t)(hash ^ hash >> 8 ^ hash >> 16 ^ hash >> 24);
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--connectome FILE] [--substeps K] [--social-id ID] "
+            "[--remote HOST[:PORT] [--remote-rate HZ]] [--bus PRIORITY] "
+            "[--record TRACE | --replay TRACE | --export-connectome FILE]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* connectome_path = NULL;
+    const char* export_path = NULL;
+    bool social_id_set = false;
+    const char* remote_peer = NULL;
+    unsigned long remote_rate_hz = REMOTE_DEFAULT_RATE_HZ;
+    unsigned long bus_priority = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--connectome") == 0 && i + 1 < argc) {
+            connectome_path = argv[++i];
+        } else if (strcmp(argv[i], "--export-connectome") == 0 && i + 1 < argc) {
+            export_path = argv[++i];
+        } else if (strcmp(argv[i], "--substeps") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            unsigned long substeps = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || substeps < 1 || substeps > NEURAL_MAX_SUBSTEPS) {
+                fprintf(stderr, "--substeps takes 1 to %d\n", NEURAL_MAX_SUBSTEPS);
+                return 2;
+            }
+            NeuralNet_set_substeps((unsigned)substeps);
+        } else if (strcmp(argv[i], "--social-id") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            unsigned long id = strtoul(argv[++i], &end, 0);
+            if (*end != '\0' || id > UINT8_MAX) {
+                fprintf(stderr, "--social-id takes 0 to %d\n", UINT8_MAX);
+                return 2;
+            }
+            social_id = (uint8_t)id;
+            social_id_set = true;
+        } else if (strcmp(argv[i], "--remote") == 0 && i + 1 < argc) {
+            remote_peer = argv[++i];
+        } else if (strcmp(argv[i], "--remote-rate") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            remote_rate_hz = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || remote_rate_hz < 1 || remote_rate_hz > REMOTE_MAX_RATE_HZ) {
+                fprintf(stderr, "--remote-rate takes 1 to %d\n", REMOTE_MAX_RATE_HZ);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--bus") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            bus_priority = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || bus_priority < 1 || bus_priority > MOTOR_BUS_MAX_PRIORITY) {
+                fprintf(stderr, "--bus takes a priority of 1 to %d\n", MOTOR_BUS_MAX_PRIORITY);
+                return 2;
+            }
+            bus_enabled = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    // A replay takes its network, connectome included, from the trace
+    if (replay_path != NULL) {
+        return record_path == NULL && connectome_path == NULL && export_path == NULL
+                   ? run_replay(replay_path) : (usage(argv[0]), 2);
+    }
+    if (export_path != NULL) {
+        return record_path == NULL ? run_export(export_path, connectome_path) : (usage(argv[0]), 2);
+    }
+
+    HubLink_init(&hub_link);
+    if (bus_enabled) {
+        // The hub stops the car when this process stops beating, like the driver's watchdog would
+        if (!HubLink_join_bus(&hub_link, (uint32_t)bus_priority, "worm", monotonic_now_ns())) {
+            fprintf(stderr, "Motor bus unavailable; is sensor_hub running with /dev/motor?\n");
+            return -1;
+        }
+    } else {
+        motor = open(DEVNAME, O_RDWR);
+        if (motor < 0) { perror("Failed to open motor device"); return -1; }
+        // A hung or stalled worm must not leave the car driving its last command
+        struct motor_watchdog watchdog = {.timeout_ms = MOTOR_WATCHDOG_MS};
+        if (ioctl(motor, PI_CMD_WATCHDOG_SET, &watchdog) != 0) {
+            perror("Motor watchdog unavailable");
+        }
+    }
+    // With a sensor hub running the worm leaves ranging to it and only opens the SR04 as a fallback
+    uint32_t hub_distance = 0;
+    bool hub_ranging = HubLink_distance(&hub_link, monotonic_now_ns(), &hub_distance);
+    if (!hub_ranging) {
+        sr04_sensor = open(SR04, O_RDWR);
+        if (sr04_sensor < 0) {
+            perror("Failed to open sr04 device");
+            HubLink_close(&hub_link);
+            if (motor >= 0) {
+                close(motor);
+            }
+            return -1;
+        }
+    }
+    sr04_comm = open(SR04_COMM, O_RDWR | O_NONBLOCK);
     if (sr04_comm < 0) {
         perror("SR04 social channel unavailable, falling back to sensor descriptor");
+        if (sr04_sensor < 0) {
+            sr04_sensor = open(SR04, O_RDWR);
+        }
         sr04_comm = sr04_sensor;
         sr04_comm_is_alias = true;
     }
+    // The camera process may start later; the link maps its block once it appears
+    VisionLink_init(&vision_link);
+    // Name resolution may block, so it happens here and never in the control loop
+    if (remote_peer != NULL) {
+        remote_enabled = RemoteLink_open(&remote_link, remote_peer);
+        if (!remote_enabled) {
+            fprintf(stderr, "Remote link unavailable, driving autonomously.\n");
+        }
+    }
 
-    signal(SIGINT, sigHandler);
-    srand((unsigned int)time(NULL));
+    // Block the stop signals before any thread exists so only sigwait below sees them
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
 
-    ttak_arena_init(&neural_arena, neural_heap, sizeof(neural_heap));
-    worm_runtime = (WormRuntime_t*)ttak_arena_alloc(&neural_arena, sizeof(WormRuntime_t), sizeof(void*));
-    memset(worm_runtime, 0, sizeof(WormRuntime_t));
+    unsigned int seed = (unsigned int)time(NULL);
+    srand(seed);
+
+    setup_runtime();
+
+    setup_pool();
 
-    scheduler_slots = (ttak_task_t*)ttak_arena_alloc(&neural_arena, sizeof(ttak_task_t) * 4, sizeof(void*));
-    ttak_sched_init(&scheduler, scheduler_slots, 4);
+    NeuralCheckpoint_restore(NN_SAVE_FILE, &neural_arena);
+    if (connectome_path != NULL && !NeuralNet_use_connectome(connectome_path, &neural_arena)) {
+        fprintf(stderr, "Connectome '%s' unusable, keeping the current network.\n", connectome_path);
+    }
+    if (NeuralCheckpoint_init(&checkpoint, NN_SAVE_FILE, CHECKPOINT_PAGE_BUDGET)) {
+        checkpoint_task = ttak_pool_add_task(&sched_pool, BACKGROUND_WORKER, checkpoint_tick, &checkpoint,
+                                             CHECKPOINT_INTERVAL_MS * 1000u, 0, TTAK_CATCHUP_DRIFT);
+    }
+    if (checkpoint_task == NULL) {
+        fprintf(stderr, "Background checkpointing unavailable, weights are saved on exit only.\n");
+    }
+    if (NeuralNet_plasticity_init(&neural_arena)) {
+        plasticity_task = ttak_pool_add_task(&sched_pool, BACKGROUND_WORKER, plasticity_tick, NULL,
+                                             PLASTICITY_INTERVAL_MS * 1000u, 0, TTAK_CATCHUP_DRIFT);
+    }
 
-    NeuralNet_load(NN_SAVE_FILE, &neural_arena);
+    const ttak_tlog_config_t telemetry_config = {
+        .path = TELEMETRY_FILE,
+        .record_kind = TELEMETRY_KIND_WORM,
+        .record_size = sizeof(WormTelemetry_t),
+        .segment_records = TELEMETRY_SEGMENT_RECORDS,
+        .keep_segments = TELEMETRY_KEEP_SEGMENTS,
+    };
+    void* telemetry_slots = ttak_arena_alloc_uninit(&neural_arena, sizeof(WormTelemetry_t) * TELEMETRY_RING_SLOTS,
+                                                    sizeof(void*));
+    if (!ttak_tlog_open(&telemetry_log, &telemetry_config, telemetry_slots, TELEMETRY_RING_SLOTS)) {
+        fprintf(stderr, "Telemetry log unavailable, continuing without it.\n");
+    }
 
-    ttak_sched_add(&scheduler, worm_task, worm_runtime, CONTROL_INTERVAL_US);
+    if (record_path != NULL) {
+        char net_path[512];
+        snprintf(net_path, sizeof(net_path), "%s.net", record_path);
+        NeuralNet_save(net_path);
+        void* trace_slots = ttak_arena_alloc_uninit(&neural_arena, sizeof(WormTraceRecord_t) * TRACE_RING_SLOTS,
+                                                    sizeof(void*));
+        if (WormTrace_record_open(&trace, record_path, seed, trace_slots, TRACE_RING_SLOTS)) {
+            printf("Recording sensor trace to '%s'.\n", record_path);
+        } else {
+            fprintf(stderr, "Failed to open trace '%s', recording disabled.\n", record_path);
+        }
+    }
 
-    puts("Neural network control loop started. Learning enabled.");
-    ttak_sched_run_loop(&scheduler);
+    if (!social_id_set) {
+        social_id = default_social_id();
+    }
+    UltraRxFilter_init(&ultra_rx_filter, social_id);
+    if (!UltraSender_start(&ultra_sender, sr04_comm, social_id, ULTRA_SENDER_RT_PRIORITY)) {
+        fprintf(stderr, "Ultrasonic sender unavailable, the worm stays silent.\n");
+    }
 
-    ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
-    close(motor);
-    if (!sr04_comm_is_alias && sr04_comm >= 0) {
-        close(sr04_comm);
+    control_task = ttak_pool_add_task(&sched_pool, CONTROL_WORKER, worm_task, worm_runtime, CONTROL_INTERVAL_US,
+                                      CONTROL_EXEC_HINT_US, TTAK_CATCHUP_SKIP);
+    // Same worker as the control task, so the packet queue needs no locking
+    if (!sr04_comm_is_alias) {
+        ultra_fd_driven = ttak_pool_add_fd(&sched_pool, CONTROL_WORKER, sr04_comm, EPOLLIN,
+                                           on_ultrasonic_readable, NULL) != NULL;
+        if (!ultra_fd_driven) {
+            fprintf(stderr, "SR04 social channel cannot be polled, reading it once per tick.\n");
+        }
     }
-    if (sr04_sensor >= 0) {
-        close(sr04_sensor);
+    // Commands are read between ticks on the control worker, so the drive needs no locking either
+    // The pool cannot drop a task again, so the fd goes first and the state task only once it is in.
+    // Should the task fail after that, the fd keeps draining the socket while the drive ignores it.
+    if (remote_enabled) {
+        if (ttak_pool_add_fd(&sched_pool, CONTROL_WORKER, remote_link.fd, EPOLLIN, on_remote_readable, NULL) != NULL) {
+            remote_task = ttak_pool_add_task(&sched_pool, CONTROL_WORKER, remote_tick, NULL,
+                                             (uint32_t)(1000000u / remote_rate_hz), 0, TTAK_CATCHUP_SKIP);
+        }
+        if (remote_task == NULL) {
+            fprintf(stderr, "Remote link cannot be scheduled, driving autonomously.\n");
+            remote_enabled = false;
+        }
+    }
+
+    if (!ttak_pool_start(&sched_pool)) {
+        fprintf(stderr, "Failed to start scheduler workers.\n");
+        shutdown_worm();
+        return -1;
     }
+    puts("Neural network control loop started. Learning enabled.");
+
+    int signal_number = 0;
+    sigwait(&stop_signals, &signal_number);
+    shutdown_worm();
     return 0;
 }
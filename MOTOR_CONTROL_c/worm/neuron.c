@@ -1,12 +1,32 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "neuron.h"
+#include "connectome.h"
 
-#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
 
-#define SAVE_FILE_VERSION 1U
+#define DELTA_FILE_VERSION 1U
+#define SNAPSHOT_MAGIC "WORMNET\0"
+#define SNAPSHOT_VERSION 2U
+#define SNAPSHOT_ENDIAN_MARK 0x01020304U
+#define SNAPSHOT_SECTION_ALIGN 4096U
+#define LEGACY_NEURON_RECORD_SIZE 44U
+#define LEGACY_SYNAPSE_RECORD_SIZE 24U
+#define FNV64_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define CONNECTOME_LINE_MAX 256
+#define CAPTURE_ATTEMPTS 8
+#define CAPTURE_RETRY_NS 1000000L
 #define FX_WEIGHT_MIN TTAK_FX_CONST(-1.5f)
 #define FX_WEIGHT_MAX TTAK_FX_CONST(1.5f)
 #define FX_STRENGTH_RECOVERY TTAK_FX_CONST(0.001f)
@@ -14,12 +34,65 @@
 #define ELIGIBILITY_DECAY_FACTOR TTAK_FX_CONST(0.95f)
 #define ELIGIBILITY_FLOOR TTAK_FX_CONST(0.05f)
 #define LEARNING_RATE_FX TTAK_FX_CONST(0.02f)
-#define ATP_STEP_DRAIN 0.02f
+#define ATP_STEP_DRAIN TTAK_FX_CONST(0.02f)
+#define ATP_LEVEL_MAX (100 * TTAK_FX_ONE)
+#define CREDIT_MIN_DOPAMINE TTAK_FX_CONST(0.0005f)
+#define CREDIT_MIN_GLUTAMATE TTAK_FX_CONST(0.1f)
+#define PLASTICITY_MAX_PRUNE 64
+#define PLASTICITY_MAX_GROW 8
+#define PLASTICITY_PRUNE_WEIGHT TTAK_FX_CONST(0.02f)
+#define PLASTICITY_PRUNE_ROUNDS 3
+// Below the prune weight: a grown synapse is dropped again unless learning strengthens it
+#define PLASTICITY_GROW_WEIGHT TTAK_FX_CONST(0.01f)
+#define PLASTICITY_GROW_MIN_COFIRE 8
+#define PLASTICITY_GROW_LIFT_PCT 150
+#define PLASTICITY_ADJACENCY_BYTES ((MAX_NEURONS + 7) / 8)
+
+_Static_assert(CONNECTOME_NEURONS <= MAX_NEURONS, "generated connectome exceeds MAX_NEURONS");
+_Static_assert(CONNECTOME_SYNAPSES <= MAX_SYNAPSES, "generated connectome exceeds MAX_SYNAPSES");
 
+// Pre-snapshot save format: offsets against the regenerated topology
 typedef struct {
     uint32_t version;
     uint32_t delta_count;
-} NeuralNetSaveHeader;
+} NeuralNetDeltaHeader;
+
+/*
+ * Snapshot file layout (version 2):
+ *   [header, padded to SNAPSHOT_SECTION_ALIGN]
+ *   [neurons section: MAX_NEURONS records, page aligned]
+ *   [edges section: MAX_SYNAPSES SynapseEdge_t records, page aligned]
+ *   [state section: MAX_SYNAPSES SynapseState_t records, page aligned]
+ * Sections are sized for full capacity so a private mapping can be used
+ * directly as the live network arrays. The edges section never changes
+ * while the network learns, so checkpoints never rewrite its pages.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_mark;
+    uint32_t header_size;
+    uint32_t section_align;
+    uint32_t neuron_count;
+    uint32_t synapse_count;
+    uint32_t neuron_capacity;
+    uint32_t synapse_capacity;
+    uint32_t neuron_record_size;
+    uint32_t edge_record_size;
+    uint32_t state_record_size;
+    uint32_t reserved;
+    uint64_t neurons_offset;
+    uint64_t edges_offset;
+    uint64_t state_offset;
+    uint64_t file_size;
+    uint64_t sequence;
+    uint64_t topology_hash;
+    uint64_t checksum;
+    uint64_t origin_hash;        // topology the network was first grown from
+    int32_t bindings[NEURAL_BIND_COUNT];
+    uint32_t reserved_tail;
+    NeuroModulators_t modulators;
+} NeuralSnapshotHeader;
 
 typedef struct {
     uint32_t index;
@@ -32,25 +105,68 @@ typedef struct {
     const char* token;
 } TypeRule;
 
+enum {
+    PLAN_IDLE,     // planner owns the plan
+    PLAN_READY,    // published, waiting for the next step
+    PLAN_APPLIED   // applied; planner remaps its per-synapse counters
+};
+
+/*
+ * Topology change computed off the control thread. source[j] names where
+ * output slot j comes from: an old synapse index, or -1 - g for grown
+ * edge g. Applying it is a single copy pass into the spare buffers.
+ */
+typedef struct {
+    int32_t* source;
+    size_t count;
+    uint32_t pruned;
+    uint32_t grown;
+    uint32_t prune[PLASTICITY_MAX_PRUNE];
+    SynapseEdge_t grow_edges[PLASTICITY_MAX_GROW];
+    SynapseState_t grow_state[PLASTICITY_MAX_GROW];
+} StructuralPlan_t;
+
+typedef struct {
+    // Double buffers the step arrays are swapped between, sized for MAX_SYNAPSES
+    SynapseEdge_t* edges[2];
+    SynapseState_t* state[2];
+    // Planner-private
+    SynapseState_t* state_copy;
+    uint64_t history_copy[MAX_NEURONS];
+    uint8_t* quiet_rounds[2];
+    int quiet_current;
+    uint8_t (*adjacency)[PLASTICITY_ADJACENCY_BYTES];
+    StructuralPlan_t plan;
+    _Atomic int plan_state;
+    NeuralPlasticityStats_t stats;
+} StructuralPlasticity_t;
+
 static Neuron_t* neurons = NULL;
-static Synapse_t* synapses = NULL;
+// Points at connectome_edges (read-only) or into a mapped snapshot
+static const SynapseEdge_t* synapse_edges = NULL;
+static SynapseState_t* synapse_state = NULL;
 static ttak_arena_t* neural_arena = NULL;
+static _Atomic uint64_t snapshot_sequence = 0;
+// Seqlock generation: odd while NeuralNet_step is mutating the arrays
+static _Atomic uint32_t state_generation = 0;
+// Bit k set when the neuron fired k steps ago; feeds growth of new synapses
+static uint64_t fire_history[MAX_NEURONS];
+// Disabled until NeuralNet_plasticity_init
+static StructuralPlasticity_t plasticity;
+static int32_t bindings[NEURAL_BIND_COUNT];
+static unsigned substep_count = 1;
+static uint64_t origin_hash = 0;
+// Writable edge table for external connectomes and copied snapshots
+static SynapseEdge_t* edge_storage = NULL;
 
 size_t neuron_count = 0;
 size_t synapse_count = 0;
 
-float dopamine_level = 0.0f;
-float serotonin_level = 0.0f;
-float acetylcholine_level = 0.0f;
-float gaba_level = 0.0f;
-float epinephrine_level = 0.0f;
-float norepinephrine_level = 0.0f;
-float glutamate_level = 0.0f;
-float endorphin_level = 0.0f;
-float oxytocin_level = 0.0f;
-float cortisol_level = 0.0f;
-float stability_level = 0.0f;
-float atp_level = 100.0f;
+static NeuroModulators_t modulators = {
+    .level = {[NEUROMOD_ATP] = ATP_LEVEL_MAX},
+};
+// Derived from the modulators at the start of each step
+static ttak_fx_t firing_threshold = 0;
 
 static void ensure_buffers(ttak_arena_t* arena) {
     if (arena == NULL) {
@@ -64,8 +180,9 @@ static void ensure_buffers(ttak_arena_t* arena) {
     if (neurons == NULL) {
         neurons = (Neuron_t*)ttak_arena_alloc(neural_arena, sizeof(Neuron_t) * MAX_NEURONS, sizeof(void*));
     }
-    if (synapses == NULL) {
-        synapses = (Synapse_t*)ttak_arena_alloc(neural_arena, sizeof(Synapse_t) * MAX_SYNAPSES, sizeof(void*));
+    if (synapse_state == NULL) {
+        synapse_state = (SynapseState_t*)ttak_arena_alloc(neural_arena, sizeof(SynapseState_t) * MAX_SYNAPSES,
+                                                          sizeof(void*));
     }
 }
 
@@ -93,65 +210,142 @@ static void reset_neurons(void) {
     }
 }
 
+static void set_builtin_bindings(void) {
+    bindings[NEURAL_BIND_DIST] = 0;
+    bindings[NEURAL_BIND_HOST_L] = 1;
+    bindings[NEURAL_BIND_HOST_R] = 2;
+    bindings[NEURAL_BIND_MOTOR_L] = CONNECTOME_NEURONS - 2;
+    bindings[NEURAL_BIND_MOTOR_R] = CONNECTOME_NEURONS - 1;
+    origin_hash = CONNECTOME_TOPOLOGY_HASH;
+}
+
+static bool ensure_edge_storage(ttak_arena_t* arena) {
+    if (edge_storage == NULL && arena != NULL) {
+        edge_storage = (SynapseEdge_t*)ttak_arena_alloc_uninit(arena, sizeof(SynapseEdge_t) * MAX_SYNAPSES,
+                                                               sizeof(void*));
+    }
+    return edge_storage != NULL;
+}
+
 static void bootstrap_network(ttak_arena_t* arena) {
     ensure_buffers(arena);
     neuron_count = NUM_NEURONS_INIT;
-    init_synapses_biological();
-    synapse_count = NUM_SYNAPSES_INIT;
-
-    for (size_t i = 0; i < synapse_count; ++i) {
-        synapses[i] = neural_synapses[i];
-        synapses[i].eligibility_trace_fx = 0;
-    }
+    synapse_count = CONNECTOME_SYNAPSES;
+    synapse_edges = connectome_edges;
+    memcpy(synapse_state, connectome_initial_state, sizeof(SynapseState_t) * CONNECTOME_SYNAPSES);
+    set_builtin_bindings();
 
     reset_neurons();
 }
 
-static ttak_fx_t get_neuron_threshold_fx(NeuronType_t type) {
-    (void)type;
-    ttak_fx_t threshold = TTAK_FX_CONST(0.1f);
-    threshold = ttak_fx_add(threshold, ttak_fx_from_float(serotonin_level * 0.1f));
-    threshold = ttak_fx_add(threshold, ttak_fx_from_float(gaba_level * 0.3f));
-    threshold = ttak_fx_add(threshold, ttak_fx_from_float(endorphin_level * 0.1f));
-    threshold = ttak_fx_add(threshold, ttak_fx_from_float(cortisol_level * 0.2f));
+void NeuroMod_delta_init(NeuroModDelta_t* delta) {
+    for (size_t i = 0; i < NEUROMOD_COUNT; ++i) {
+        delta->scale[i] = TTAK_FX_ONE;
+        delta->add[i] = 0;
+        delta->floor[i] = 0;
+        delta->ceiling[i] = TTAK_FX_ONE;
+    }
+    delta->floor[NEUROMOD_DOPAMINE] = -2 * TTAK_FX_ONE;
+    delta->ceiling[NEUROMOD_DOPAMINE] = 2 * TTAK_FX_ONE;
+    delta->ceiling[NEUROMOD_ATP] = ATP_LEVEL_MAX;
+}
 
-    threshold = ttak_fx_sub(threshold, ttak_fx_from_float(dopamine_level * 0.1f));
-    threshold = ttak_fx_sub(threshold, ttak_fx_from_float(acetylcholine_level * 0.2f));
-    threshold = ttak_fx_sub(threshold, ttak_fx_from_float(norepinephrine_level * 0.3f));
-    threshold = ttak_fx_sub(threshold, ttak_fx_from_float(glutamate_level * 0.1f));
-    threshold = ttak_fx_sub(threshold, ttak_fx_from_float(stability_level * 0.1f));
+// Branch-free over a dozen contiguous lanes so the compiler can vectorize it
+void NeuroMod_apply(NeuroModulators_t* levels, const NeuroModDelta_t* delta) {
+    for (size_t i = 0; i < NEUROMOD_COUNT; ++i) {
+        ttak_fx_t level = ttak_fx_add(ttak_fx_mul(levels->level[i], delta->scale[i]), delta->add[i]);
+        level = level < delta->floor[i] ? delta->floor[i] : level;
+        level = level > delta->ceiling[i] ? delta->ceiling[i] : level;
+        levels->level[i] = level;
+    }
+}
 
+// Every neuron type shares one threshold, shifted by the neuromodulators
+static ttak_fx_t modulated_threshold(const NeuroModulators_t* levels) {
+    const ttak_fx_t weights[NEUROMOD_COUNT] = {
+        [NEUROMOD_SEROTONIN] = TTAK_FX_CONST(0.1f),
+        [NEUROMOD_GABA] = TTAK_FX_CONST(0.3f),
+        [NEUROMOD_ENDORPHIN] = TTAK_FX_CONST(0.1f),
+        [NEUROMOD_CORTISOL] = TTAK_FX_CONST(0.2f),
+        [NEUROMOD_DOPAMINE] = TTAK_FX_CONST(-0.1f),
+        [NEUROMOD_ACETYLCHOLINE] = TTAK_FX_CONST(-0.2f),
+        [NEUROMOD_NOREPINEPHRINE] = TTAK_FX_CONST(-0.3f),
+        [NEUROMOD_GLUTAMATE] = TTAK_FX_CONST(-0.1f),
+        [NEUROMOD_STABILITY] = TTAK_FX_CONST(-0.1f),
+    };
+    ttak_fx_t threshold = TTAK_FX_CONST(0.1f);
+    for (size_t i = 0; i < NEUROMOD_COUNT; ++i) {
+        threshold = ttak_fx_add(threshold, ttak_fx_mul(levels->level[i], weights[i]));
+    }
     return threshold;
 }
 
 static void apply_temporal_credit(void) {
-    float dopamine = dopamine_level;
-    if (fabsf(dopamine) < 0.0005f) {
+    ttak_fx_t dopamine = modulators.level[NEUROMOD_DOPAMINE];
+    if (ttak_fx_abs(dopamine) < CREDIT_MIN_DOPAMINE) {
         return;
     }
 
-    ttak_fx_t dopamine_fx = ttak_fx_from_float(fabsf(dopamine));
-    ttak_fx_t glutamate_fx = ttak_fx_from_float(fmaxf(0.1f, glutamate_level));
+    ttak_fx_t dopamine_fx = ttak_fx_abs(dopamine);
+    ttak_fx_t glutamate_fx = modulators.level[NEUROMOD_GLUTAMATE];
+    if (glutamate_fx < CREDIT_MIN_GLUTAMATE) {
+        glutamate_fx = CREDIT_MIN_GLUTAMATE;
+    }
 
     for (size_t i = 0; i < synapse_count; ++i) {
-        if (synapses[i].eligibility_trace_fx < ELIGIBILITY_FLOOR) {
+        if (synapse_state[i].eligibility_trace_fx < ELIGIBILITY_FLOOR) {
             continue;
         }
 
         ttak_fx_t plasticity = ttak_fx_mul(LEARNING_RATE_FX, dopamine_fx);
         plasticity = ttak_fx_mul(plasticity, glutamate_fx);
-        plasticity = ttak_fx_mul(plasticity, synapses[i].eligibility_trace_fx);
+        plasticity = ttak_fx_mul(plasticity, synapse_state[i].eligibility_trace_fx);
 
-        if (dopamine < 0.0f) {
+        if (dopamine < 0) {
             plasticity = -plasticity;
         }
 
-        synapses[i].weight_fx = ttak_fx_clamp(
-            ttak_fx_add(synapses[i].weight_fx, plasticity),
+        synapse_state[i].weight_fx = ttak_fx_clamp(
+            ttak_fx_add(synapse_state[i].weight_fx, plasticity),
             FX_WEIGHT_MIN,
             FX_WEIGHT_MAX);
 
-        synapses[i].eligibility_trace_fx = ttak_fx_decay(synapses[i].eligibility_trace_fx, TTAK_FX_CONST(0.5f));
+        synapse_state[i].eligibility_trace_fx = ttak_fx_decay(synapse_state[i].eligibility_trace_fx, TTAK_FX_CONST(0.5f));
+    }
+}
+
+// Runs inside the step's seqlock window, so captures never see a half-swapped network
+static void apply_structural_plan(void) {
+    if (atomic_load_explicit(&plasticity.plan_state, memory_order_acquire) != PLAN_READY) {
+        return;
+    }
+
+    const StructuralPlan_t* plan = &plasticity.plan;
+    SynapseEdge_t* edges = plasticity.edges[synapse_edges == plasticity.edges[0] ? 1 : 0];
+    SynapseState_t* state = plasticity.state[synapse_state == plasticity.state[0] ? 1 : 0];
+    for (size_t j = 0; j < plan->count; ++j) {
+        int32_t source = plan->source[j];
+        if (source >= 0) {
+            edges[j] = synapse_edges[source];
+            state[j] = synapse_state[source];
+        } else {
+            edges[j] = plan->grow_edges[-1 - source];
+            state[j] = plan->grow_state[-1 - source];
+        }
+    }
+    synapse_edges = edges;
+    synapse_state = state;
+    synapse_count = plan->count;
+
+    plasticity.stats.applied++;
+    plasticity.stats.pruned += plan->pruned;
+    plasticity.stats.grown += plan->grown;
+    atomic_store_explicit(&plasticity.plan_state, PLAN_APPLIED, memory_order_release);
+}
+
+static void record_firing(void) {
+    for (size_t i = 0; i < neuron_count; ++i) {
+        fire_history[i] = (fire_history[i] << 1) | (neurons[i].activation_fx > firing_threshold ? 1u : 0u);
     }
 }
 
@@ -159,57 +353,87 @@ void NeuralNet_init(ttak_arena_t* arena) {
     bootstrap_network(arena);
 }
 
-void NeuralNet_step(const float* sensory_input, float* motor_output) {
-    if (!neurons || !synapses) {
-        return;
+void NeuralNet_set_substeps(unsigned count) {
+    if (count < 1) {
+        count = 1;
     }
+    if (count > NEURAL_MAX_SUBSTEPS) {
+        count = NEURAL_MAX_SUBSTEPS;
+    }
+    substep_count = count;
+}
+
+unsigned NeuralNet_substeps(void) {
+    return substep_count;
+}
+
+void NeuralNet_modulate(const NeuroModDelta_t* delta) {
+    // Same seqlock as NeuralNet_step, so captures pair the levels with the weights they shaped
+    uint32_t generation = atomic_load_explicit(&state_generation, memory_order_relaxed);
+    atomic_store_explicit(&state_generation, generation + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
 
-    atp_level = fmaxf(0.0f, atp_level - ATP_STEP_DRAIN);
+    NeuroMod_apply(&modulators, delta);
+
+    atomic_store_explicit(&state_generation, generation + 2, memory_order_release);
+}
+
+const NeuroModulators_t* NeuralNet_modulators(void) {
+    return &modulators;
+}
+
+/*
+ * One propagation hop. Synaptic fatigue and eligibility traces only
+ * advance when update_synapses is set, so they keep their per-tick rates
+ * however many substeps run.
+ */
+static void propagate(const float* sensory_input, bool update_synapses) {
+    const ttak_fx_t threshold = firing_threshold;
 
     for (size_t i = 0; i < neuron_count; ++i) {
         neurons[i].previous_activation_fx = neurons[i].activation_fx;
-    }
-
-    for (size_t i = 3; i < neuron_count; ++i) {
         neurons[i].activation_fx = 0;
     }
 
-    for (size_t i = 0; i < 3; ++i) {
+    for (size_t i = 0; i < NUM_SENSOR_INPUTS; ++i) {
         float bounded = sensory_input ? sensory_input[i] : 0.0f;
         if (bounded > 1.0f) bounded = 1.0f;
         if (bounded < -1.0f) bounded = -1.0f;
-        neurons[i].activation_fx = ttak_fx_swish(ttak_fx_from_float(bounded));
+        neurons[bindings[i]].activation_fx = ttak_fx_swish(ttak_fx_from_float(bounded));
     }
 
+    // Edges are sorted by from, so neurons[from] is read sequentially
     for (size_t i = 0; i < synapse_count; ++i) {
-        int from = synapses[i].from;
-        int to = synapses[i].to;
-
-        ttak_fx_t threshold_from = get_neuron_threshold_fx(neurons[from].type);
-        ttak_fx_t threshold_to = get_neuron_threshold_fx(neurons[to].type);
+        int from = synapse_edges[i].from;
+        int to = synapse_edges[i].to;
+        SynapseState_t* state = &synapse_state[i];
 
         ttak_fx_t mixed_input = ttak_fx_add(
             ttak_fx_mul(neurons[from].activation_fx, TTAK_FX_CONST(0.7f)),
             ttak_fx_mul(neurons[from].previous_activation_fx, TTAK_FX_CONST(0.3f)));
 
-        ttak_fx_t weighted = ttak_fx_mul(ttak_fx_mul(mixed_input, synapses[i].weight_fx),
-                                         synapses[i].synaptic_strength_fx);
+        ttak_fx_t weighted = ttak_fx_mul(ttak_fx_mul(mixed_input, state->weight_fx),
+                                         state->synaptic_strength_fx);
 
-        if (weighted > threshold_to) {
+        if (weighted > threshold) {
             neurons[to].activation_fx = ttak_fx_add(neurons[to].activation_fx, weighted);
         }
 
-        if (neurons[from].activation_fx > threshold_from) {
-            synapses[i].synaptic_strength_fx = ttak_fx_mul(synapses[i].synaptic_strength_fx, FX_STRENGTH_FATIGUE);
-            synapses[i].eligibility_trace_fx = TTAK_FX_ONE;
+        if (!update_synapses) {
+            continue;
+        }
+
+        if (neurons[from].activation_fx > threshold) {
+            state->synaptic_strength_fx = ttak_fx_mul(state->synaptic_strength_fx, FX_STRENGTH_FATIGUE);
+            state->eligibility_trace_fx = TTAK_FX_ONE;
         } else {
-            synapses[i].eligibility_trace_fx = ttak_fx_decay(synapses[i].eligibility_trace_fx, ELIGIBILITY_DECAY_FACTOR);
+            state->eligibility_trace_fx = ttak_fx_decay(state->eligibility_trace_fx, ELIGIBILITY_DECAY_FACTOR);
         }
 
-        if (synapses[i].synaptic_strength_fx < TTAK_FX_ONE) {
-            synapses[i].synaptic_strength_fx = ttak_fx_add(synapses[i].synaptic_strength_fx, FX_STRENGTH_RECOVERY);
-            if (synapses[i].synaptic_strength_fx > TTAK_FX_ONE) {
-                synapses[i].synaptic_strength_fx = TTAK_FX_ONE;
+        if (state->synaptic_strength_fx < TTAK_FX_ONE) {
+            state->synaptic_strength_fx = ttak_fx_add(state->synaptic_strength_fx, FX_STRENGTH_RECOVERY);
+            if (state->synaptic_strength_fx > TTAK_FX_ONE) {
+                state->synaptic_strength_fx = TTAK_FX_ONE;
             }
         }
     }
@@ -219,41 +443,342 @@ void NeuralNet_step(const float* sensory_input, float* motor_output) {
             neurons[i].activation_fx = ttak_fx_swish(neurons[i].activation_fx);
         }
     }
+}
+
+void NeuralNet_step(const float* sensory_input, float* motor_output) {
+    if (!neurons || !synapse_state) {
+        return;
+    }
 
-    if (serotonin_level > 0.5f) {
+    uint32_t generation = atomic_load_explicit(&state_generation, memory_order_relaxed);
+    atomic_store_explicit(&state_generation, generation + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    apply_structural_plan();
+
+    ttak_fx_t atp = modulators.level[NEUROMOD_ATP];
+    modulators.level[NEUROMOD_ATP] = atp > ATP_STEP_DRAIN ? atp - ATP_STEP_DRAIN : 0;
+    firing_threshold = modulated_threshold(&modulators);
+
+    // Sensors are held for the whole tick; only the last hop updates synapses
+    unsigned substeps = substep_count;
+    for (unsigned k = 1; k <= substeps; ++k) {
+        propagate(sensory_input, k == substeps);
+    }
+
+    if (modulators.level[NEUROMOD_SEROTONIN] > TTAK_FX_CONST(0.5f)) {
         for (size_t i = 0; i < synapse_count; ++i) {
-            if (synapses[i].neurotransmitter_type_fx < 0) {
-                synapses[i].weight_fx = ttak_fx_mul(synapses[i].weight_fx, TTAK_FX_CONST(0.99f));
+            if (synapse_edges[i].neurotransmitter_type_fx < 0) {
+                synapse_state[i].weight_fx = ttak_fx_mul(synapse_state[i].weight_fx, TTAK_FX_CONST(0.99f));
             }
         }
     }
 
     apply_temporal_credit();
+    record_firing();
+
+    atomic_store_explicit(&state_generation, generation + 2, memory_order_release);
 
     if (motor_output) {
-        motor_output[0] = ttak_fx_to_float(ttak_fx_swish(neurons[MOTOR_NEURON_L_IDX].activation_fx));
-        motor_output[1] = ttak_fx_to_float(ttak_fx_swish(neurons[MOTOR_NEURON_R_IDX].activation_fx));
+        motor_output[0] = ttak_fx_to_float(ttak_fx_swish(neurons[bindings[NEURAL_BIND_MOTOR_L]].activation_fx));
+        motor_output[1] = ttak_fx_to_float(ttak_fx_swish(neurons[bindings[NEURAL_BIND_MOTOR_R]].activation_fx));
     }
 }
 
-void NeuralNet_load(const char* filename, ttak_arena_t* arena) {
-    FILE* file = fopen(filename, "rb");
-    if (file == NULL) {
-        printf("No saved neural network found. Initializing a new one.\n");
-        NeuralNet_init(arena);
-        return;
+bool NeuralNet_plasticity_init(ttak_arena_t* arena) {
+    if (plasticity.state_copy != NULL) {
+        return true;
+    }
+    for (int i = 0; i < 2; ++i) {
+        plasticity.edges[i] = (SynapseEdge_t*)ttak_arena_alloc_uninit(arena, sizeof(SynapseEdge_t) * MAX_SYNAPSES,
+                                                                      sizeof(void*));
+        plasticity.state[i] = (SynapseState_t*)ttak_arena_alloc_uninit(arena, sizeof(SynapseState_t) * MAX_SYNAPSES,
+                                                                       sizeof(void*));
+        plasticity.quiet_rounds[i] = (uint8_t*)ttak_arena_alloc(arena, MAX_SYNAPSES, 1);
+    }
+    plasticity.plan.source = (int32_t*)ttak_arena_alloc_uninit(arena, sizeof(int32_t) * MAX_SYNAPSES,
+                                                               sizeof(int32_t));
+    plasticity.adjacency = ttak_arena_alloc_uninit(arena, (size_t)MAX_NEURONS * PLASTICITY_ADJACENCY_BYTES, 1);
+    SynapseState_t* state_copy = (SynapseState_t*)ttak_arena_alloc_uninit(arena, sizeof(SynapseState_t) * MAX_SYNAPSES,
+                                                                          sizeof(void*));
+    if (plasticity.edges[0] == NULL || plasticity.edges[1] == NULL ||
+        plasticity.state[0] == NULL || plasticity.state[1] == NULL ||
+        plasticity.quiet_rounds[0] == NULL || plasticity.quiet_rounds[1] == NULL ||
+        plasticity.plan.source == NULL || plasticity.adjacency == NULL || state_copy == NULL) {
+        fprintf(stderr, "Structural plasticity disabled: out of memory.\n");
+        return false;
     }
+    plasticity.state_copy = state_copy;
+    return true;
+}
 
-    NeuralNetSaveHeader header;
-    if (fread(&header, sizeof(header), 1, file) != 1 || header.version != SAVE_FILE_VERSION) {
-        printf("Saved state mismatch. Initializing a new neural network.\n");
-        fclose(file);
-        NeuralNet_init(arena);
+// Carries the prune counters over to the slots they moved to
+static void remap_quiet_rounds(void) {
+    const StructuralPlan_t* plan = &plasticity.plan;
+    const uint8_t* old_rounds = plasticity.quiet_rounds[plasticity.quiet_current];
+    uint8_t* new_rounds = plasticity.quiet_rounds[plasticity.quiet_current ^ 1];
+    for (size_t j = 0; j < plan->count; ++j) {
+        new_rounds[j] = plan->source[j] >= 0 ? old_rounds[plan->source[j]] : 0;
+    }
+    plasticity.quiet_current ^= 1;
+}
+
+static bool copy_activity(size_t count) {
+    const struct timespec retry = {0, CAPTURE_RETRY_NS};
+    for (int attempt = 0; attempt < CAPTURE_ATTEMPTS; ++attempt) {
+        uint32_t before = atomic_load_explicit(&state_generation, memory_order_acquire);
+        if (before & 1u) {
+            nanosleep(&retry, NULL);
+            continue;
+        }
+        memcpy(plasticity.state_copy, synapse_state, sizeof(SynapseState_t) * count);
+        memcpy(plasticity.history_copy, fire_history, sizeof(fire_history));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&state_generation, memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void select_prunes(size_t count) {
+    StructuralPlan_t* plan = &plasticity.plan;
+    uint8_t* rounds = plasticity.quiet_rounds[plasticity.quiet_current];
+    for (size_t i = 0; i < count; ++i) {
+        const SynapseState_t* state = &plasticity.state_copy[i];
+        bool quiet = synapse_edges[i].type == SYNAPSE_TYPE_NORMAL &&
+                     ttak_fx_abs(state->weight_fx) < PLASTICITY_PRUNE_WEIGHT &&
+                     state->eligibility_trace_fx < ELIGIBILITY_FLOOR;
+        if (!quiet) {
+            rounds[i] = 0;
+            continue;
+        }
+        if (rounds[i] < UINT8_MAX) {
+            rounds[i]++;
+        }
+        if (rounds[i] >= PLASTICITY_PRUNE_ROUNDS && plan->pruned < PLASTICITY_MAX_PRUNE) {
+            plan->prune[plan->pruned++] = (uint32_t)i;
+        }
+    }
+}
+
+// Sensor-bound neurons are overwritten every step, so synapses onto them would be dead
+static bool is_sensor_binding(size_t neuron) {
+    for (size_t i = 0; i < NUM_SENSOR_INPUTS; ++i) {
+        if ((size_t)bindings[i] == neuron) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Proposes edges a -> b where b repeatedly fired one step after a, at
+ * least PLASTICITY_GROW_LIFT_PCT percent as often as their firing rates
+ * alone would give, and no such edge exists yet. Neurons that fire on every
+ * step are therefore never paired. Keeps the strongest pairs.
+ */
+static void select_growth(size_t count, size_t capacity) {
+    StructuralPlan_t* plan = &plasticity.plan;
+    uint8_t (*adjacency)[PLASTICITY_ADJACENCY_BYTES] = plasticity.adjacency;
+    memset(adjacency, 0, (size_t)MAX_NEURONS * PLASTICITY_ADJACENCY_BYTES);
+    for (size_t i = 0; i < count; ++i) {
+        adjacency[synapse_edges[i].from][synapse_edges[i].to / 8] |= (uint8_t)(1u << (synapse_edges[i].to % 8));
+    }
+
+    int scores[PLASTICITY_MAX_GROW];
+    size_t limit = capacity < PLASTICITY_MAX_GROW ? capacity : PLASTICITY_MAX_GROW;
+    if (limit == 0) {
         return;
     }
+    for (size_t a = 0; a < neuron_count; ++a) {
+        uint64_t led = plasticity.history_copy[a] >> 1;
+        int led_count = __builtin_popcountll(led);
+        if (neurons[a].type == NEURON_TYPE_MOTOR || led_count < PLASTICITY_GROW_MIN_COFIRE) {
+            continue;
+        }
+        for (size_t b = 0; b < neuron_count; ++b) {
+            if (b == a || neurons[b].type == NEURON_TYPE_SENSORY || is_sensor_binding(b) ||
+                (adjacency[a][b / 8] & (1u << (b % 8)))) {
+                continue;
+            }
+            int score = __builtin_popcountll(led & plasticity.history_copy[b]);
+            int chance = led_count * __builtin_popcountll(plasticity.history_copy[b] & (UINT64_MAX >> 1));
+            if (score < PLASTICITY_GROW_MIN_COFIRE || score * 63 * 100 < PLASTICITY_GROW_LIFT_PCT * chance ||
+                (plan->grown == limit && score <= scores[limit - 1])) {
+                continue;
+            }
+            // Insertion into the score-ordered candidate list
+            size_t slot = plan->grown < limit ? plan->grown++ : limit - 1;
+            while (slot > 0 && scores[slot - 1] < score) {
+                scores[slot] = scores[slot - 1];
+                plan->grow_edges[slot] = plan->grow_edges[slot - 1];
+                --slot;
+            }
+            bool inhibitory = neurons[a].type == NEURON_TYPE_INHIBITORY;
+            scores[slot] = score;
+            plan->grow_edges[slot] = (SynapseEdge_t){
+                .from = (int32_t)a,
+                .to = (int32_t)b,
+                .neurotransmitter_type_fx = inhibitory ? -TTAK_FX_ONE : TTAK_FX_ONE,
+                .type = SYNAPSE_TYPE_NORMAL};
+        }
+    }
+
+    // The merge needs the grown edges in from order
+    for (size_t i = 1; i < plan->grown; ++i) {
+        SynapseEdge_t edge = plan->grow_edges[i];
+        size_t j = i;
+        while (j > 0 && (plan->grow_edges[j - 1].from > edge.from ||
+                         (plan->grow_edges[j - 1].from == edge.from && plan->grow_edges[j - 1].to > edge.to))) {
+            plan->grow_edges[j] = plan->grow_edges[j - 1];
+            --j;
+        }
+        plan->grow_edges[j] = edge;
+    }
+    for (size_t g = 0; g < plan->grown; ++g) {
+        bool inhibitory = plan->grow_edges[g].neurotransmitter_type_fx < 0;
+        plan->grow_state[g] = (SynapseState_t){
+            .weight_fx = inhibitory ? -PLASTICITY_GROW_WEIGHT : PLASTICITY_GROW_WEIGHT,
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .eligibility_trace_fx = 0};
+    }
+}
+
+// New edges go after the existing edges with the same from, so per-target accumulation order is kept
+static void build_merge(size_t count) {
+    StructuralPlan_t* plan = &plasticity.plan;
+    size_t j = 0;
+    size_t g = 0;
+    size_t p = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (g < plan->grown && plan->grow_edges[g].from < synapse_edges[i].from) {
+            plan->source[j++] = -1 - (int32_t)g++;
+        }
+        if (p < plan->pruned && plan->prune[p] == i) {
+            ++p;
+            continue;
+        }
+        plan->source[j++] = (int32_t)i;
+    }
+    while (g < plan->grown) {
+        plan->source[j++] = -1 - (int32_t)g++;
+    }
+    plan->count = j;
+}
+
+bool NeuralNet_plasticity_plan(void) {
+    if (plasticity.state_copy == NULL || !neurons || !synapse_state) {
+        return false;
+    }
+    int state = atomic_load_explicit(&plasticity.plan_state, memory_order_acquire);
+    if (state == PLAN_READY) {
+        return false;
+    }
+    if (state == PLAN_APPLIED) {
+        remap_quiet_rounds();
+        atomic_store_explicit(&plasticity.plan_state, PLAN_IDLE, memory_order_relaxed);
+    }
+
+    // Only apply_structural_plan changes the topology, and no plan is pending
+    size_t count = synapse_count;
+    if (!copy_activity(count)) {
+        return false;
+    }
+
+    StructuralPlan_t* plan = &plasticity.plan;
+    plan->pruned = 0;
+    plan->grown = 0;
+    select_prunes(count);
+    select_growth(count, MAX_SYNAPSES - (count - plan->pruned));
+    if (plan->pruned == 0 && plan->grown == 0) {
+        return false;
+    }
+    build_merge(count);
+
+    plasticity.stats.plans++;
+    atomic_store_explicit(&plasticity.plan_state, PLAN_READY, memory_order_release);
+    return true;
+}
+
+void NeuralNet_plasticity_stats(NeuralPlasticityStats_t* stats) {
+    *stats = plasticity.stats;
+    stats->synapses = synapse_count;
+}
+
+static uint64_t fnv1a64(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t snapshot_neurons_offset(void) {
+    return round_up(sizeof(NeuralSnapshotHeader), SNAPSHOT_SECTION_ALIGN);
+}
+
+static size_t snapshot_edges_offset(void) {
+    return snapshot_neurons_offset() + round_up(sizeof(Neuron_t) * MAX_NEURONS, SNAPSHOT_SECTION_ALIGN);
+}
+
+static size_t snapshot_state_offset(void) {
+    return snapshot_edges_offset() + round_up(sizeof(SynapseEdge_t) * MAX_SYNAPSES, SNAPSHOT_SECTION_ALIGN);
+}
+
+static size_t snapshot_file_size(void) {
+    return snapshot_state_offset() + round_up(sizeof(SynapseState_t) * MAX_SYNAPSES, SNAPSHOT_SECTION_ALIGN);
+}
+
+uint64_t NeuralNet_topology_hash(const SynapseEdge_t* edges, size_t count) {
+    uint64_t hash = FNV64_OFFSET_BASIS;
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t edge[3] = {edges[i].from, edges[i].to, (int32_t)edges[i].type};
+        hash = fnv1a64(hash, edge, sizeof(edge));
+    }
+    return hash;
+}
+
+static uint64_t snapshot_checksum(const Neuron_t* neuron_table, size_t neurons_used,
+                                  const SynapseEdge_t* edge_table, const SynapseState_t* state_table,
+                                  size_t synapses_used) {
+    uint64_t hash = fnv1a64(FNV64_OFFSET_BASIS, neuron_table, sizeof(Neuron_t) * neurons_used);
+    hash = fnv1a64(hash, edge_table, sizeof(SynapseEdge_t) * synapses_used);
+    return fnv1a64(hash, state_table, sizeof(SynapseState_t) * synapses_used);
+}
+
+static bool is_legacy_dump(FILE* file, long file_size) {
+    uint64_t counts[2];
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(counts, sizeof(counts), 1, file) != 1) {
+        return false;
+    }
+    if (counts[0] == 0 || counts[0] > MAX_NEURONS || counts[1] > MAX_SYNAPSES) {
+        return false;
+    }
+    return (uint64_t)file_size == sizeof(counts) + counts[0] * LEGACY_NEURON_RECORD_SIZE +
+                                  counts[1] * LEGACY_SYNAPSE_RECORD_SIZE;
+}
+
+static bool load_delta_file(FILE* file, ttak_arena_t* arena) {
+    NeuralNetDeltaHeader header;
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, file) != 1 ||
+        header.version != DELTA_FILE_VERSION) {
+        return false;
+    }
 
     bootstrap_network(arena);
 
+    // Delta indices refer to generation order, the live tables are sorted by from
+    uint16_t sorted_index[CONNECTOME_SYNAPSES];
+    for (size_t i = 0; i < CONNECTOME_SYNAPSES; ++i) {
+        sorted_index[connectome_legacy_index[i]] = (uint16_t)i;
+    }
+
     for (uint32_t i = 0; i < header.delta_count; ++i) {
         SynapseDelta delta;
         if (fread(&delta, sizeof(delta), 1, file) != 1) {
@@ -263,45 +788,644 @@ void NeuralNet_load(const char* filename, ttak_arena_t* arena) {
             continue;
         }
 
-        synapses[delta.index].weight_fx = ttak_fx_add(neural_synapses[delta.index].weight_fx, delta.weight_delta);
-        synapses[delta.index].synaptic_strength_fx = ttak_fx_add(neural_synapses[delta.index].synaptic_strength_fx,
-                                                                 delta.strength_delta);
+        size_t index = sorted_index[delta.index];
+        synapse_state[index].weight_fx = ttak_fx_add(connectome_initial_state[index].weight_fx, delta.weight_delta);
+        synapse_state[index].synaptic_strength_fx = ttak_fx_add(connectome_initial_state[index].synaptic_strength_fx,
+                                                                delta.strength_delta);
     }
+    printf("Imported %u offsets from delta save file.\n", header.delta_count);
+    return true;
+}
+
+static bool snapshot_layout_matches(const NeuralSnapshotHeader* header, size_t file_size) {
+    return header->neuron_capacity == MAX_NEURONS &&
+           header->synapse_capacity == MAX_SYNAPSES &&
+           header->neurons_offset == snapshot_neurons_offset() &&
+           header->edges_offset == snapshot_edges_offset() &&
+           header->state_offset == snapshot_state_offset() &&
+           file_size == snapshot_file_size();
+}
+
+static bool section_fits(uint64_t offset, uint64_t bytes, size_t file_size) {
+    return offset <= file_size && bytes <= file_size - offset;
+}
 
+static const char* validate_snapshot(const NeuralSnapshotHeader* header, size_t file_size) {
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        return "bad magic";
+    }
+    if (header->endian_mark != SNAPSHOT_ENDIAN_MARK) {
+        return "endianness mismatch";
+    }
+    if (header->version != SNAPSHOT_VERSION || header->header_size != sizeof(NeuralSnapshotHeader)) {
+        return "unsupported version";
+    }
+    if (header->section_align != SNAPSHOT_SECTION_ALIGN ||
+        header->neuron_record_size != sizeof(Neuron_t) ||
+        header->edge_record_size != sizeof(SynapseEdge_t) ||
+        header->state_record_size != sizeof(SynapseState_t)) {
+        return "layout mismatch";
+    }
+    if (header->file_size != file_size) {
+        return "truncated file";
+    }
+    if (header->neuron_count == 0 || header->neuron_count > MAX_NEURONS ||
+        header->synapse_count > MAX_SYNAPSES) {
+        return "counts out of range";
+    }
+    if (!section_fits(header->neurons_offset, (uint64_t)header->neuron_count * sizeof(Neuron_t), file_size) ||
+        !section_fits(header->edges_offset, (uint64_t)header->synapse_count * sizeof(SynapseEdge_t), file_size) ||
+        !section_fits(header->state_offset, (uint64_t)header->synapse_count * sizeof(SynapseState_t), file_size)) {
+        return "truncated file";
+    }
+    for (size_t i = 0; i < NEURAL_BIND_COUNT; ++i) {
+        if (header->bindings[i] < 0 || (uint32_t)header->bindings[i] >= header->neuron_count) {
+            return "binding out of range";
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Copies a snapshot written with other capacities into the arena buffers.
+ * Only the used records are copied, so any capacity that fits the counts works.
+ */
+static bool copy_snapshot(const uint8_t* map, const NeuralSnapshotHeader* header, ttak_arena_t* arena) {
+    Neuron_t* copied_neurons = (Neuron_t*)ttak_arena_alloc(arena, sizeof(Neuron_t) * MAX_NEURONS, sizeof(void*));
+    SynapseState_t* copied_state = (SynapseState_t*)ttak_arena_alloc(arena, sizeof(SynapseState_t) * MAX_SYNAPSES,
+                                                                     sizeof(void*));
+    if (copied_neurons == NULL || copied_state == NULL || !ensure_edge_storage(arena)) {
+        return false;
+    }
+    memcpy(copied_neurons, map + header->neurons_offset, sizeof(Neuron_t) * header->neuron_count);
+    memcpy(edge_storage, map + header->edges_offset, sizeof(SynapseEdge_t) * header->synapse_count);
+    memcpy(copied_state, map + header->state_offset, sizeof(SynapseState_t) * header->synapse_count);
+    neurons = copied_neurons;
+    synapse_state = copied_state;
+    synapse_edges = edge_storage;
+    return true;
+}
+
+/*
+ * Maps a snapshot privately so the weights are used in place: pages are
+ * faulted in on first touch and copied only when learning modifies them.
+ */
+static bool map_snapshot(int fd, const char* filename, ttak_arena_t* arena) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(NeuralSnapshotHeader)) {
+        return false;
+    }
+    size_t file_size = (size_t)st.st_size;
+    void* map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Failed to map neural network snapshot");
+        return false;
+    }
+
+    const NeuralSnapshotHeader* header = (const NeuralSnapshotHeader*)map;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        munmap(map, file_size);
+        return false;
+    }
+    const char* problem = validate_snapshot(header, file_size);
+    bool in_place = problem == NULL && snapshot_layout_matches(header, file_size);
+    if (problem == NULL && !in_place && arena == NULL) {
+        problem = "layout mismatch";
+    }
+    Neuron_t* mapped_neurons = (Neuron_t*)((uint8_t*)map + header->neurons_offset);
+    const SynapseEdge_t* mapped_edges = (const SynapseEdge_t*)((uint8_t*)map + header->edges_offset);
+    SynapseState_t* mapped_state = (SynapseState_t*)((uint8_t*)map + header->state_offset);
+    if (problem == NULL &&
+        snapshot_checksum(mapped_neurons, header->neuron_count, mapped_edges, mapped_state,
+                          header->synapse_count) != header->checksum) {
+        problem = "checksum mismatch";
+    }
+    if (problem == NULL &&
+        NeuralNet_topology_hash(mapped_edges, header->synapse_count) != header->topology_hash) {
+        problem = "topology hash mismatch";
+    }
+    if (problem == NULL) {
+        for (size_t i = 0; i < header->synapse_count; ++i) {
+            if (mapped_edges[i].from < 0 || (uint32_t)mapped_edges[i].from >= header->neuron_count ||
+                mapped_edges[i].to < 0 || (uint32_t)mapped_edges[i].to >= header->neuron_count) {
+                problem = "synapse endpoint out of range";
+                break;
+            }
+        }
+    }
+    if (problem == NULL && !in_place && !copy_snapshot((const uint8_t*)map, header, arena)) {
+        problem = "out of memory";
+    }
+    if (problem != NULL) {
+        printf("Snapshot '%s' rejected: %s.\n", filename, problem);
+        munmap(map, file_size);
+        return false;
+    }
+
+    if (in_place) {
+        neurons = mapped_neurons;
+        synapse_state = mapped_state;
+        synapse_edges = mapped_edges;
+    }
+    neuron_count = header->neuron_count;
+    synapse_count = header->synapse_count;
+    // An unchanged topology keeps using the read-only table; the mapped edge pages are never touched again
+    if (header->topology_hash == CONNECTOME_TOPOLOGY_HASH && synapse_count == CONNECTOME_SYNAPSES) {
+        synapse_edges = connectome_edges;
+    }
+    memcpy(bindings, header->bindings, sizeof(bindings));
+    origin_hash = header->origin_hash;
+    // Passed through an identity delta so out-of-range levels are clamped
+    NeuroModDelta_t identity;
+    NeuroMod_delta_init(&identity);
+    modulators = header->modulators;
+    NeuroMod_apply(&modulators, &identity);
+    atomic_store(&snapshot_sequence, header->sequence);
+    printf("Neural network snapshot %s from '%s' (%zu neurons, %zu synapses, topology %016llx%s).\n",
+           in_place ? "mapped" : "copied", filename, neuron_count, synapse_count,
+           (unsigned long long)header->topology_hash, synapse_edges == connectome_edges ? ", built-in" : "");
+    if (!in_place) {
+        munmap(map, file_size);
+    }
+    return true;
+}
+
+void NeuralNet_load(const char* filename, ttak_arena_t* arena) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("No saved neural network found. Initializing a new one.\n");
+        NeuralNet_init(arena);
+        return;
+    }
+
+    bool loaded = map_snapshot(fd, filename, arena);
+    close(fd);
+    if (loaded) {
+        return;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    if (file != NULL) {
+        long file_size = -1;
+        if (fseek(file, 0, SEEK_END) == 0) {
+            file_size = ftell(file);
+        }
+        if (is_legacy_dump(file, file_size)) {
+            printf("'%s' is a legacy full-dump save without fixed-point weights; it cannot be imported.\n",
+                   filename);
+        } else if (load_delta_file(file, arena)) {
+            fclose(file);
+            return;
+        }
+        fclose(file);
+    }
+
+    printf("Saved state unusable. Initializing a new neural network.\n");
+    NeuralNet_init(arena);
+}
+
+static const char* const type_names[] = {
+    [NEURON_TYPE_SENSORY] = "sensory",
+    [NEURON_TYPE_EXCITATORY] = "excitatory",
+    [NEURON_TYPE_INHIBITORY] = "inhibitory",
+    [NEURON_TYPE_MOTOR] = "motor",
+};
+
+static const char* const binding_names[NEURAL_BIND_COUNT] = {
+    [NEURAL_BIND_DIST] = "dist",
+    [NEURAL_BIND_HOST_L] = "host_l",
+    [NEURAL_BIND_HOST_R] = "host_r",
+    [NEURAL_BIND_MOTOR_L] = "motor_l",
+    [NEURAL_BIND_MOTOR_R] = "motor_r",
+};
+
+typedef struct {
+    Neuron_t* neurons;
+    size_t neuron_count;
+    SynapseEdge_t* edges;
+    SynapseState_t* state;
+    size_t synapse_count;
+    int32_t bindings[NEURAL_BIND_COUNT];
+} ParsedConnectome_t;
+
+static int lookup_name(const char* const* names, size_t count, const char* name) {
+    for (size_t i = 0; i < count; ++i) {
+        if (strcmp(names[i], name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int lookup_neuron(const ParsedConnectome_t* parsed, const char* name) {
+    for (size_t i = 0; i < parsed->neuron_count; ++i) {
+        if (strcmp(parsed->neurons[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Splits line in place on commas, trimming blanks; returns the field count
+static size_t split_fields(char* line, char** fields, size_t max_fields) {
+    char* comment = strchr(line, '#');
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+    size_t count = 0;
+    char* cursor = line;
+    while (count < max_fields) {
+        char* end = strchr(cursor, ',');
+        if (end != NULL) {
+            *end = '\0';
+        }
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+        char* tail = cursor + strlen(cursor);
+        while (tail > cursor && (tail[-1] == ' ' || tail[-1] == '\t' || tail[-1] == '\r' || tail[-1] == '\n')) {
+            *--tail = '\0';
+        }
+        fields[count++] = cursor;
+        if (end == NULL) {
+            break;
+        }
+        cursor = end + 1;
+    }
+    return (count == 1 && fields[0][0] == '\0') ? 0 : count;
+}
+
+static const char* parse_record(ParsedConnectome_t* parsed, char** fields, size_t count) {
+    if (strcmp(fields[0], "neuron") == 0) {
+        if (count != 3) {
+            return "expected neuron,NAME,TYPE";
+        }
+        int type = lookup_name(type_names, sizeof(type_names) / sizeof(type_names[0]), fields[2]);
+        if (type < 0) {
+            return "unknown neuron type";
+        }
+        if (strlen(fields[1]) == 0 || strlen(fields[1]) >= sizeof(parsed->neurons[0].name)) {
+            return "neuron name empty or too long";
+        }
+        if (lookup_neuron(parsed, fields[1]) >= 0) {
+            return "duplicate neuron";
+        }
+        if (parsed->neuron_count == MAX_NEURONS) {
+            return "more than MAX_NEURONS neurons";
+        }
+        Neuron_t* neuron = &parsed->neurons[parsed->neuron_count++];
+        memset(neuron, 0, sizeof(*neuron));
+        strcpy(neuron->name, fields[1]);
+        neuron->type = (NeuronType_t)type;
+        return NULL;
+    }
+
+    if (strcmp(fields[0], "synapse") == 0) {
+        if (count < 4 || count > 6) {
+            return "expected synapse,FROM,TO,WEIGHT[,TRANSMITTER[,antagonistic]]";
+        }
+        int from = lookup_neuron(parsed, fields[1]);
+        int to = lookup_neuron(parsed, fields[2]);
+        if (from < 0 || to < 0) {
+            return "synapse references an undeclared neuron";
+        }
+        char* end = NULL;
+        float weight = strtof(fields[3], &end);
+        if (end == fields[3] || *end != '\0') {
+            return "bad weight";
+        }
+        float transmitter = weight < 0.0f ? -1.0f : 1.0f;
+        if (count >= 5 && fields[4][0] != '\0') {
+            transmitter = strtof(fields[4], &end);
+            if (end == fields[4] || *end != '\0') {
+                return "bad transmitter";
+            }
+        }
+        if (count == 6 && strcmp(fields[5], "antagonistic") != 0) {
+            return "unknown synapse flag";
+        }
+        if (parsed->synapse_count == MAX_SYNAPSES) {
+            return "more than MAX_SYNAPSES synapses";
+        }
+        size_t index = parsed->synapse_count++;
+        parsed->edges[index] = (SynapseEdge_t){
+            .from = from,
+            .to = to,
+            .neurotransmitter_type_fx = ttak_fx_from_float(transmitter),
+            .type = count == 6 ? SYNAPSE_TYPE_ANTAGONISTIC : SYNAPSE_TYPE_NORMAL};
+        parsed->state[index] = (SynapseState_t){
+            .weight_fx = ttak_fx_clamp(ttak_fx_from_float(weight), FX_WEIGHT_MIN, FX_WEIGHT_MAX),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .eligibility_trace_fx = 0};
+        return NULL;
+    }
+
+    if (strcmp(fields[0], "bind") == 0) {
+        if (count != 3) {
+            return "expected bind,ROLE,NAME";
+        }
+        int role = lookup_name(binding_names, NEURAL_BIND_COUNT, fields[1]);
+        if (role < 0) {
+            return "unknown binding role";
+        }
+        int neuron = lookup_neuron(parsed, fields[2]);
+        if (neuron < 0) {
+            return "binding references an undeclared neuron";
+        }
+        parsed->bindings[role] = neuron;
+        return NULL;
+    }
+    return "unknown record";
+}
+
+// Stable counting sort on from, so the step kernel reads neurons[from] sequentially
+static void sort_parsed_edges(ParsedConnectome_t* parsed, SynapseEdge_t* edges_out, SynapseState_t* state_out) {
+    size_t start[MAX_NEURONS + 1] = {0};
+    for (size_t i = 0; i < parsed->synapse_count; ++i) {
+        start[parsed->edges[i].from + 1]++;
+    }
+    for (size_t n = 0; n < parsed->neuron_count; ++n) {
+        start[n + 1] += start[n];
+    }
+    for (size_t i = 0; i < parsed->synapse_count; ++i) {
+        size_t slot = start[parsed->edges[i].from]++;
+        edges_out[slot] = parsed->edges[i];
+        state_out[slot] = parsed->state[i];
+    }
+}
+
+static bool parse_connectome(FILE* file, const char* filename, ParsedConnectome_t* parsed) {
+    for (size_t i = 0; i < NEURAL_BIND_COUNT; ++i) {
+        parsed->bindings[i] = -1;
+    }
+
+    char line[CONNECTOME_LINE_MAX];
+    size_t line_number = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        ++line_number;
+        if (strchr(line, '\n') == NULL && !feof(file)) {
+            fprintf(stderr, "%s:%zu: line too long\n", filename, line_number);
+            return false;
+        }
+        char* fields[6];
+        size_t count = split_fields(line, fields, sizeof(fields) / sizeof(fields[0]));
+        if (count == 0) {
+            continue;
+        }
+        const char* problem = parse_record(parsed, fields, count);
+        if (problem != NULL) {
+            fprintf(stderr, "%s:%zu: %s\n", filename, line_number, problem);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < NEURAL_BIND_COUNT; ++i) {
+        if (parsed->bindings[i] < 0) {
+            fprintf(stderr, "%s: no neuron bound to '%s'\n", filename, binding_names[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NeuralNet_use_connectome(const char* filename, ttak_arena_t* arena) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        perror("Failed to open connectome");
+        return false;
+    }
+
+    ParsedConnectome_t parsed = {0};
+    parsed.neurons = (Neuron_t*)malloc(sizeof(Neuron_t) * MAX_NEURONS);
+    parsed.edges = (SynapseEdge_t*)malloc(sizeof(SynapseEdge_t) * MAX_SYNAPSES);
+    parsed.state = (SynapseState_t*)malloc(sizeof(SynapseState_t) * MAX_SYNAPSES);
+    SynapseEdge_t* sorted_edges = (SynapseEdge_t*)malloc(sizeof(SynapseEdge_t) * MAX_SYNAPSES);
+    SynapseState_t* sorted_state = (SynapseState_t*)malloc(sizeof(SynapseState_t) * MAX_SYNAPSES);
+    bool ok = parsed.neurons != NULL && parsed.edges != NULL && parsed.state != NULL &&
+              sorted_edges != NULL && sorted_state != NULL &&
+              parse_connectome(file, filename, &parsed);
     fclose(file);
-    printf("Neural network state loaded successfully from '%s'. Applied %u offsets.\n",
-           filename, header.delta_count);
+
+    if (ok) {
+        sort_parsed_edges(&parsed, sorted_edges, sorted_state);
+        uint64_t hash = NeuralNet_topology_hash(sorted_edges, parsed.synapse_count);
+        if (neurons != NULL && origin_hash == hash) {
+            printf("Network already grown from connectome '%s', keeping its learned state.\n", filename);
+        } else {
+            ensure_buffers(arena);
+            ok = neurons != NULL && synapse_state != NULL && ensure_edge_storage(arena);
+            if (ok) {
+                memcpy(neurons, parsed.neurons, sizeof(Neuron_t) * parsed.neuron_count);
+                memcpy(edge_storage, sorted_edges, sizeof(SynapseEdge_t) * parsed.synapse_count);
+                memcpy(synapse_state, sorted_state, sizeof(SynapseState_t) * parsed.synapse_count);
+                neuron_count = parsed.neuron_count;
+                synapse_count = parsed.synapse_count;
+                synapse_edges = edge_storage;
+                memcpy(bindings, parsed.bindings, sizeof(bindings));
+                origin_hash = hash;
+                printf("Connectome '%s' loaded (%zu neurons, %zu synapses, topology %016llx).\n",
+                       filename, neuron_count, synapse_count, (unsigned long long)hash);
+            }
+        }
+    }
+
+    free(parsed.neurons);
+    free(parsed.edges);
+    free(parsed.state);
+    free(sorted_edges);
+    free(sorted_state);
+    return ok;
 }
 
-void NeuralNet_save(const char* filename) {
-    FILE* file = fopen(filename, "wb");
+bool NeuralNet_export_connectome(const char* filename) {
+    if (!neurons || !synapse_state) {
+        return false;
+    }
+    FILE* file = fopen(filename, "w");
     if (file == NULL) {
-        perror("Failed to save neural network");
-        return;
+        perror("Failed to export connectome");
+        return false;
     }
 
-    SynapseDelta deltas[MAX_SYNAPSES];
-    size_t delta_count = 0;
+    fprintf(file, "# %zu neurons, %zu synapses\n", neuron_count, synapse_count);
+    for (size_t i = 0; i < neuron_count; ++i) {
+        fprintf(file, "neuron,%s,%s\n", neurons[i].name, type_names[neurons[i].type]);
+    }
     for (size_t i = 0; i < synapse_count; ++i) {
-        ttak_fx_t weight_delta = ttak_fx_sub(synapses[i].weight_fx, neural_synapses[i].weight_fx);
-        ttak_fx_t strength_delta = ttak_fx_sub(synapses[i].synaptic_strength_fx, neural_synapses[i].synaptic_strength_fx);
+        const SynapseEdge_t* edge = &synapse_edges[i];
+        fprintf(file, "synapse,%s,%s,%.6f,%.6f%s\n", neurons[edge->from].name, neurons[edge->to].name,
+                (double)ttak_fx_to_float(synapse_state[i].weight_fx),
+                (double)ttak_fx_to_float(edge->neurotransmitter_type_fx),
+                edge->type == SYNAPSE_TYPE_ANTAGONISTIC ? ",antagonistic" : "");
+    }
+    for (size_t i = 0; i < NEURAL_BIND_COUNT; ++i) {
+        fprintf(file, "bind,%s,%s\n", binding_names[i], neurons[bindings[i]].name);
+    }
+
+    bool ok = fclose(file) == 0;
+    if (!ok) {
+        perror("Failed to export connectome");
+    }
+    return ok;
+}
 
-        if (weight_delta != 0 || strength_delta != 0) {
-            deltas[delta_count].index = (uint32_t)i;
-            deltas[delta_count].weight_delta = weight_delta;
-            deltas[delta_count].strength_delta = strength_delta;
-            ++delta_count;
+static bool write_all(int fd, const void* data, size_t size, off_t offset) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
         }
+        bytes += written;
+        size -= (size_t)written;
+        offset += written;
     }
+    return true;
+}
 
-    NeuralNetSaveHeader header = {
-        .version = SAVE_FILE_VERSION,
-        .delta_count = (uint32_t)delta_count,
-    };
+static void fill_snapshot_header(NeuralSnapshotHeader* header,
+                                 const Neuron_t* neuron_table, size_t neurons_used,
+                                 const SynapseEdge_t* edge_table, const SynapseState_t* state_table,
+                                 size_t synapses_used, const NeuroModulators_t* levels) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->endian_mark = SNAPSHOT_ENDIAN_MARK;
+    header->header_size = sizeof(NeuralSnapshotHeader);
+    header->section_align = SNAPSHOT_SECTION_ALIGN;
+    header->neuron_count = (uint32_t)neurons_used;
+    header->synapse_count = (uint32_t)synapses_used;
+    header->neuron_capacity = MAX_NEURONS;
+    header->synapse_capacity = MAX_SYNAPSES;
+    header->neuron_record_size = sizeof(Neuron_t);
+    header->edge_record_size = sizeof(SynapseEdge_t);
+    header->state_record_size = sizeof(SynapseState_t);
+    header->neurons_offset = snapshot_neurons_offset();
+    header->edges_offset = snapshot_edges_offset();
+    header->state_offset = snapshot_state_offset();
+    header->file_size = snapshot_file_size();
+    header->sequence = atomic_fetch_add(&snapshot_sequence, 1) + 1;
+    header->topology_hash = edge_table == connectome_edges && synapses_used == CONNECTOME_SYNAPSES
+                                ? CONNECTOME_TOPOLOGY_HASH
+                                : NeuralNet_topology_hash(edge_table, synapses_used);
+    header->checksum = snapshot_checksum(neuron_table, neurons_used, edge_table, state_table, synapses_used);
+    header->origin_hash = origin_hash;
+    memcpy(header->bindings, bindings, sizeof(header->bindings));
+    header->modulators = *levels;
+}
 
-    fwrite(&header, sizeof(header), 1, file);
-    fwrite(deltas, sizeof(SynapseDelta), delta_count, file);
+void NeuralNet_save(const char* filename) {
+    if (!neurons || !synapse_state) {
+        return;
+    }
+
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", filename);
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Failed to save neural network");
+        return;
+    }
+
+    NeuralSnapshotHeader header;
+    fill_snapshot_header(&header, neurons, neuron_count, synapse_edges, synapse_state, synapse_count, &modulators);
+
+    bool ok = ftruncate(fd, (off_t)header.file_size) == 0 &&
+              write_all(fd, neurons, sizeof(Neuron_t) * neuron_count, (off_t)header.neurons_offset) &&
+              write_all(fd, synapse_edges, sizeof(SynapseEdge_t) * synapse_count, (off_t)header.edges_offset) &&
+              write_all(fd, synapse_state, sizeof(SynapseState_t) * synapse_count, (off_t)header.state_offset) &&
+              write_all(fd, &header, sizeof(header), 0) &&
+              fsync(fd) == 0;
+    close(fd);
+
+    if (!ok || rename(temp_path, filename) != 0) {
+        perror("Failed to save neural network");
+        unlink(temp_path);
+        return;
+    }
+
+    printf("Neural network snapshot %llu saved to '%s' (%zu neurons, %zu synapses).\n",
+           (unsigned long long)header.sequence, filename, neuron_count, synapse_count);
+}
+
+size_t NeuralNet_snapshot_size(void) {
+    return snapshot_file_size();
+}
+
+bool NeuralNet_snapshot_capture(uint8_t* image, size_t image_size) {
+    if (!neurons || !synapse_state || image_size < snapshot_file_size()) {
+        return false;
+    }
+
+    uint8_t* neuron_section = image + snapshot_neurons_offset();
+    uint8_t* edge_section = image + snapshot_edges_offset();
+    uint8_t* state_section = image + snapshot_state_offset();
+    const struct timespec retry = {0, CAPTURE_RETRY_NS};
+
+    for (int attempt = 0; attempt < CAPTURE_ATTEMPTS; ++attempt) {
+        uint32_t before = atomic_load_explicit(&state_generation, memory_order_acquire);
+        if (before & 1u) {
+            nanosleep(&retry, NULL);
+            continue;
+        }
+        size_t neurons_used = neuron_count;
+        size_t synapses_used = synapse_count;
+        const SynapseEdge_t* edges = synapse_edges;
+        // A plan applied mid-copy can pair the new count with the built-in table
+        if (edges == connectome_edges && synapses_used > CONNECTOME_SYNAPSES) {
+            continue;
+        }
+        memcpy(neuron_section, neurons, sizeof(Neuron_t) * MAX_NEURONS);
+        memcpy(edge_section, edges, sizeof(SynapseEdge_t) * synapses_used);
+        memcpy(state_section, synapse_state, sizeof(SynapseState_t) * synapses_used);
+        NeuroModulators_t levels = modulators;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&state_generation, memory_order_relaxed) != before) {
+            continue;
+        }
+
+        // Unused tails are zeroed so they compare equal from one capture to the next
+        memset(edge_section + sizeof(SynapseEdge_t) * synapses_used, 0,
+               sizeof(SynapseEdge_t) * (MAX_SYNAPSES - synapses_used));
+        memset(state_section + sizeof(SynapseState_t) * synapses_used, 0,
+               sizeof(SynapseState_t) * (MAX_SYNAPSES - synapses_used));
+        NeuralSnapshotHeader header;
+        fill_snapshot_header(&header, (const Neuron_t*)neuron_section, neurons_used,
+                             edges == connectome_edges ? connectome_edges : (const SynapseEdge_t*)edge_section,
+                             (const SynapseState_t*)state_section, synapses_used, &levels);
+        memset(image, 0, snapshot_neurons_offset());
+        memcpy(image, &header, sizeof(header));
+        return true;
+    }
+    return false;
+}
+
+bool NeuralNet_snapshot_sequence(const char* filename, uint64_t* sequence) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    NeuralSnapshotHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.endian_mark == SNAPSHOT_ENDIAN_MARK &&
+              header.version == SNAPSHOT_VERSION;
     fclose(file);
+    if (ok) {
+        *sequence = header.sequence;
+    }
+    return ok;
+}
 
-    printf("Neural network state saved to '%s' with %zu offsets.\n", filename, delta_count);
+bool NeuralNet_map(const char* filename, ttak_arena_t* arena) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool loaded = map_snapshot(fd, filename, arena);
+    close(fd);
+    return loaded;
 }
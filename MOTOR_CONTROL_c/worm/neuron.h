@@ -3,21 +3,36 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "libttak/math/fx.h"
 #include "libttak/mem/arena.h"
 
-// Maximum numbers of neurons and synapses supported
-#define MAX_NEURONS 300
+// Maximum numbers of neurons and synapses supported (room for the 302-neuron C. elegans graph)
+#define MAX_NEURONS 384
 #define MAX_SYNAPSES 10000
+#define NEURAL_MAX_SUBSTEPS 16
 
-// Common neuron indices
+// Sensory input slots, in the order NeuralNet_step reads sensory_input
 #define SENSOR_NEURON_DIST_IDX 0
 #define SENSOR_NEURON_HOST_L_IDX 1
 #define SENSOR_NEURON_HOST_R_IDX 2
-#define MOTOR_NEURON_L_IDX 78
-#define MOTOR_NEURON_R_IDX 79
+#define NUM_SENSOR_INPUTS 3
+
+/*
+ * Roles a connectome binds to neurons: the sensory input slots, then the
+ * two motor outputs. The built-in connectome binds its first three and
+ * last two neurons; external connectomes name them with bind records.
+ */
+typedef enum {
+    NEURAL_BIND_DIST = SENSOR_NEURON_DIST_IDX,
+    NEURAL_BIND_HOST_L = SENSOR_NEURON_HOST_L_IDX,
+    NEURAL_BIND_HOST_R = SENSOR_NEURON_HOST_R_IDX,
+    NEURAL_BIND_MOTOR_L,
+    NEURAL_BIND_MOTOR_R,
+    NEURAL_BIND_COUNT
+} NeuralBinding_t;
 
 // Enumeration for neuron types
 typedef enum {
@@ -41,43 +56,110 @@ typedef struct {
     char name[32];
 } Neuron_t;
 
-// Synapse (connection) data structure
+// Synapse topology: fixed for a given connectome and shared read-only
+typedef struct {
+    int32_t from;
+    int32_t to;
+    ttak_fx_t neurotransmitter_type_fx; // 1.0 Dopamine, -1.0 Serotonin
+    SynapseType_t type;
+} SynapseEdge_t;
+
+// Learned per-synapse state, indexed like the edge list
 typedef struct {
-    int from;
-    int to;
     ttak_fx_t weight_fx;
     ttak_fx_t synaptic_strength_fx;
-    ttak_fx_t neurotransmitter_type_fx; // 1.0 Dopamine, -1.0 Serotonin
     ttak_fx_t eligibility_trace_fx;
-    SynapseType_t type;
-} Synapse_t;
+} SynapseState_t;
 
-// External declarations for initial neuron and synapse counts
-extern const size_t NUM_NEURONS_INIT;
-extern size_t NUM_SYNAPSES_INIT;
+// Learning and mood signals, in the order NeuroModulators_t stores them
+typedef enum {
+    NEUROMOD_DOPAMINE,
+    NEUROMOD_SEROTONIN,
+    NEUROMOD_ACETYLCHOLINE,
+    NEUROMOD_GABA,
+    NEUROMOD_EPINEPHRINE,
+    NEUROMOD_NOREPINEPHRINE,
+    NEUROMOD_GLUTAMATE,
+    NEUROMOD_ENDORPHIN,
+    NEUROMOD_OXYTOCIN,
+    NEUROMOD_CORTISOL,
+    NEUROMOD_STABILITY,
+    NEUROMOD_ATP,
+    NEUROMOD_COUNT
+} NeuroModulator_t;
 
-// Initial neuron names and synapse array declarations
-extern const char* neuron_names[MAX_NEURONS];
-extern Synapse_t neural_synapses[MAX_SYNAPSES];
+/*
+ * Neuromodulator levels in Q16.16, owned by the network. Dopamine carries
+ * the signed reward prediction error in [-2, 2], ATP runs from 0 to 100
+ * and every other channel from 0 to 1.
+ */
+typedef struct {
+    ttak_fx_t level[NEUROMOD_COUNT];
+} NeuroModulators_t;
 
-// Global variables for learning and mood signals
-extern float dopamine_level;
-extern float serotonin_level;
-extern float acetylcholine_level;
-extern float gaba_level;
-extern float epinephrine_level;
-extern float norepinephrine_level;
-extern float glutamate_level;
-extern float endorphin_level;
-extern float oxytocin_level;
-extern float cortisol_level;
-extern float stability_level; // NEW: Added for behavioral stability
-extern float atp_level;
+/*
+ * One update of every channel at once:
+ *   level = clamp(level * scale + add, floor, ceiling)
+ * NeuroMod_delta_init starts from the identity bounded by the channel
+ * ranges; the helpers below compose into it. Clamping happens once, after
+ * scale and add.
+ */
+typedef struct {
+    ttak_fx_t scale[NEUROMOD_COUNT];
+    ttak_fx_t add[NEUROMOD_COUNT];
+    ttak_fx_t floor[NEUROMOD_COUNT];
+    ttak_fx_t ceiling[NEUROMOD_COUNT];
+} NeuroModDelta_t;
+
+void NeuroMod_delta_init(NeuroModDelta_t* delta);
 
 /*
- * Initializes the synapses with a biological structure
+ * Applies delta to levels. Used by NeuralNet_modulate and to preview a
+ * delta on a copy before committing it.
  */
-void init_synapses_biological(void);
+void NeuroMod_apply(NeuroModulators_t* levels, const NeuroModDelta_t* delta);
+
+static inline void NeuroMod_set(NeuroModDelta_t* delta, NeuroModulator_t channel, ttak_fx_t value) {
+    delta->scale[channel] = 0;
+    delta->add[channel] = value;
+}
+
+static inline void NeuroMod_add(NeuroModDelta_t* delta, NeuroModulator_t channel, ttak_fx_t amount) {
+    delta->add[channel] = ttak_fx_add(delta->add[channel], amount);
+}
+
+static inline void NeuroMod_scale(NeuroModDelta_t* delta, NeuroModulator_t channel, ttak_fx_t factor) {
+    delta->scale[channel] = ttak_fx_mul(delta->scale[channel], factor);
+    delta->add[channel] = ttak_fx_mul(delta->add[channel], factor);
+}
+
+static inline void NeuroMod_floor(NeuroModDelta_t* delta, NeuroModulator_t channel, ttak_fx_t minimum) {
+    if (minimum > delta->floor[channel]) {
+        delta->floor[channel] = minimum;
+    }
+}
+
+static inline void NeuroMod_ceiling(NeuroModDelta_t* delta, NeuroModulator_t channel, ttak_fx_t maximum) {
+    if (maximum < delta->ceiling[channel]) {
+        delta->ceiling[channel] = maximum;
+    }
+}
+
+// Structural plasticity counters
+typedef struct {
+    uint64_t plans;      // plans published by the planner
+    uint64_t applied;    // plans applied by NeuralNet_step
+    uint64_t pruned;
+    uint64_t grown;
+    size_t synapses;     // live synapse count
+} NeuralPlasticityStats_t;
+
+// External declaration for the initial neuron count
+extern const size_t NUM_NEURONS_INIT;
+
+// Initial neuron names
+extern const char* neuron_names[MAX_NEURONS];
+
 
 /*
  * Initializes neural network neurons and synapses
@@ -85,20 +167,109 @@ void init_synapses_biological(void);
 void NeuralNet_init(ttak_arena_t* arena);
 
 /*
- * Performs one neural network step:
+ * Performs one neural network step (one control tick):
  * - sensory_input: input array for sensory neurons
  * - motor_output: output array to be filled with motor neuron activations
+ * Runs NeuralNet_substeps() propagation hops with the inputs held;
+ * learning and plasticity bookkeeping happen once per call.
  */
 void NeuralNet_step(const float* sensory_input, float* motor_output);
 
+/*
+ * Applies a neuromodulator update between steps. The firing threshold is
+ * derived from the levels once at the start of every NeuralNet_step.
+ */
+void NeuralNet_modulate(const NeuroModDelta_t* delta);
+
+/*
+ * Live neuromodulator levels. Only the thread that steps and modulates the
+ * network may read them directly; other threads take them from a snapshot.
+ */
+const NeuroModulators_t* NeuralNet_modulators(void);
+
+/*
+ * Propagation hops per NeuralNet_step, clamped to 1..NEURAL_MAX_SUBSTEPS.
+ * More hops let a sensor change reach the motor neurons within one tick.
+ */
+void NeuralNet_set_substeps(unsigned count);
+unsigned NeuralNet_substeps(void);
+
+/*
+ * Loads an external connectome in CSV form, one record per line ('#'
+ * starts a comment):
+ *   neuron,NAME,sensory|excitatory|inhibitory|motor
+ *   synapse,FROM,TO,WEIGHT[,TRANSMITTER[,antagonistic]]
+ *   bind,dist|host_l|host_r|motor_l|motor_r,NAME
+ * TRANSMITTER defaults to the sign of WEIGHT. All five roles must be
+ * bound. If the live network was already grown from the same connectome
+ * (e.g. restored from a snapshot) it is kept; otherwise the file replaces
+ * it. Returns false, leaving the live network alone, if the file is bad.
+ */
+bool NeuralNet_use_connectome(const char* filename, ttak_arena_t* arena);
+
+/*
+ * Writes the live network, with its current weights, in the format above.
+ */
+bool NeuralNet_export_connectome(const char* filename);
+
 /*
  * Loads the neural network state from a file.
+ * Snapshots are mapped in place; older delta saves are imported on top
+ * of a freshly bootstrapped network.
  */
 void NeuralNet_load(const char* filename, ttak_arena_t* arena);
 
 /*
- * Saves the neural network state to a file.
+ * Saves a snapshot to a file (written to <filename>.tmp, then renamed).
  */
 void NeuralNet_save(const char* filename);
 
+/*
+ * Maps a snapshot as the live network, neuromodulator levels included.
+ * A snapshot written with other capacities (MAX_NEURONS, MAX_SYNAPSES) is
+ * copied into arena buffers instead. Returns false if the file is missing
+ * or fails validation; the current network is left untouched.
+ */
+bool NeuralNet_map(const char* filename, ttak_arena_t* arena);
+
+/*
+ * Reads the sequence number from a snapshot header without validating its sections.
+ */
+bool NeuralNet_snapshot_sequence(const char* filename, uint64_t* sequence);
+
+/*
+ * Size in bytes of a complete snapshot file image.
+ */
+size_t NeuralNet_snapshot_size(void);
+
+/*
+ * Copies a consistent snapshot file image (header and sections) into image.
+ * Safe to call from another thread while NeuralNet_step runs: the copy is
+ * retried when a step overlaps it, and the stepping thread never waits.
+ */
+bool NeuralNet_snapshot_capture(uint8_t* image, size_t image_size);
+
+/*
+ * Allocates the double buffers for structural plasticity from arena.
+ * Until this is called, the topology never changes.
+ */
+bool NeuralNet_plasticity_init(ttak_arena_t* arena);
+
+/*
+ * Structural plasticity planner, meant for a background thread. Prunes
+ * synapses whose weight and trace stayed near zero for several rounds and
+ * grows edges between neurons that repeatedly fire in sequence. The plan
+ * is applied by the next NeuralNet_step with one copy pass into
+ * preallocated buffers; nothing is allocated on the control thread.
+ * Returns false when there is nothing to change or a plan is still pending.
+ */
+bool NeuralNet_plasticity_plan(void);
+
+void NeuralNet_plasticity_stats(NeuralPlasticityStats_t* stats);
+
+/*
+ * Hashes the (from, to, type) edge list of a synapse table.
+ */
+uint64_t NeuralNet_topology_hash(const SynapseEdge_t* edges, size_t count);
+
 #endif // NEURON_H
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "remote.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+bool RemoteLink_open(RemoteLink_t* link, const char* peer) {
+    memset(link, 0, sizeof(*link));
+    link->fd = -1;
+
+    char host[256];
+    char port[16];
+    const char* colon = strrchr(peer, ':');
+    size_t host_len = colon != NULL ? (size_t)(colon - peer) : strlen(peer);
+    if (host_len == 0 || host_len >= sizeof(host)) {
+        fprintf(stderr, "remote link: bad peer '%s'\n", peer);
+        return false;
+    }
+    memcpy(host, peer, host_len);
+    host[host_len] = '\0';
+    snprintf(port, sizeof(port), "%s", colon != NULL ? colon + 1 : "");
+    if (port[0] == '\0') {
+        snprintf(port, sizeof(port), "%d", CAR_LINK_DEFAULT_PORT);
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    struct addrinfo* result = NULL;
+    int rc = getaddrinfo(host, port, &hints, &result);
+    if (rc != 0) {
+        fprintf(stderr, "remote link: %s: %s\n", peer, gai_strerror(rc));
+        return false;
+    }
+    for (struct addrinfo* rp = result; rp != NULL; rp = rp->ai_next) {
+        int fd = socket(rp->ai_family, rp->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, rp->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, rp->ai_addr, rp->ai_addrlen) == 0) {
+            link->fd = fd;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(result);
+    if (link->fd < 0) {
+        fprintf(stderr, "remote link: cannot reach %s\n", peer);
+        return false;
+    }
+    return true;
+}
+
+// Send time of a state we still remember, or 0
+static uint64_t state_sent_ns(const RemoteLink_t* link, uint32_t seq) {
+    size_t slot = seq % REMOTE_STATE_HISTORY;
+    return link->state_sent_seq[slot] == seq ? link->state_sent_ns[slot] : 0;
+}
+
+static void accept_command(RemoteLink_t* link, const CarLinkCommand_t* command, uint64_t now_ns) {
+    uint64_t basis_ns = state_sent_ns(link, command->basis_state_seq);
+    if (basis_ns == 0 || now_ns - basis_ns > REMOTE_MAX_COMMAND_AGE_NS) {
+        link->stats.stale++;
+        return;
+    }
+    if (link->have_command &&
+        (car_link_seq_after(link->command_basis, command->basis_state_seq) ||
+         (link->command_basis == command->basis_state_seq && !car_link_seq_after(command->seq, link->command_seq)))) {
+        link->stats.out_of_order++;
+        return;
+    }
+
+    link->have_command = true;
+    link->command_seq = command->seq;
+    link->command_basis = command->basis_state_seq;
+    link->stats.commands++;
+    if (now_ns - basis_ns > link->stats.max_command_age_ns) {
+        link->stats.max_command_age_ns = now_ns - basis_ns;
+    }
+    if (command->flags & CAR_LINK_COMMAND_RELEASE) {
+        link->drive_until_ns = 0;
+        return;
+    }
+    uint32_t hold_ms = command->hold_ms < REMOTE_MAX_HOLD_MS ? command->hold_ms : REMOTE_MAX_HOLD_MS;
+    link->drive.left_speed = command->left_speed;
+    link->drive.right_speed = command->right_speed;
+    link->drive_until_ns = now_ns + (uint64_t)hold_ms * 1000000u;
+}
+
+void RemoteLink_receive(RemoteLink_t* link, uint64_t now_ns) {
+    uint8_t frame[64];
+    for (;;) {
+        ssize_t len = recv(link->fd, frame, sizeof(frame), 0);
+        if (len < 0) {
+            // An ICMP error from an earlier send surfaces here once; keep draining
+            if (errno == EINTR || errno == ECONNREFUSED) {
+                continue;
+            }
+            return;
+        }
+        CarLinkCommand_t command;
+        if (!car_link_decode_command(frame, (size_t)len, &command)) {
+            link->stats.malformed++;
+            continue;
+        }
+        accept_command(link, &command, now_ns);
+    }
+}
+
+void RemoteLink_send_state(RemoteLink_t* link, uint64_t now_ns, CarLinkState_t* state) {
+    state->seq = ++link->state_seq;
+    state->uptime_ms = (uint32_t)(now_ns / 1000000u);
+    state->ack_command_seq = link->command_seq;
+
+    uint8_t frame[CAR_LINK_STATE_BYTES];
+    size_t len = car_link_encode_state(state, frame);
+    size_t slot = state->seq % REMOTE_STATE_HISTORY;
+    link->state_sent_seq[slot] = state->seq;
+    link->state_sent_ns[slot] = now_ns;
+    if (send(link->fd, frame, len, MSG_DONTWAIT) != (ssize_t)len) {
+        link->stats.send_dropped++;
+        return;
+    }
+    link->stats.states_sent++;
+}
+
+bool RemoteLink_drive(const RemoteLink_t* link, uint64_t now_ns, RemoteDrive_t* drive) {
+    if (now_ns >= link->drive_until_ns) {
+        return false;
+    }
+    *drive = link->drive;
+    return true;
+}
+
+void RemoteLink_close(RemoteLink_t* link) {
+    if (link->fd >= 0) {
+        close(link->fd);
+        link->fd = -1;
+    }
+}
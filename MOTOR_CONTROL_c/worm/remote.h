@@ -0,0 +1,71 @@
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../common/net/car_link.h"
+
+// Send times remembered for judging command freshness; at 50 Hz this covers 1.3 s
+#define REMOTE_STATE_HISTORY 64
+// Commands decided on a state older than this are dropped
+#define REMOTE_MAX_COMMAND_AGE_NS 300000000ull
+#define REMOTE_MAX_HOLD_MS 1000u
+
+typedef struct {
+    uint64_t states_sent;
+    uint64_t send_dropped;    // socket full or peer unreachable
+    uint64_t commands;        // accepted
+    uint64_t stale;           // basis state too old or unknown
+    uint64_t out_of_order;    // late or duplicated
+    uint64_t malformed;
+    uint64_t max_command_age_ns;
+} RemoteLinkStats_t;
+
+typedef struct {
+    int8_t left_speed;
+    int8_t right_speed;
+} RemoteDrive_t;
+
+/*
+ * Car end of the UDP link to a base station (see car_link.h). The socket
+ * is non-blocking and is meant to be drained from the control worker's
+ * event loop; nothing here ever waits on the network. Not thread-safe:
+ * every call must come from the same worker.
+ */
+typedef struct {
+    int fd;
+    uint32_t state_seq;
+    uint64_t state_sent_ns[REMOTE_STATE_HISTORY];
+    uint32_t state_sent_seq[REMOTE_STATE_HISTORY];
+
+    bool have_command;
+    uint32_t command_seq;
+    uint32_t command_basis;
+    RemoteDrive_t drive;
+    uint64_t drive_until_ns;
+
+    RemoteLinkStats_t stats;
+} RemoteLink_t;
+
+/*
+ * Resolves peer ("host:port" or "host", default port CAR_LINK_DEFAULT_PORT)
+ * once, at startup, and connects a non-blocking UDP socket to it.
+ */
+bool RemoteLink_open(RemoteLink_t* link, const char* peer);
+
+// Drains every queued datagram; call when the socket is readable
+void RemoteLink_receive(RemoteLink_t* link, uint64_t now_ns);
+
+/*
+ * Sends one state frame, filling in seq, uptime and the command ack.
+ * A full socket buffer drops the frame instead of waiting.
+ */
+void RemoteLink_send_state(RemoteLink_t* link, uint64_t now_ns, CarLinkState_t* state);
+
+// The station's drive, while its last command holds
+bool RemoteLink_drive(const RemoteLink_t* link, uint64_t now_ns, RemoteDrive_t* drive);
+
+void RemoteLink_close(RemoteLink_t* link);
+
+#endif // REMOTE_H
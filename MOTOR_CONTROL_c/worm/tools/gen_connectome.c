@@ -0,0 +1,287 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libttak/math/fx.h"
+
+/*
+ * Build-time connectome generator.
+ *
+ * Runs the biological wiring rules (seeded LCG, so the output never
+ * changes unless the rules do), stable-sorts the synapses by presynaptic
+ * neuron for the step kernel and writes them out as const C tables:
+ *
+ *   gen_connectome <connectome_gen.h> <connectome_gen.c>
+ *
+ * The header carries the counts and the topology hash as macros; the
+ * source holds the edge list, the initial weights and, for each sorted
+ * entry, its index in generation order (used to import old delta saves).
+ */
+
+#define GEN_NEURONS 80
+#define GEN_MAX_SYNAPSES 10000
+#define FNV64_OFFSET_BASIS 0xcbf29ce484222325ULL
+
+enum {
+    GEN_SYNAPSE_NORMAL,
+    GEN_SYNAPSE_ANTAGONISTIC
+};
+
+typedef struct {
+    int from;
+    int to;
+    ttak_fx_t weight_fx;
+    ttak_fx_t synaptic_strength_fx;
+    ttak_fx_t neurotransmitter_type_fx;
+    int type;
+} GenSynapse;
+
+static GenSynapse synapses[GEN_MAX_SYNAPSES];
+static size_t synapse_total = 0;
+static size_t order[GEN_MAX_SYNAPSES];
+
+static uint32_t init_seed = 0x6d2b79f5u;
+
+static float init_rand_unit(void) {
+    init_seed = init_seed * 1664525u + 1013904223u;
+    return (float)(init_seed & 0x00FFFFFFu) / (float)0x01000000u;
+}
+
+static float init_rand_range(float min, float max) {
+    return min + (max - min) * init_rand_unit();
+}
+
+static float init_rand_signed(float magnitude) {
+    return (init_rand_unit() * 2.0f - 1.0f) * magnitude;
+}
+
+static void init_synapses_biological(void) {
+    synapse_total = 0;
+
+    // Sensory Neurons
+    const int SENSORY_DIST = 0;
+    const int SENSORY_HOST_L = 1;
+    const int SENSORY_HOST_R = 2;
+
+    // Inter Neuron Groups
+    const int INTER_H_EX_START = 3;
+    const int INTER_H_EX_END = 22;
+    const int INTER_H_IN_START = 23;
+    const int INTER_H_IN_END = 40;
+    const int INTER_A_EX_START = 41;
+    const int INTER_A_EX_END = 60;
+    const int INTER_A_IN_START = 61;
+    const int INTER_A_IN_END = 77;
+
+    // Motor Neurons
+    const int MOTOR_L = 78;
+    const int MOTOR_R = 79;
+
+    // 1. Host Signal -> Inter Neurons (Goal-Oriented)
+    for (int i = INTER_H_EX_START; i <= INTER_H_EX_END; i++) {
+        float random_weight = init_rand_signed(0.5f);
+        synapses[synapse_total++] = (GenSynapse){
+            .from = SENSORY_HOST_L,
+            .to = i,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+        synapses[synapse_total++] = (GenSynapse){
+            .from = SENSORY_HOST_R,
+            .to = i,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+    }
+
+    // 2. Avoidance Signal -> Inter Neurons (Reactive)
+    for (int i = INTER_A_EX_START; i <= INTER_A_EX_END; i++) {
+        float random_weight = init_rand_signed(0.5f);
+        synapses[synapse_total++] = (GenSynapse){
+            .from = SENSORY_DIST,
+            .to = i,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+    }
+
+    // 3. Inter -> Inter (Local Circuits)
+    // Host Excitatory -> Host Inhibitory
+    for (int i = INTER_H_EX_START; i <= INTER_H_EX_END; i++) {
+        for (int j = INTER_H_IN_START; j <= INTER_H_IN_END; j++) {
+            if ((int)(init_rand_unit() * 5.0f) == 0) { // 20% connection probability
+                float random_weight = -fabsf(init_rand_signed(0.5f));
+                synapses[synapse_total++] = (GenSynapse){
+                    .from = i,
+                    .to = j,
+                    .weight_fx = ttak_fx_from_float(random_weight),
+                    .synaptic_strength_fx = TTAK_FX_ONE,
+                    .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+                            .type = GEN_SYNAPSE_NORMAL};
+            }
+        }
+    }
+    // Avoidance Excitatory -> Avoidance Inhibitory
+    for (int i = INTER_A_EX_START; i <= INTER_A_EX_END; i++) {
+        for (int j = INTER_A_IN_START; j <= INTER_A_IN_END; j++) {
+            if ((int)(init_rand_unit() * 5.0f) == 0) {
+                float random_weight = -fabsf(init_rand_signed(0.5f));
+                synapses[synapse_total++] = (GenSynapse){
+                    .from = i,
+                    .to = j,
+                    .weight_fx = ttak_fx_from_float(random_weight),
+                    .synaptic_strength_fx = TTAK_FX_ONE,
+                    .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+                            .type = GEN_SYNAPSE_NORMAL};
+            }
+        }
+    }
+
+    // 4. Inter -> Motor Neurons (Goal vs. Avoidance)
+    // Host Interneurons -> Motor Neurons (Excitatory to move forward)
+    for (int i = INTER_H_EX_START; i <= INTER_H_EX_END; i++) {
+        float random_weight = init_rand_range(0.0f, 0.2f);
+        synapses[synapse_total++] = (GenSynapse){
+            .from = i,
+            .to = MOTOR_L,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+        synapses[synapse_total++] = (GenSynapse){
+            .from = i,
+            .to = MOTOR_R,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+    }
+    // Avoidance Interneurons -> Motor Neurons (Inhibitory to stop/turn)
+    for (int i = INTER_A_EX_START; i <= INTER_A_EX_END; i++) {
+        float random_weight = -fabsf(init_rand_range(0.0f, 0.2f));
+        synapses[synapse_total++] = (GenSynapse){
+            .from = i,
+            .to = MOTOR_L,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+        synapses[synapse_total++] = (GenSynapse){
+            .from = i,
+            .to = MOTOR_R,
+            .weight_fx = ttak_fx_from_float(random_weight),
+            .synaptic_strength_fx = TTAK_FX_ONE,
+            .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+            .type = GEN_SYNAPSE_NORMAL};
+    }
+
+    // 5. Antagonistic connections between motor neurons
+    synapses[synapse_total++] = (GenSynapse){
+        .from = MOTOR_L,
+        .to = MOTOR_R,
+        .weight_fx = ttak_fx_from_float(-0.5f),
+        .synaptic_strength_fx = TTAK_FX_ONE,
+        .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+        .type = GEN_SYNAPSE_ANTAGONISTIC};
+    synapses[synapse_total++] = (GenSynapse){
+        .from = MOTOR_R,
+        .to = MOTOR_L,
+        .weight_fx = ttak_fx_from_float(-0.5f),
+        .synaptic_strength_fx = TTAK_FX_ONE,
+        .neurotransmitter_type_fx = ttak_fx_from_float(-1.0f),
+        .type = GEN_SYNAPSE_ANTAGONISTIC};
+}
+
+// Stable by construction: ties on from keep generation order
+static int compare_order(const void* a, const void* b) {
+    size_t left = *(const size_t*)a;
+    size_t right = *(const size_t*)b;
+    if (synapses[left].from != synapses[right].from) {
+        return synapses[left].from < synapses[right].from ? -1 : 1;
+    }
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+// Must match NeuralNet_topology_hash in neuron.c
+static uint64_t topology_hash(void) {
+    uint64_t hash = FNV64_OFFSET_BASIS;
+    for (size_t i = 0; i < synapse_total; ++i) {
+        const GenSynapse* synapse = &synapses[order[i]];
+        const int32_t edge[3] = {synapse->from, synapse->to, synapse->type};
+        const uint8_t* bytes = (const uint8_t*)edge;
+        for (size_t b = 0; b < sizeof(edge); ++b) {
+            hash ^= bytes[b];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+static const char* type_name(int type) {
+    return type == GEN_SYNAPSE_ANTAGONISTIC ? "SYNAPSE_TYPE_ANTAGONISTIC" : "SYNAPSE_TYPE_NORMAL";
+}
+
+static int write_header(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        perror(path);
+        return 1;
+    }
+    fprintf(out, "// Generated by tools/gen_connectome.c. Do not edit.\n");
+    fprintf(out, "#ifndef CONNECTOME_GEN_H\n#define CONNECTOME_GEN_H\n\n");
+    fprintf(out, "#define CONNECTOME_NEURONS %d\n", GEN_NEURONS);
+    fprintf(out, "#define CONNECTOME_SYNAPSES %zu\n", synapse_total);
+    fprintf(out, "#define CONNECTOME_TOPOLOGY_HASH 0x%016" PRIx64 "ULL\n", topology_hash());
+    fprintf(out, "\n#endif // CONNECTOME_GEN_H\n");
+    return fclose(out) == 0 ? 0 : 1;
+}
+
+static int write_source(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        perror(path);
+        return 1;
+    }
+    fprintf(out, "// Generated by tools/gen_connectome.c. Do not edit.\n");
+    fprintf(out, "#include \"connectome.h\"\n\n");
+
+    fprintf(out, "const SynapseEdge_t connectome_edges[CONNECTOME_SYNAPSES] = {\n");
+    for (size_t i = 0; i < synapse_total; ++i) {
+        const GenSynapse* synapse = &synapses[order[i]];
+        fprintf(out, "    {%d, %d, %" PRId32 ", %s},\n", synapse->from, synapse->to,
+                synapse->neurotransmitter_type_fx, type_name(synapse->type));
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const SynapseState_t connectome_initial_state[CONNECTOME_SYNAPSES] = {\n");
+    for (size_t i = 0; i < synapse_total; ++i) {
+        const GenSynapse* synapse = &synapses[order[i]];
+        fprintf(out, "    {%" PRId32 ", %" PRId32 ", 0},\n", synapse->weight_fx, synapse->synaptic_strength_fx);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const uint16_t connectome_legacy_index[CONNECTOME_SYNAPSES] = {\n");
+    for (size_t i = 0; i < synapse_total; ++i) {
+        fprintf(out, "%s%zu,%s", i % 12 == 0 ? "    " : " ", order[i], i % 12 == 11 ? "\n" : "");
+    }
+    fprintf(out, "%s};\n", synapse_total % 12 == 0 ? "" : "\n");
+    return fclose(out) == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <connectome_gen.h> <connectome_gen.c>\n", argv[0]);
+        return 2;
+    }
+    init_synapses_biological();
+    for (size_t i = 0; i < synapse_total; ++i) {
+        order[i] = i;
+    }
+    qsort(order, synapse_total, sizeof(order[0]), compare_order);
+    return write_header(argv[1]) | write_source(argv[2]);
+}
@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../../common/net/car_link.h"
+
+/*
+ * Localhost stand-in for the base station. Listens for the car's state
+ * frames, prints a line per second and, with --drive, answers with motor
+ * commands at a fixed rate. --delay bases the commands on a state seen
+ * that long ago, and --reorder swaps each pair of commands on the wire,
+ * to exercise the car's stale and ordering checks.
+ */
+
+#define STATION_HISTORY 256
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int signo) {
+    (void)signo;
+    stop_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--port P] [--drive L,R] [--hold MS] [--rate HZ] [--delay MS] [--reorder] "
+            "[--seconds S]\n", argv0);
+}
+
+typedef struct {
+    uint32_t seq;
+    uint64_t rx_ns;
+} SeenState_t;
+
+int main(int argc, char** argv) {
+    int port = CAR_LINK_DEFAULT_PORT;
+    bool drive = false;
+    int left = 0;
+    int right = 0;
+    unsigned hold_ms = 300;
+    unsigned rate_hz = 20;
+    unsigned delay_ms = 0;
+    bool reorder = false;
+    double seconds = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--drive") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d,%d", &left, &right) != 2 || abs(left) > 100 || abs(right) > 100) {
+                fprintf(stderr, "--drive takes L,R in -100..100\n");
+                return 2;
+            }
+            drive = true;
+        } else if (strcmp(argv[i], "--hold") == 0 && i + 1 < argc) {
+            hold_ms = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate_hz = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+            delay_ms = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--reorder") == 0) {
+            reorder = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (rate_hz == 0 || port <= 0 || port > 65535) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int off = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    struct sockaddr_in6 local;
+    memset(&local, 0, sizeof(local));
+    local.sin6_family = AF_INET6;
+    local.sin6_addr = in6addr_any;
+    local.sin6_port = htons((uint16_t)port);
+    if (bind(fd, (struct sockaddr*)&local, sizeof(local)) != 0) {
+        perror("bind");
+        close(fd);
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    struct sockaddr_storage car;
+    socklen_t car_len = 0;
+    SeenState_t seen[STATION_HISTORY];
+    size_t seen_count = 0;
+    CarLinkState_t last;
+    memset(&last, 0, sizeof(last));
+    uint64_t states = 0, lost = 0, malformed = 0, commands = 0;
+    uint32_t command_seq = 0;
+    uint8_t held[CAR_LINK_COMMAND_BYTES];
+    bool have_held = false;
+
+    uint64_t start = now_ns();
+    uint64_t command_period = 1000000000ULL / rate_hz;
+    uint64_t next_command = start + command_period;
+    uint64_t next_report = start + 1000000000ULL;
+    uint64_t end = seconds > 0.0 ? start + (uint64_t)(seconds * 1e9) : UINT64_MAX;
+
+    while (!stop_requested) {
+        uint64_t now = now_ns();
+        if (now >= end) {
+            break;
+        }
+        uint64_t wake = next_report < next_command || !drive ? next_report : next_command;
+        int timeout_ms = wake > now ? (int)((wake - now + 999999) / 1000000) : 0;
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        now = now_ns();
+
+        if (ready > 0) {
+            uint8_t frame[64];
+            struct sockaddr_storage from;
+            socklen_t from_len = sizeof(from);
+            ssize_t len = recvfrom(fd, frame, sizeof(frame), 0, (struct sockaddr*)&from, &from_len);
+            CarLinkState_t state;
+            if (len > 0 && car_link_decode_state(frame, (size_t)len, &state)) {
+                if (states > 0 && car_link_seq_after(state.seq, last.seq + 1)) {
+                    lost += state.seq - last.seq - 1;
+                }
+                states++;
+                last = state;
+                car = from;
+                car_len = from_len;
+                seen[seen_count % STATION_HISTORY] = (SeenState_t){state.seq, now};
+                seen_count++;
+            } else if (len > 0) {
+                malformed++;
+            }
+        }
+
+        if (drive && now >= next_command) {
+            next_command += command_period;
+            // Base the command on the newest state that is at least delay_ms old
+            uint32_t basis = 0;
+            bool have_basis = false;
+            size_t depth = seen_count < STATION_HISTORY ? seen_count : STATION_HISTORY;
+            for (size_t back = 1; back <= depth; ++back) {
+                const SeenState_t* s = &seen[(seen_count - back) % STATION_HISTORY];
+                if (now - s->rx_ns >= (uint64_t)delay_ms * 1000000ULL) {
+                    basis = s->seq;
+                    have_basis = true;
+                    break;
+                }
+            }
+            if (have_basis && car_len > 0) {
+                CarLinkCommand_t command = {
+                    .seq = ++command_seq,
+                    .basis_state_seq = basis,
+                    .left_speed = (int8_t)left,
+                    .right_speed = (int8_t)right,
+                    .hold_ms = (uint16_t)hold_ms,
+                };
+                uint8_t frame[CAR_LINK_COMMAND_BYTES];
+                car_link_encode_command(&command, frame);
+                if (reorder && !have_held) {
+                    memcpy(held, frame, sizeof(held));
+                    have_held = true;
+                } else {
+                    sendto(fd, frame, sizeof(frame), 0, (struct sockaddr*)&car, car_len);
+                    commands++;
+                    if (have_held) {
+                        sendto(fd, held, sizeof(held), 0, (struct sockaddr*)&car, car_len);
+                        commands++;
+                        have_held = false;
+                    }
+                }
+            }
+        }
+
+        if (now >= next_report) {
+            next_report += 1000000000ULL;
+            printf("states %" PRIu64 " lost %" PRIu64 " | seq %u dist %u cm speed %d/%d salience %u/%u atp %u%s%s"
+                   " | commands sent %" PRIu64 " acked %u\n",
+                   states, lost, last.seq, last.distance_cm, last.left_speed, last.right_speed,
+                   last.salience_l, last.salience_r, last.atp,
+                   (last.flags & CAR_LINK_STATE_REST) ? " rest" : "",
+                   (last.flags & CAR_LINK_STATE_REMOTE) ? " remote" : "",
+                   commands, last.ack_command_seq);
+            fflush(stdout);
+        }
+    }
+
+    printf("Station: %" PRIu64 " states, %" PRIu64 " lost, %" PRIu64 " malformed, %" PRIu64
+           " commands sent, last acked %u\n", states, lost, malformed, commands, last.ack_command_seq);
+    close(fd);
+    return 0;
+}
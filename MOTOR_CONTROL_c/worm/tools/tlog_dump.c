@@ -0,0 +1,139 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libttak/math/fx.h"
+#include "libttak/tlog.h"
+#include "../../../common/telemetry/records.h"
+
+static const char* runner_action_name(uint8_t action) {
+    switch (action) {
+        case RUNNER_ACTION_FORWARD: return "forward";
+        case RUNNER_ACTION_BACKWARD: return "backward";
+        case RUNNER_ACTION_RIGHT: return "right";
+        case RUNNER_ACTION_LEFT: return "left";
+        case RUNNER_ACTION_STOP: return "stop";
+        case RUNNER_ACTION_RANDOM_TURN: return "random_turn";
+    }
+    return "unknown";
+}
+
+static const char* const neuromod_names[TELEMETRY_NEUROMOD_CHANNELS] = {TELEMETRY_NEUROMOD_NAMES};
+
+static void print_worm_header(void) {
+    fputs("timestamp_ns,left,right,rest", stdout);
+    for (size_t i = 0; i < TELEMETRY_NEUROMOD_CHANNELS; ++i) {
+        printf(",%s", neuromod_names[i]);
+    }
+    putchar('\n');
+}
+
+static void print_worm(const WormTelemetry_t* rec) {
+    printf("%" PRIu64 ",%d,%d,%u", rec->timestamp_ns, rec->left_speed, rec->right_speed, rec->rest_mode);
+    for (size_t i = 0; i < TELEMETRY_NEUROMOD_CHANNELS; ++i) {
+        printf(",%.4f", (double)ttak_fx_to_float(rec->neuromod_fx[i]));
+    }
+    putchar('\n');
+}
+
+static void print_runner(const RunnerTelemetry_t* rec) {
+    printf("%" PRIu64 ",%u,%c,%s,%u,%u\n",
+           rec->timestamp_ns, rec->distance_cm, rec->ir_flag ? (char)rec->ir_flag : '-',
+           runner_action_name(rec->action), rec->left_speed, rec->right_speed);
+}
+
+static const char* trace_event_name(uint8_t type) {
+    switch (type) {
+        case TRACE_EVENT_SEED: return "seed";
+        case TRACE_EVENT_TICK: return "tick";
+        case TRACE_EVENT_DISTANCE: return "distance";
+        case TRACE_EVENT_ULTRA_PACKET: return "ultra_packet";
+        case TRACE_EVENT_VISION: return "vision";
+        case TRACE_EVENT_REMOTE_DRIVE: return "remote_drive";
+    }
+    return "unknown";
+}
+
+static void print_trace(const WormTraceRecord_t* rec) {
+    printf("%" PRIu64 ",%u,%s,%u\n", rec->timestamp_ns, rec->tick, trace_event_name(rec->type), rec->value);
+}
+
+static int dump_file(const char* path, int print_header) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    ttak_tlog_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, TTAK_TLOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TTAK_TLOG_VERSION) {
+        fprintf(stderr, "%s: not a telemetry segment\n", path);
+        fclose(file);
+        return 1;
+    }
+
+    size_t expected = 0;
+    switch (header.record_kind) {
+        case TELEMETRY_KIND_WORM: expected = sizeof(WormTelemetry_t); break;
+        case TELEMETRY_KIND_RUNNER: expected = sizeof(RunnerTelemetry_t); break;
+        case TELEMETRY_KIND_WORM_TRACE: expected = sizeof(WormTraceRecord_t); break;
+        default: break;
+    }
+    if (expected == 0 || header.record_size != expected) {
+        fprintf(stderr, "%s: unsupported record kind %u (size %u)\n",
+                path, header.record_kind, header.record_size);
+        fclose(file);
+        return 1;
+    }
+
+    fprintf(stderr, "%s: segment %u, %" PRIu64 "/%" PRIu64 " records, %" PRIu64 " dropped\n",
+            path, header.segment_index, header.record_count, header.record_capacity, header.dropped);
+    if (print_header) {
+        if (header.record_kind == TELEMETRY_KIND_WORM) {
+            print_worm_header();
+        } else if (header.record_kind == TELEMETRY_KIND_RUNNER) {
+            puts("timestamp_ns,distance_cm,ir,action,left,right");
+        } else {
+            puts("timestamp_ns,tick,event,value");
+        }
+    }
+
+    union {
+        WormTelemetry_t worm;
+        RunnerTelemetry_t runner;
+        WormTraceRecord_t trace;
+    } record;
+    for (uint64_t i = 0; i < header.record_count; ++i) {
+        if (fread(&record, header.record_size, 1, file) != 1) {
+            fprintf(stderr, "%s: truncated after %" PRIu64 " records\n", path, i);
+            break;
+        }
+        if (header.record_kind == TELEMETRY_KIND_WORM) {
+            print_worm(&record.worm);
+        } else if (header.record_kind == TELEMETRY_KIND_RUNNER) {
+            print_runner(&record.runner);
+        } else {
+            print_trace(&record.trace);
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <telemetry.bin> [older segments...]\n", argv[0]);
+        return 2;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; ++i) {
+        status |= dump_file(argv[i], i == 1);
+    }
+    return status;
+}
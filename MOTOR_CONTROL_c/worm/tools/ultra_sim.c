@@ -0,0 +1,483 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultrasonic.h"
+#include "../../../common/ultrasonic/ultra_demod.h"
+
+/*
+ * Simulated ultrasonic channel. Every car starts a packet every interval
+ * plus a random slack (or as soon as the previous one is off the air),
+ * using the worm's encoders, and every car listens to the others through
+ * the driver's demodulator. Every car also ranges periodically, as the
+ * sensor hub does: its own echo blanks its line, and the others hear the
+ * burst. Ranging is refused while a frame is on air and an echo is only
+ * dropped as our own right after our trigger, both as the driver does.
+ * The channel adds edge jitter, missed pulses, noise pulses and collisions
+ * (overlapping echoes merge into one pulse). Prints delivery, throughput
+ * and latency per protocol.
+ */
+
+#define MAX_CARS 8 // v1 packets carry no sender, the emotion code stands in for one
+#define RANGE_MIN_CM 20
+#define ECHO_NS_PER_CM 58000u // there and back at 343 m/s
+#define RANGING_TRIGGER_NS 10000u // the driver's ranging trigger, all the other cars hear of it
+
+typedef struct {
+    uint64_t rise_ns;
+    uint64_t fall_ns;
+} Pulse_t;
+
+typedef struct {
+    Pulse_t* items;
+    size_t count;
+    size_t capacity;
+} PulseList_t;
+
+typedef struct {
+    uint64_t submit_ns;
+    uint64_t end_ns;
+    uint8_t packet;
+    uint8_t seq;
+} Sent_t;
+
+typedef struct {
+    Sent_t* items;
+    size_t count;
+    size_t capacity;
+} SentList_t;
+
+typedef struct {
+    int cars;
+    double seconds;
+    double noise_hz;
+    uint32_t jitter_us;
+    double loss;
+    uint32_t interval_ms;
+    uint32_t slack_ms;
+    uint32_t ranging_ms; // 0 for no ranging
+    uint32_t range_cm;   // ranging targets lie between RANGE_MIN_CM and this
+    uint32_t seed;
+} SimConfig_t;
+
+typedef struct {
+    uint64_t offered;   // packets sent times the cars that could hear them
+    uint64_t airtime_ns;
+    uint64_t delivered;
+    uint64_t corrupt;   // decoded, but not what was sent
+    uint64_t* latency_ns;
+    size_t latency_count;
+    size_t latency_capacity;
+    uint64_t ranging;   // measurements taken
+    uint64_t held_off;  // measurements the driver refused while a frame was on air
+    struct ultra_demod_stats demod;
+} SimResult_t;
+
+enum { LINE_HEARD, LINE_RANGING, LINE_ECHO, LINE_COUNT };
+
+/*
+ * One car's receiver. Its echo line carries the other cars' frames and
+ * noise, known up front, the other cars' ranging bursts and its own
+ * ranging echoes, both added as the cars range. Pulses reach the
+ * demodulator once nothing later can merge into them.
+ */
+typedef struct {
+    int car;
+    PulseList_t lines[LINE_COUNT]; // each sorted by rising edge
+    size_t next[LINE_COUNT];
+    size_t blank_next[2];          // own trigger pulses and echoes that may still blank a rise
+    size_t sent_next;              // own trigger pulses up to the current time
+    struct ultra_demod demod;
+    uint64_t busy_until;           // the driver's hold-off for the frame being received
+} Listener_t;
+
+static uint64_t rng_state;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 16);
+}
+
+static double rng_unit(void) {
+    return (double)rng_next() / 4294967296.0;
+}
+
+static void* grow(void* items, size_t* capacity, size_t size) {
+    *capacity = *capacity ? *capacity * 2 : 256;
+    void* grown = realloc(items, *capacity * size);
+    if (grown == NULL) {
+        perror("ultra_sim");
+        exit(1);
+    }
+    return grown;
+}
+
+static void pulse_push(PulseList_t* list, uint64_t rise_ns, uint64_t fall_ns) {
+    if (list->count == list->capacity) {
+        list->items = grow(list->items, &list->capacity, sizeof(Pulse_t));
+    }
+    list->items[list->count++] = (Pulse_t){rise_ns, fall_ns};
+}
+
+static void sent_push(SentList_t* list, Sent_t sent) {
+    if (list->count == list->capacity) {
+        list->items = grow(list->items, &list->capacity, sizeof(Sent_t));
+    }
+    list->items[list->count++] = sent;
+}
+
+static void latency_push(SimResult_t* result, uint64_t latency_ns) {
+    if (result->latency_count == result->latency_capacity) {
+        result->latency_ns = grow(result->latency_ns, &result->latency_capacity, sizeof(uint64_t));
+    }
+    result->latency_ns[result->latency_count++] = latency_ns;
+}
+
+static int compare_pulse(const void* a, const void* b) {
+    const Pulse_t* pa = a;
+    const Pulse_t* pb = b;
+    return (pa->rise_ns > pb->rise_ns) - (pa->rise_ns < pb->rise_ns);
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t va = *(const uint64_t*)a;
+    uint64_t vb = *(const uint64_t*)b;
+    return (va > vb) - (va < vb);
+}
+
+static uint64_t jitter_ns(uint32_t jitter_us) {
+    return jitter_us ? (uint64_t)rng_next() % ((uint64_t)jitter_us * 1000u) : 0;
+}
+
+// One car's transmissions: what the trigger did and what each packet carried
+static uint64_t transmit(const SimConfig_t* config, int version, int car, PulseList_t* air, SentList_t* sent) {
+    uint64_t airtime_ns = 0;
+    uint64_t end_ns = (uint64_t)(config->seconds * 1e9);
+    uint64_t t = (uint64_t)rng_next() % ((uint64_t)(config->interval_ms + config->slack_ms) * 1000000u + 1u);
+    uint8_t seq = 0;
+    while (t < end_ns) {
+        uint8_t packet = (uint8_t)(ULTRA_START_BIT | (car & 0x7) << 3 | (rng_next() & 0x3u) << 1 | ULTRA_STOP_BIT);
+        UltraSchedule_t schedule;
+        if (version == 1) {
+            Ultra_encode_v1(packet, &schedule);
+        } else {
+            uint8_t frame[ULTRA2_FRAME_BYTES];
+            ultra2_frame_build(frame, (uint8_t)car, seq, packet, 0);
+            Ultra_encode_v2(frame, &schedule);
+        }
+        uint64_t start = t;
+        Sent_t record = {.submit_ns = t, .packet = packet, .seq = seq++};
+        for (size_t i = 0; i < schedule.count; ++i) {
+            uint64_t fall = t + (uint64_t)schedule.pulses[i].width_us * 1000u;
+            pulse_push(air, t, fall);
+            record.end_ns = fall;
+            t = fall + schedule.pulses[i].gap_ns;
+        }
+        airtime_ns += record.end_ns - start;
+        sent_push(sent, record);
+        if (t < start + (uint64_t)config->interval_ms * 1000000u) {
+            t = start + (uint64_t)config->interval_ms * 1000000u;
+        }
+        t += (uint64_t)(rng_unit() * config->slack_ms * 1e6);
+    }
+    return airtime_ns;
+}
+
+// Newest packet from car that had finished by rx_ns and matches the decoded seq (v2) or any (v1)
+static const Sent_t* find_sent(const SentList_t* sent, int version, uint8_t seq, uint64_t rx_ns) {
+    for (size_t i = sent->count; i-- > 0;) {
+        const Sent_t* record = &sent->items[i];
+        if (record->end_ns > rx_ns) {
+            continue;
+        }
+        if (version == 1 || record->seq == seq) {
+            return record;
+        }
+    }
+    return NULL;
+}
+
+static int earliest_line(const Listener_t* listener, const size_t next[LINE_COUNT]) {
+    int best = -1;
+    for (int line = 0; line < LINE_COUNT; ++line) {
+        if (next[line] < listener->lines[line].count &&
+            (best < 0 ||
+             listener->lines[line].items[next[line]].rise_ns < listener->lines[best].items[next[best]].rise_ns)) {
+            best = line;
+        }
+    }
+    return best;
+}
+
+// True if rise_ns comes right after one of our trigger edges, where the driver takes it for our own echo
+static bool blanked(const PulseList_t* triggers, size_t* next, uint64_t rise_ns) {
+    while (*next < triggers->count && triggers->items[*next].rise_ns + ULTRA_SELF_ECHO_RISE_NS <= rise_ns) {
+        (*next)++;
+    }
+    return *next < triggers->count && triggers->items[*next].rise_ns <= rise_ns;
+}
+
+// Feeds the demodulator every pulse on the listener's line that has ended before until_ns
+static void listen_until(const SimConfig_t* config, int version, Listener_t* listener, const PulseList_t* air,
+                         const SentList_t* sent, uint64_t until_ns, SimResult_t* result) {
+    for (;;) {
+        // The echo line is an OR of everything in the air
+        size_t next[LINE_COUNT];
+        memcpy(next, listener->next, sizeof(next));
+        int line = earliest_line(listener, next);
+        if (line < 0) {
+            return;
+        }
+        Pulse_t pulse = listener->lines[line].items[next[line]++];
+        for (int joining; (joining = earliest_line(listener, next)) >= 0;) {
+            const Pulse_t* item = &listener->lines[joining].items[next[joining]];
+            if (item->rise_ns > pulse.fall_ns) {
+                break;
+            }
+            if (item->fall_ns > pulse.fall_ns) {
+                pulse.fall_ns = item->fall_ns;
+            }
+            next[joining]++;
+        }
+        if (pulse.fall_ns >= until_ns) {
+            return;
+        }
+        memcpy(listener->next, next, sizeof(next));
+
+        if (blanked(&air[listener->car], &listener->blank_next[0], pulse.rise_ns) ||
+            blanked(&listener->lines[LINE_ECHO], &listener->blank_next[1], pulse.rise_ns)) {
+            continue;
+        }
+        uint64_t rise = pulse.rise_ns + jitter_ns(config->jitter_us);
+        uint64_t fall = pulse.fall_ns + jitter_ns(config->jitter_us);
+        struct ultra_rx_packet rx;
+        int got = ultra_demod_pulse(&listener->demod, rise, fall, &rx);
+        listener->busy_until = ultra_demod_busy_until(&listener->demod);
+        if (!got) {
+            continue;
+        }
+        int car = version == 1 ? (rx.packet >> 3) & 0x7 : rx.sender;
+        const Sent_t* record = car < config->cars && car != listener->car
+                             ? find_sent(&sent[car], version, rx.seq, rx.rx_ns) : NULL;
+        if (record == NULL || record->packet != rx.packet) {
+            result->corrupt++;
+            continue;
+        }
+        result->delivered++;
+        latency_push(result, rx.rx_ns - record->submit_ns);
+    }
+}
+
+// One ranging read by car at now_ns
+static void range(const SimConfig_t* config, int version, Listener_t* listeners, int car, const PulseList_t* air,
+                  const SentList_t* sent, uint64_t now_ns, SimResult_t* result) {
+    Listener_t* listener = &listeners[car];
+    listen_until(config, version, listener, air, sent, now_ns, result);
+    const PulseList_t* own = &air[car];
+    while (listener->sent_next < own->count && own->items[listener->sent_next].rise_ns <= now_ns) {
+        listener->sent_next++;
+    }
+    bool sending = listener->sent_next > 0 &&
+                   now_ns < own->items[listener->sent_next - 1].rise_ns + ULTRA2_GAP_TIMEOUT_NS;
+    if (sending || now_ns < listener->busy_until) {
+        result->held_off++;
+        return;
+    }
+    result->ranging++;
+
+    uint32_t cm = RANGE_MIN_CM + rng_next() % (config->range_cm - RANGE_MIN_CM + 1u);
+    pulse_push(&listener->lines[LINE_ECHO], now_ns, now_ns + (uint64_t)cm * ECHO_NS_PER_CM);
+    for (int other = 0; other < config->cars; ++other) {
+        if (other != car && rng_unit() >= config->loss) {
+            pulse_push(&listeners[other].lines[LINE_RANGING], now_ns, now_ns + RANGING_TRIGGER_NS);
+        }
+    }
+}
+
+static void listener_init(const SimConfig_t* config, Listener_t* listener, int car, const PulseList_t* air) {
+    memset(listener, 0, sizeof(*listener));
+    listener->car = car;
+    PulseList_t* heard = &listener->lines[LINE_HEARD];
+    uint64_t end_ns = (uint64_t)(config->seconds * 1e9);
+
+    // Noise arrives as a Poisson process with random widths up to 5 ms
+    if (config->noise_hz > 0.0) {
+        double t = 0.0;
+        for (;;) {
+            t += -1e9 * log1p(-rng_unit()) / config->noise_hz;
+            if (t >= (double)end_ns) {
+                break;
+            }
+            uint64_t rise = (uint64_t)t;
+            pulse_push(heard, rise, rise + 100000u + (uint64_t)rng_next() % 4900000u);
+        }
+    }
+    for (int other = 0; other < config->cars; ++other) {
+        if (other == car) {
+            continue;
+        }
+        for (size_t i = 0; i < air[other].count; ++i) {
+            if (rng_unit() >= config->loss) {
+                pulse_push(heard, air[other].items[i].rise_ns, air[other].items[i].fall_ns);
+            }
+        }
+    }
+    qsort(heard->items, heard->count, sizeof(Pulse_t), compare_pulse);
+}
+
+static double percentile_ms(const SimResult_t* result, double fraction) {
+    if (result->latency_count == 0) {
+        return 0.0;
+    }
+    size_t index = (size_t)(fraction * (double)(result->latency_count - 1));
+    return (double)result->latency_ns[index] / 1e6;
+}
+
+static void simulate(const SimConfig_t* config, int version) {
+    PulseList_t air[MAX_CARS];
+    SentList_t sent[MAX_CARS];
+    Listener_t listeners[MAX_CARS];
+    SimResult_t result;
+    memset(air, 0, sizeof(air));
+    memset(sent, 0, sizeof(sent));
+    memset(&result, 0, sizeof(result));
+
+    rng_state = config->seed * 2654435761u + 1u;
+    for (int car = 0; car < config->cars; ++car) {
+        result.airtime_ns += transmit(config, version, car, &air[car], &sent[car]);
+        result.offered += sent[car].count * (uint64_t)(config->cars - 1);
+    }
+    for (int car = 0; car < config->cars; ++car) {
+        listener_init(config, &listeners[car], car, air);
+    }
+
+    // Ranging depends on what each car has heard so far, so all cars range in one time order
+    uint64_t end_ns = (uint64_t)(config->seconds * 1e9);
+    uint64_t period_ns = (uint64_t)config->ranging_ms * 1000000u;
+    uint64_t next_ranging[MAX_CARS];
+    for (int car = 0; car < config->cars; ++car) {
+        next_ranging[car] = period_ns ? rng_next() % period_ns : end_ns;
+    }
+    for (;;) {
+        int car = 0;
+        for (int other = 1; other < config->cars; ++other) {
+            if (next_ranging[other] < next_ranging[car]) {
+                car = other;
+            }
+        }
+        if (next_ranging[car] >= end_ns) {
+            break;
+        }
+        range(config, version, listeners, car, air, sent, next_ranging[car], &result);
+        next_ranging[car] += period_ns;
+    }
+    for (int car = 0; car < config->cars; ++car) {
+        Listener_t* listener = &listeners[car];
+        listen_until(config, version, listener, air, sent, UINT64_MAX, &result);
+        result.demod.packets += listener->demod.stats.packets;
+        result.demod.frame_errors += listener->demod.stats.frame_errors;
+        result.demod.crc_errors += listener->demod.stats.crc_errors;
+        result.demod.noise += listener->demod.stats.noise;
+    }
+    qsort(result.latency_ns, result.latency_count, sizeof(uint64_t), compare_u64);
+
+    // Payload carried per packet: emotion and intensity, plus sender, seq and age in v2
+    int payload_bits = version == 1 ? 5 : 5 + 3 * 8;
+    int links = config->cars * (config->cars - 1);
+    double per_link = (double)result.delivered / (double)links / config->seconds;
+    uint64_t reads = result.ranging + result.held_off;
+    printf("v%d  on air %4.1f%%  offered %6" PRIu64 "  delivered %6" PRIu64 " (%5.1f%%)  corrupt %4" PRIu64
+           "  %5.2f pkt/s/link  %6.1f bit/s/link  latency ms p50 %7.1f p99 %7.1f max %7.1f"
+           "  frame errors %llu crc errors %llu noise %llu  ranging held off %4.1f%%\n",
+           version, 100.0 * (double)result.airtime_ns / (config->seconds * 1e9 * config->cars),
+           result.offered, result.delivered,
+           result.offered ? 100.0 * (double)result.delivered / (double)result.offered : 0.0,
+           result.corrupt, per_link, per_link * payload_bits,
+           percentile_ms(&result, 0.5), percentile_ms(&result, 0.99), percentile_ms(&result, 1.0),
+           (unsigned long long)result.demod.frame_errors, (unsigned long long)result.demod.crc_errors,
+           (unsigned long long)result.demod.noise, reads ? 100.0 * (double)result.held_off / (double)reads : 0.0);
+
+    for (int car = 0; car < config->cars; ++car) {
+        free(air[car].items);
+        free(sent[car].items);
+        for (int line = 0; line < LINE_COUNT; ++line) {
+            free(listeners[car].lines[line].items);
+        }
+    }
+    free(result.latency_ns);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--cars N] [--seconds S] [--noise HZ] [--jitter US] [--loss P] "
+            "[--interval MS] [--slack MS] [--ranging MS] [--range CM] [--seed N] [--protocol 1|2]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    SimConfig_t config = {
+        .cars = 3,
+        .seconds = 120.0,
+        .noise_hz = 2.0,
+        .jitter_us = 50,
+        .loss = 0.01,
+        .interval_ms = 1500, // the worm's vocalization cooldown
+        .slack_ms = 500,
+        .ranging_ms = 50, // the sensor hub's 20 Hz
+        .range_cm = 200,
+        .seed = 1,
+    };
+    int only_version = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+        }
+        const char* value = argv[++i];
+        if (strcmp(argv[i - 1], "--cars") == 0) {
+            config.cars = atoi(value);
+        } else if (strcmp(argv[i - 1], "--seconds") == 0) {
+            config.seconds = atof(value);
+        } else if (strcmp(argv[i - 1], "--noise") == 0) {
+            config.noise_hz = atof(value);
+        } else if (strcmp(argv[i - 1], "--jitter") == 0) {
+            config.jitter_us = (uint32_t)atoi(value);
+        } else if (strcmp(argv[i - 1], "--loss") == 0) {
+            config.loss = atof(value);
+        } else if (strcmp(argv[i - 1], "--interval") == 0) {
+            config.interval_ms = (uint32_t)atoi(value);
+        } else if (strcmp(argv[i - 1], "--slack") == 0) {
+            config.slack_ms = (uint32_t)atoi(value);
+        } else if (strcmp(argv[i - 1], "--ranging") == 0) {
+            config.ranging_ms = (uint32_t)atoi(value);
+        } else if (strcmp(argv[i - 1], "--range") == 0) {
+            config.range_cm = (uint32_t)atoi(value);
+        } else if (strcmp(argv[i - 1], "--seed") == 0) {
+            config.seed = (uint32_t)atoi(value);
+        } else if (strcmp(argv[i - 1], "--protocol") == 0) {
+            only_version = atoi(value);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (config.cars < 2 || config.cars > MAX_CARS || config.seconds <= 0.0 || config.range_cm < RANGE_MIN_CM ||
+        only_version < 0 || only_version > 2) {
+        usage(argv[0]);
+    }
+
+    printf("%d cars, %.0f s, noise %.1f Hz, jitter %u us, pulse loss %.1f%%, a packet every %u + 0..%u ms, "
+           "ranging every %u ms up to %u cm\n",
+           config.cars, config.seconds, config.noise_hz, config.jitter_us, config.loss * 100.0,
+           config.interval_ms, config.slack_ms, config.ranging_ms, config.range_cm);
+    for (int version = 1; version <= 2; ++version) {
+        if (only_version == 0 || only_version == version) {
+            simulate(&config, version);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRACE_SEGMENT_RECORDS (1u << 20)
+
+static uint64_t trace_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+bool WormTrace_record_open(WormTrace_t* trace, const char* path, uint32_t seed,
+                           void* ring_backing, size_t ring_slots) {
+    memset(trace, 0, sizeof(*trace));
+    const ttak_tlog_config_t config = {
+        .path = path,
+        .record_kind = TELEMETRY_KIND_WORM_TRACE,
+        .record_size = sizeof(WormTraceRecord_t),
+        .segment_records = TRACE_SEGMENT_RECORDS,
+        .keep_segments = WORM_TRACE_KEEP_SEGMENTS,
+    };
+    if (!ttak_tlog_open(&trace->log, &config, ring_backing, ring_slots)) {
+        return false;
+    }
+    trace->recording = true;
+    trace->tick_ns = trace_clock_ns();
+    WormTrace_record_event(trace, TRACE_EVENT_SEED, seed);
+    return true;
+}
+
+void WormTrace_record_tick(WormTrace_t* trace, uint64_t now_ns) {
+    if (!trace->recording) {
+        return;
+    }
+    trace->tick++;
+    trace->tick_ns = now_ns;
+    WormTrace_record_event(trace, TRACE_EVENT_TICK, 0);
+}
+
+void WormTrace_record_event(WormTrace_t* trace, uint8_t type, uint32_t value) {
+    if (!trace->recording) {
+        return;
+    }
+    WormTraceRecord_t record = {
+        .timestamp_ns = trace->tick_ns,
+        .tick = trace->tick,
+        .value = value,
+        .type = type,
+    };
+    ttak_tlog_write(&trace->log, &record);
+}
+
+static bool map_segment(const char* path, WormTraceSegment_t* segment, const ttak_tlog_header_t** header_out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ttak_tlog_header_t)) {
+        fprintf(stderr, "%s: not a trace file\n", path);
+        close(fd);
+        return false;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return false;
+    }
+
+    const ttak_tlog_header_t* header = (const ttak_tlog_header_t*)map;
+    size_t available = ((size_t)st.st_size - sizeof(*header)) / sizeof(WormTraceRecord_t);
+    if (memcmp(header->magic, TTAK_TLOG_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TTAK_TLOG_VERSION ||
+        header->record_kind != TELEMETRY_KIND_WORM_TRACE ||
+        header->record_size != sizeof(WormTraceRecord_t) ||
+        header->record_count > available) {
+        fprintf(stderr, "%s: not a worm trace segment\n", path);
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    segment->map = map;
+    segment->map_size = (size_t)st.st_size;
+    segment->records = (const WormTraceRecord_t*)((const uint8_t*)map + sizeof(*header));
+    segment->record_count = (size_t)header->record_count;
+    *header_out = header;
+    return true;
+}
+
+bool WormTrace_replay_open(WormTrace_t* trace, const char* path, uint32_t* seed) {
+    memset(trace, 0, sizeof(*trace));
+    WormTraceSegment_t newest;
+    const ttak_tlog_header_t* header;
+    if (!map_segment(path, &newest, &header)) {
+        return false;
+    }
+    // The newest segment's index tells how many older ones the recording rotated out
+    uint32_t newest_index = header->segment_index;
+    if (newest_index > WORM_TRACE_KEEP_SEGMENTS) {
+        fprintf(stderr, "%s: trace rotated through %u segments and only the last %u are kept, cannot replay it\n",
+                path, newest_index + 1, WORM_TRACE_KEEP_SEGMENTS + 1);
+        munmap(newest.map, newest.map_size);
+        return false;
+    }
+    trace->segments[newest_index] = newest;
+    trace->segment_count = newest_index + 1;
+    uint64_t dropped = header->dropped;
+
+    char older[512];
+    for (uint32_t age = 1; age <= newest_index; ++age) {
+        uint32_t index = newest_index - age;
+        snprintf(older, sizeof(older), "%s.%u", path, age);
+        if (!map_segment(older, &trace->segments[index], &header) || header->segment_index != index) {
+            fprintf(stderr, "%s: segment %u of the trace is missing, cannot replay it\n", older, index);
+            WormTrace_close(trace);
+            return false;
+        }
+    }
+
+    trace->replaying = true;
+    if (dropped > 0) {
+        fprintf(stderr, "%s: %llu events were dropped while recording, replay may diverge\n",
+                path, (unsigned long long)dropped);
+    }
+
+    const WormTraceSegment_t* first = &trace->segments[0];
+    if (first->record_count > 0 && first->records[0].type == TRACE_EVENT_SEED) {
+        *seed = first->records[0].value;
+        trace->cursor = 1;
+    } else {
+        fprintf(stderr, "%s: trace has no seed, replay will not be deterministic\n", path);
+        *seed = 0;
+    }
+    return true;
+}
+
+// The record at the cursor, stepping over segment ends; NULL at the end of the trace
+static const WormTraceRecord_t* current_record(WormTrace_t* trace) {
+    while (trace->segment < trace->segment_count) {
+        const WormTraceSegment_t* segment = &trace->segments[trace->segment];
+        if (trace->cursor < segment->record_count) {
+            return &segment->records[trace->cursor];
+        }
+        trace->segment++;
+        trace->cursor = 0;
+    }
+    return NULL;
+}
+
+bool WormTrace_next_tick(WormTrace_t* trace) {
+    const WormTraceRecord_t* record;
+    while ((record = current_record(trace)) != NULL) {
+        trace->cursor++;
+        if (record->type == TRACE_EVENT_TICK) {
+            trace->tick = record->tick;
+            trace->tick_ns = record->timestamp_ns;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WormTrace_take(WormTrace_t* trace, uint8_t type, uint32_t* value) {
+    if (!trace->replaying) {
+        return false;
+    }
+    const WormTraceRecord_t* record = current_record(trace);
+    if (record == NULL || record->type != type) {
+        return false;
+    }
+    *value = record->value;
+    trace->cursor++;
+    return true;
+}
+
+void WormTrace_close(WormTrace_t* trace) {
+    if (trace->recording) {
+        ttak_tlog_close(&trace->log);
+        trace->recording = false;
+    }
+    for (size_t i = 0; i < WORM_TRACE_KEEP_SEGMENTS + 1; ++i) {
+        if (trace->segments[i].map != NULL) {
+            munmap(trace->segments[i].map, trace->segments[i].map_size);
+            trace->segments[i].map = NULL;
+        }
+    }
+    trace->segment_count = 0;
+    trace->replaying = false;
+}
@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libttak/tlog.h"
+#include "../../common/telemetry/records.h"
+
+/*
+ * Sensor trace recorder/player for the worm controller.
+ *
+ * Recording pushes WormTraceRecord_t events through a telemetry log, so
+ * the control thread only pays a memcpy per event. Replay maps every
+ * segment of a recording, oldest first, and hands the same inputs back,
+ * tick by tick, in the order the controller consumed them.
+ */
+#define WORM_TRACE_KEEP_SEGMENTS 8
+
+typedef struct {
+    void* map;
+    size_t map_size;
+    const WormTraceRecord_t* records;
+    size_t record_count;
+} WormTraceSegment_t;
+
+typedef struct {
+    bool recording;
+    bool replaying;
+    ttak_tlog_t log;
+    uint32_t tick;
+    uint64_t tick_ns;
+
+    WormTraceSegment_t segments[WORM_TRACE_KEEP_SEGMENTS + 1];
+    size_t segment_count;
+    size_t segment;   // segment being replayed
+    size_t cursor;    // next record within it
+} WormTrace_t;
+
+/*
+ * ring_backing must hold sizeof(WormTraceRecord_t) * ring_slots bytes.
+ */
+bool WormTrace_record_open(WormTrace_t* trace, const char* path, uint32_t seed,
+                           void* ring_backing, size_t ring_slots);
+void WormTrace_record_tick(WormTrace_t* trace, uint64_t now_ns);
+void WormTrace_record_event(WormTrace_t* trace, uint8_t type, uint32_t value);
+
+/*
+ * Opens path and the older segments it rotated to (path.1, path.2, ...).
+ * Fails if the recording rotated past the segments kept on disk, since
+ * the seed and the first ticks are gone with its first segment.
+ */
+bool WormTrace_replay_open(WormTrace_t* trace, const char* path, uint32_t* seed);
+
+/*
+ * Advances to the next recorded tick. Returns false at the end of the trace.
+ */
+bool WormTrace_next_tick(WormTrace_t* trace);
+
+/*
+ * Consumes the next event of the current tick if it has the given type.
+ */
+bool WormTrace_take(WormTrace_t* trace, uint8_t type, uint32_t* value);
+
+void WormTrace_close(WormTrace_t* trace);
+
+#endif // TRACE_H
@@ -0,0 +1,244 @@
+#define _GNU_SOURCE
+
+#include "ultrasonic.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+void Ultra_encode_v1(uint8_t packet, UltraSchedule_t* schedule) {
+    schedule->count = 0;
+    for (int bit = ULTRA_PACKET_BITS - 1; bit >= 0; --bit) {
+        if ((packet >> bit) & 0x1u) {
+            schedule->pulses[schedule->count++] = (UltraPulse_t){ULTRA_PULSE_LONG_US, ULTRA_INTERVAL_ONE_NS};
+        } else {
+            schedule->pulses[schedule->count++] = (UltraPulse_t){ULTRA_PULSE_SHORT_US, ULTRA_INTERVAL_ZERO_NS};
+            schedule->pulses[schedule->count++] = (UltraPulse_t){ULTRA_PULSE_SHORT_US, ULTRA_INTERVAL_ZERO_NS};
+        }
+    }
+}
+
+void Ultra_encode_v2(const uint8_t frame[ULTRA2_FRAME_BYTES], UltraSchedule_t* schedule) {
+    schedule->count = 0;
+    schedule->pulses[schedule->count++] = (UltraPulse_t){ULTRA2_SYNC_US, ULTRA2_GAP_NS};
+    for (int i = 0; i < ULTRA2_FRAME_SYMBOLS; ++i) {
+        int bit = i * ULTRA2_SYMBOL_BITS;
+        unsigned symbol = (frame[bit / 8] >> (8 - ULTRA2_SYMBOL_BITS - bit % 8)) & ((1u << ULTRA2_SYMBOL_BITS) - 1);
+        schedule->pulses[schedule->count++] = (UltraPulse_t){(symbol + 1) * ULTRA2_SYMBOL_BASE_US, ULTRA2_GAP_NS};
+    }
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static struct timespec timespec_add_ns(struct timespec ts, uint64_t ns) {
+    ts.tv_sec += (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec += (long)(ns % 1000000000ULL);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+static int64_t timespec_diff_ns(const struct timespec* a, const struct timespec* b) {
+    return (int64_t)(a->tv_sec - b->tv_sec) * 1000000000LL + (a->tv_nsec - b->tv_nsec);
+}
+
+static void set_trigger(UltraSender_t* sender, bool high) {
+    const char value = high ? '1' : '0';
+    if (write(sender->fd, &value, 1) < 0) {
+        // The packet goes on; the receiver drops it on framing
+        pthread_mutex_lock(&sender->lock);
+        sender->stats.failed_edges++;
+        pthread_mutex_unlock(&sender->lock);
+    }
+}
+
+/*
+ * Sleeps until deadline unless stopped first. The condition variable runs
+ * on CLOCK_MONOTONIC, so UltraSender_stop interrupts a 200 ms gap at once.
+ */
+static bool wait_until(UltraSender_t* sender, const struct timespec* deadline) {
+    pthread_mutex_lock(&sender->lock);
+    while (!sender->stop) {
+        if (pthread_cond_timedwait(&sender->wake, &sender->lock, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    bool stopped = sender->stop;
+    if (!stopped) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t late = timespec_diff_ns(&now, deadline);
+        if (late > 0 && (uint64_t)late > sender->stats.max_edge_late_ns) {
+            sender->stats.max_edge_late_ns = (uint64_t)late;
+        }
+    }
+    pthread_mutex_unlock(&sender->lock);
+    return !stopped;
+}
+
+// Edges are scheduled from the packet start, so wakeup latency does not accumulate
+static bool transmit(UltraSender_t* sender, const UltraSchedule_t* schedule) {
+    struct timespec edge;
+    clock_gettime(CLOCK_MONOTONIC, &edge);
+    for (size_t i = 0; i < schedule->count; ++i) {
+        set_trigger(sender, true);
+        edge = timespec_add_ns(edge, (uint64_t)schedule->pulses[i].width_us * 1000ULL);
+        bool on_time = wait_until(sender, &edge);
+        set_trigger(sender, false);
+        if (!on_time) {
+            return false;
+        }
+        edge = timespec_add_ns(edge, schedule->pulses[i].gap_ns);
+        if (!wait_until(sender, &edge)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void* sender_main(void* arg) {
+    UltraSender_t* sender = (UltraSender_t*)arg;
+    if (sender->rt_priority > 0) {
+        struct sched_param param = {.sched_priority = sender->rt_priority};
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0) {
+            fprintf(stderr, "ultrasonic sender keeps SCHED_OTHER (%s)\n", strerror(rc));
+        }
+    }
+
+    pthread_mutex_lock(&sender->lock);
+    while (!sender->stop) {
+        if (!sender->has_pending) {
+            pthread_cond_wait(&sender->wake, &sender->lock);
+            continue;
+        }
+        uint8_t packet = sender->pending_packet;
+        uint64_t waited_ns = monotonic_ns() - sender->pending_ns;
+        uint8_t seq = sender->next_seq++;
+        sender->has_pending = false;
+        pthread_mutex_unlock(&sender->lock);
+
+        uint64_t age = waited_ns / ULTRA2_AGE_UNIT_NS;
+        uint8_t frame[ULTRA2_FRAME_BYTES];
+        ultra2_frame_build(frame, sender->sender_id, seq, packet, age > ULTRA2_AGE_MAX ? ULTRA2_AGE_MAX : (uint8_t)age);
+        UltraSchedule_t schedule;
+        Ultra_encode_v2(frame, &schedule);
+
+        bool completed = transmit(sender, &schedule);
+
+        pthread_mutex_lock(&sender->lock);
+        sender->on_air = false;
+        if (completed) {
+            sender->stats.packets++;
+        } else {
+            sender->stats.aborted++;
+        }
+    }
+    pthread_mutex_unlock(&sender->lock);
+    return NULL;
+}
+
+bool UltraSender_start(UltraSender_t* sender, int fd, uint8_t sender_id, int rt_priority) {
+    memset(sender, 0, sizeof(*sender));
+    sender->fd = fd;
+    sender->sender_id = sender_id;
+    sender->rt_priority = rt_priority;
+
+    // The control thread takes this lock on submit; inherit its priority while the sender holds it
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&sender->lock, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sender->wake, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    if (pthread_create(&sender->thread, NULL, sender_main, sender) != 0) {
+        perror("Failed to start ultrasonic sender");
+        pthread_cond_destroy(&sender->wake);
+        pthread_mutex_destroy(&sender->lock);
+        return false;
+    }
+    sender->started = true;
+    return true;
+}
+
+bool UltraSender_submit(UltraSender_t* sender, uint8_t packet) {
+    if (!sender->started) {
+        return false;
+    }
+    uint64_t now = monotonic_ns();
+    pthread_mutex_lock(&sender->lock);
+    bool accepted = !sender->on_air && !sender->stop;
+    if (accepted) {
+        sender->pending_packet = packet;
+        sender->pending_ns = now;
+        sender->has_pending = true;
+        sender->on_air = true;
+        pthread_cond_signal(&sender->wake);
+    } else {
+        sender->stats.busy++;
+    }
+    pthread_mutex_unlock(&sender->lock);
+    return accepted;
+}
+
+void UltraSender_stats(UltraSender_t* sender, UltraSenderStats_t* stats) {
+    // Once stopped the thread is gone and the counters are final
+    if (!sender->started) {
+        *stats = sender->stats;
+        return;
+    }
+    pthread_mutex_lock(&sender->lock);
+    *stats = sender->stats;
+    pthread_mutex_unlock(&sender->lock);
+}
+
+void UltraSender_stop(UltraSender_t* sender) {
+    if (!sender->started) {
+        return;
+    }
+    pthread_mutex_lock(&sender->lock);
+    sender->stop = true;
+    pthread_cond_broadcast(&sender->wake);
+    pthread_mutex_unlock(&sender->lock);
+    pthread_join(sender->thread, NULL);
+    pthread_cond_destroy(&sender->wake);
+    pthread_mutex_destroy(&sender->lock);
+    sender->started = false;
+}
+
+void UltraRxFilter_init(UltraRxFilter_t* filter, uint8_t own_id) {
+    memset(filter, 0, sizeof(*filter));
+    filter->own_id = own_id;
+}
+
+bool UltraRxFilter_accept(UltraRxFilter_t* filter, const struct ultra_rx_packet* rx) {
+    if (rx->version != 2) {
+        return true;
+    }
+    if (rx->sender == filter->own_id) {
+        filter->own++;
+        return false;
+    }
+    if (filter->seen[rx->sender] && filter->last_seq[rx->sender] == rx->seq) {
+        filter->repeats++;
+        return false;
+    }
+    filter->seen[rx->sender] = true;
+    filter->last_seq[rx->sender] = rx->seq;
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef ULTRASONIC_H
+#define ULTRASONIC_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../common/ultrasonic/ultra_proto.h"
+
+// A v2 frame is the longest schedule; a v1 packet needs at most 2 * ULTRA_PACKET_BITS
+#define ULTRA_MAX_PULSES (1 + ULTRA2_FRAME_SYMBOLS)
+
+// Trigger held high for width_us, then low for gap_ns before the next pulse
+typedef struct {
+    uint32_t width_us;
+    uint32_t gap_ns;
+} UltraPulse_t;
+
+typedef struct {
+    UltraPulse_t pulses[ULTRA_MAX_PULSES];
+    size_t count;
+} UltraSchedule_t;
+
+// v1: a 0 bit is two short pulses, a 1 bit one long pulse
+void Ultra_encode_v1(uint8_t packet, UltraSchedule_t* schedule);
+
+// v2: a sync pulse, then one pulse per 2-bit symbol of the frame
+void Ultra_encode_v2(const uint8_t frame[ULTRA2_FRAME_BYTES], UltraSchedule_t* schedule);
+
+typedef struct {
+    uint64_t packets;          // packets sent completely
+    uint64_t busy;             // submissions refused while a packet was on air
+    uint64_t aborted;          // packets cut short by UltraSender_stop
+    uint64_t max_edge_late_ns; // worst delay of a trigger edge behind its schedule
+    uint64_t failed_edges;     // trigger writes the driver refused; the packet goes out garbled
+} UltraSenderStats_t;
+
+/*
+ * Vocalization transmitter. A submitted packet is handed to a sender
+ * thread, which wraps it in a v2 frame with our sender ID, the next
+ * sequence number and the time it waited, then toggles the SR04 trigger on
+ * absolute CLOCK_MONOTONIC deadlines, so sending never blocks the control
+ * tick. One packet is on air at a time.
+ */
+typedef struct {
+    int fd;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    uint8_t sender_id;
+    uint8_t next_seq;
+    uint8_t pending_packet;
+    uint64_t pending_ns; // when the packet was submitted, for its age byte
+    bool has_pending;
+    bool on_air;
+    bool stop;
+    bool started;
+    int rt_priority;
+    UltraSenderStats_t stats;
+} UltraSender_t;
+
+/*
+ * Starts the sender thread writing '1'/'0' trigger levels to fd and
+ * stamping frames with sender_id. With rt_priority > 0 the thread asks for
+ * SCHED_FIFO at that priority, which keeps the pulse widths tight; without
+ * CAP_SYS_NICE it stays on SCHED_OTHER with a warning.
+ */
+bool UltraSender_start(UltraSender_t* sender, int fd, uint8_t sender_id, int rt_priority);
+
+/*
+ * Queues a v1-layout packet (start, emotion, intensity, stop) without
+ * blocking. Returns false if the sender is not running or another packet
+ * is still on air.
+ */
+bool UltraSender_submit(UltraSender_t* sender, uint8_t packet);
+
+// Valid while running and after UltraSender_stop
+void UltraSender_stats(UltraSender_t* sender, UltraSenderStats_t* stats);
+
+/*
+ * Aborts the packet on air, leaves the trigger low and joins the thread.
+ */
+void UltraSender_stop(UltraSender_t* sender);
+
+/*
+ * Receive-side filter for v2 frames. It drops our own frames, heard back
+ * off a wall, and a frame whose sequence number repeats the last one its
+ * sender got through, so neither counts as new traffic. v1 packets carry
+ * no sender or sequence number and always pass.
+ */
+typedef struct {
+    uint8_t own_id;
+    bool seen[256];        // by sender ID: a frame got through before
+    uint8_t last_seq[256]; // by sender ID: sequence number of that frame
+    uint64_t own;          // our own frames dropped
+    uint64_t repeats;      // repeated frames dropped
+} UltraRxFilter_t;
+
+void UltraRxFilter_init(UltraRxFilter_t* filter, uint8_t own_id);
+
+// False if the packet is to be dropped
+bool UltraRxFilter_accept(UltraRxFilter_t* filter, const struct ultra_rx_packet* rx);
+
+#endif // ULTRASONIC_H
@@ -0,0 +1,68 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "vision.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+void VisionLink_init(VisionLink_t* link) {
+    memset(link, 0, sizeof(*link));
+}
+
+static void try_map(VisionLink_t* link) {
+    int fd = shm_open(VISION_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        return;
+    }
+    void* map = mmap(NULL, sizeof(VisionShm_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    const VisionShm_t* shm = (const VisionShm_t*)map;
+    if (__atomic_load_n(&shm->magic, __ATOMIC_RELAXED) != VISION_SHM_MAGIC) {
+        munmap(map, sizeof(VisionShm_t));
+        return;
+    }
+    link->shm = shm;
+}
+
+bool VisionLink_poll(VisionLink_t* link, uint64_t now_ns, VisionSample_t* sample) {
+    if (link->shm == NULL) {
+        if (now_ns < link->next_attempt_ns) {
+            return false;
+        }
+        link->next_attempt_ns = now_ns + VISION_RETRY_NS;
+        try_map(link);
+        if (link->shm == NULL) {
+            return false;
+        }
+    }
+    if (!vision_shm_read(link->shm, sample)) {
+        return false;
+    }
+    uint64_t age_ns = now_ns > sample->capture_ns ? now_ns - sample->capture_ns : 0;
+    if (age_ns > VISION_MAX_AGE_NS) {
+        link->stats.stale++;
+        return false;
+    }
+    link->stats.fresh++;
+    link->stats.age_sum_ns += age_ns;
+    if (age_ns > link->stats.max_age_ns) {
+        link->stats.max_age_ns = age_ns;
+    }
+    return true;
+}
+
+void VisionLink_stats(const VisionLink_t* link, VisionLinkStats_t* stats) {
+    *stats = link->stats;
+}
+
+void VisionLink_close(VisionLink_t* link) {
+    if (link->shm != NULL) {
+        munmap((void*)link->shm, sizeof(VisionShm_t));
+        link->shm = NULL;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef VISION_H
+#define VISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../common/vision/vision_shm.h"
+
+// A frame older than this at the tick says nothing about the scene any more
+#define VISION_MAX_AGE_NS 150000000ull
+// How often a missing shared memory block is looked for again
+#define VISION_RETRY_NS 1000000000ull
+
+typedef struct {
+    uint64_t fresh;           // ticks that got a sample within VISION_MAX_AGE_NS
+    uint64_t stale;           // ticks whose latest sample was too old
+    uint64_t age_sum_ns;      // frame-to-neuron latency of the fresh samples
+    uint64_t max_age_ns;
+} VisionLinkStats_t;
+
+/*
+ * Read side of the camera's salience block. The block is mapped lazily,
+ * so the worm can start before the camera process and keeps working
+ * without one.
+ */
+typedef struct {
+    const VisionShm_t* shm;
+    uint64_t next_attempt_ns;
+    VisionLinkStats_t stats;
+} VisionLink_t;
+
+void VisionLink_init(VisionLink_t* link);
+
+/*
+ * Fetches the latest sample if it was captured at most VISION_MAX_AGE_NS
+ * before now_ns (CLOCK_MONOTONIC). Never blocks.
+ */
+bool VisionLink_poll(VisionLink_t* link, uint64_t now_ns, VisionSample_t* sample);
+
+void VisionLink_stats(const VisionLink_t* link, VisionLinkStats_t* stats);
+void VisionLink_close(VisionLink_t* link);
+
+#endif // VISION_H
@@ -11,6 +11,13 @@
 #include <linux/i2c.h>
 #include <linux/uaccess.h>
 #include <linux/kernel.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/atomic.h>
+#include <linux/moduleparam.h>
+#include <linux/version.h>
 #include <asm/io.h>
 
 #include "../common/motor/ioctl_car_cmd.h"
@@ -25,6 +32,34 @@
 #define SLAVE_DEV_NAME     ("CARMOTOR"   )
 #define MOTOR_SLAVE_ADDR (  0x16   )
 
+#define WATCHDOG_MAX_MS    60000
+
+// Applies to every new open until the file sets its own timeout
+static unsigned int watchdog_ms = 0;
+module_param(watchdog_ms, uint, 0644);
+MODULE_PARM_DESC(watchdog_ms, "Default deadman timeout in ms for each open of /dev/motor, 0 = off");
+
+/*
+ * Per-open deadman state. Every motion command re-arms the hrtimer; if it
+ * expires, the timer hands the STOP frame to a work item, because the I2C
+ * write may sleep. The generation tells that work whether a command slipped
+ * in after the timer fired, in which case the car is not stopped.
+ */
+struct motor_session {
+    struct hrtimer watchdog;
+    struct work_struct stop_work;
+    ktime_t timeout;
+    unsigned long feed_gen;
+    unsigned long tripped_gen;
+    bool moving;
+    atomic_t trips;
+};
+
+// Serialises I2C frames and session feeds against the watchdog's stop
+static DEFINE_MUTEX(motor_lock);
+static atomic_t watchdog_trips = ATOMIC_INIT(0);
+// Updated by motor_write, under motor_lock
+static struct motor_frame last_frame;
 
 static struct i2c_adapter * motorI2CAdapter = NULL;
 static struct i2c_client * motorI2CClient = NULL;
@@ -62,6 +97,7 @@ static void Left   (void);
 static void Right  (void);
 
 static long chardevIoctl(struct file *, unsigned int, unsigned long);
+static void Stop(void);
 
 int motor_write(unsigned char * buf, unsigned int len);
 
@@ -75,14 +111,81 @@ static struct file_operations fOpStruct = {
     .unlocked_ioctl = chardevIoctl
 };
 
+static enum hrtimer_restart WatchdogExpired(struct hrtimer * timer)
+{
+    struct motor_session * session = container_of(timer, struct motor_session, watchdog);
+
+    session->tripped_gen = READ_ONCE(session->feed_gen);
+    schedule_work(&session->stop_work);
+    return HRTIMER_NORESTART;
+}
+
+static void WatchdogStop(struct work_struct * work)
+{
+    struct motor_session * session = container_of(work, struct motor_session, stop_work);
+
+    mutex_lock(&motor_lock);
+    if (session->moving && session->feed_gen == session->tripped_gen) {
+        Stop();
+        session->moving = false;
+        atomic_inc(&session->trips);
+        atomic_inc(&watchdog_trips);
+        printk(KERN_WARNING "motor: no command for %lld ms, watchdog stopped the car\n",
+               ktime_to_ms(session->timeout));
+    }
+    mutex_unlock(&motor_lock);
+}
+
+// Called with motor_lock held after every frame the session sends
+static void WatchdogFeed(struct motor_session * session, bool moving)
+{
+    session->feed_gen++;
+    session->moving = moving;
+    if (moving && session->timeout) {
+        hrtimer_start(&session->watchdog, session->timeout, HRTIMER_MODE_REL);
+    } else {
+        hrtimer_try_to_cancel(&session->watchdog);
+    }
+}
+
 static int DeviceOpen(struct inode * inode, struct file * file)
 {
+    struct motor_session * session = kzalloc(sizeof(*session), GFP_KERNEL);
+
+    if (session == NULL) {
+        return -ENOMEM;
+    }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+    hrtimer_setup(&session->watchdog, WatchdogExpired, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+    hrtimer_init(&session->watchdog, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    session->watchdog.function = WatchdogExpired;
+#endif
+    INIT_WORK(&session->stop_work, WatchdogStop);
+    session->timeout = ms_to_ktime(min_t(unsigned int, watchdog_ms, WATCHDOG_MAX_MS));
+    file->private_data = session;
     printk("Device File Opened \n ");
     return 0;
 }
 
+/*
+ * A file that left the car moving stops it when it goes away, so a crashed
+ * or killed controller cannot leave the motors running. Files that only
+ * watched (or already stopped) leave another controller's drive alone.
+ */
 static int DeviceRelease(struct inode * inode, struct file * file)
 {
+    struct motor_session * session = file->private_data;
+
+    hrtimer_cancel(&session->watchdog);
+    cancel_work_sync(&session->stop_work);
+    mutex_lock(&motor_lock);
+    if (session->moving) {
+        Stop();
+        printk(KERN_INFO "motor: released while moving, car stopped\n");
+    }
+    mutex_unlock(&motor_lock);
+    kfree(session);
     printk("Device File Closed \n") ;
     return 0;
 }
@@ -205,6 +308,7 @@ static void __exit DeviceExit()
 
     unregister_chrdev_region(dev, 1);
     printk(KERN_INFO "Devices are released");
+    printk(KERN_INFO "motor: watchdog stopped the car %d times\n", atomic_read(&watchdog_trips));
 
 
     printk    ("Device Driver Remove : Success");
@@ -244,8 +348,52 @@ static void Stop(void)
     motor_write(STOP, 5);
 }
 
+static long WatchdogIoctl(struct motor_session * session, unsigned int command, unsigned long arg)
+{
+    struct motor_watchdog config;
+
+    if (command == PI_CMD_WATCHDOG_SET) {
+        if (copy_from_user(&config, (struct motor_watchdog __user *)arg, sizeof(config))) {
+            return -EFAULT;
+        }
+        if (config.timeout_ms > WATCHDOG_MAX_MS) {
+            return -EINVAL;
+        }
+        mutex_lock(&motor_lock);
+        session->timeout = ms_to_ktime(config.timeout_ms);
+        // Re-arm with the new timeout, or disarm
+        WatchdogFeed(session, session->moving);
+        mutex_unlock(&motor_lock);
+        return 0;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.timeout_ms = (__u32)ktime_to_ms(session->timeout);
+    config.trips = atomic_read(&session->trips);
+    config.total_trips = atomic_read(&watchdog_trips);
+    if (copy_to_user((struct motor_watchdog __user *)arg, &config, sizeof(config))) {
+        return -EFAULT;
+    }
+    return 0;
+}
+
 static long chardevIoctl(struct file * file, unsigned int command, unsigned long arg)
 {
+    struct motor_session * session = file->private_data;
+
+    if (command == PI_CMD_WATCHDOG_SET || command == PI_CMD_WATCHDOG_GET) {
+        return WatchdogIoctl(session, command, arg);
+    }
+    if (command == PI_CMD_LAST_FRAME) {
+        struct motor_frame frame;
+
+        mutex_lock(&motor_lock);
+        frame = last_frame;
+        mutex_unlock(&motor_lock);
+        return copy_to_user((struct motor_frame __user *)arg, &frame, sizeof(frame)) ? -EFAULT : 0;
+    }
+
+    mutex_lock(&motor_lock);
     switch(command) {
     case PI_CMD_LEFT    :
         Left();
@@ -271,23 +419,35 @@ static long chardevIoctl(struct file * file, unsigned int command, unsigned long
         Stop();
         printk(KERN_INFO "COMMAND: stop");
         break;
-    case PI_CMD_IO :
+    case PI_CMD_IO : {
         struct ioctl_info info;
         int ret = copy_from_user(&info, (struct ioctl_info *)arg, sizeof(info));
         printk(KERN_INFO "COMMAND: io");
-        if (ret < 0) {
+        if (ret) {
             Stop();
+            command = PI_CMD_STOP;
         } else {
             motor_write(info.buf, 5);
         }
         break;
     }
+    default:
+        mutex_unlock(&motor_lock);
+        return -ENOTTY;
+    }
+    WatchdogFeed(session, command != PI_CMD_STOP);
+    mutex_unlock(&motor_lock);
     return command;
 }
 
+// Callers hold motor_lock
 int motor_write(unsigned char * buf, unsigned int len)
 {
     int ret = i2c_master_send(motorI2CClient, buf, 5);
+    if (ret >= 0) {
+        memcpy(last_frame.buf, buf, sizeof(last_frame.buf));
+        last_frame.timestamp_ns = ktime_get_ns();
+    }
     return ret;
 }
 
@@ -0,0 +1,120 @@
+#include "capture.hpp"
+
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+Capture::Capture(std::unique_ptr<FrameSource> source) : source_(std::move(source)) {}
+
+Capture::~Capture() {
+    stop();
+}
+
+bool Capture::start() {
+    if (running_ || !source_->start()) {
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread(&Capture::run, this);
+    return true;
+}
+
+void Capture::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    running_ = false;
+    published_.notify_all();
+    thread_.join();
+
+    FramePtr last;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        last.swap(latest_);
+    }
+    last.reset();
+    std::unique_lock<std::mutex> guard(outstandingLock_);
+    returned_.wait(guard, [this] { return outstanding_ == 0; });
+    guard.unlock();
+    source_->stop();
+}
+
+// The deleter runs on whichever thread drops the last reference
+FramePtr Capture::share(const Frame& frame) {
+    {
+        std::lock_guard<std::mutex> guard(outstandingLock_);
+        ++outstanding_;
+    }
+    return FramePtr(new Frame(frame), [this](const Frame* shared) {
+        source_->release(*shared);
+        delete shared;
+        std::lock_guard<std::mutex> guard(outstandingLock_);
+        if (--outstanding_ == 0) {
+            returned_.notify_all();
+        }
+    });
+}
+
+void Capture::run() {
+    while (running_) {
+        Frame frame;
+        FrameSource::Status status = source_->acquire(frame, std::chrono::milliseconds(100));
+        if (status == FrameSource::Status::Timeout) {
+            continue;
+        }
+        if (status == FrameSource::Status::Error) {
+            std::cerr << source_->name() << ": capture stopped" << std::endl;
+            break;
+        }
+
+        FramePtr shared = share(frame);
+        uint64_t now = monotonicNs();
+        // The previous frame may hold the last reference; drop it outside the lock
+        FramePtr previous;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (haveSequence_ && frame.sequence > lastSequence_ + 1) {
+                stats_.dropped += frame.sequence - lastSequence_ - 1;
+            }
+            haveSequence_ = true;
+            lastSequence_ = frame.sequence;
+            stats_.frames++;
+            if (now > frame.timestampNs && now - frame.timestampNs > stats_.maxLatencyNs) {
+                stats_.maxLatencyNs = now - frame.timestampNs;
+            }
+            previous.swap(latest_);
+            latest_ = std::move(shared);
+        }
+        published_.notify_all();
+    }
+    running_ = false;
+    published_.notify_all();
+}
+
+FramePtr Capture::latest() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return latest_;
+}
+
+FramePtr Capture::waitNext(const FramePtr& seen, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> guard(lock_);
+    published_.wait_for(guard, timeout, [&] { return !running_ || (latest_ && latest_ != seen); });
+    if (!latest_ || latest_ == seen) {
+        return nullptr;
+    }
+    return latest_;
+}
+
+CaptureStats Capture::stats() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return stats_;
+}
@@ -0,0 +1,69 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "frame_source.hpp"
+
+// A frame shared with consumers; the buffer goes back to the source when the last reference drops
+using FramePtr = std::shared_ptr<const Frame>;
+
+struct CaptureStats {
+    uint64_t frames = 0;       // frames handed out
+    uint64_t dropped = 0;      // gaps in the source's sequence numbers
+    uint64_t maxLatencyNs = 0; // capture timestamp to publication, worst case
+};
+
+/*
+ * Runs a FrameSource on its own thread and publishes each frame as the
+ * latest one. Consumers take references with latest() or waitNext() and
+ * read the pixels in place; a consumer that falls behind simply sees the
+ * newest frame next time, and the capture thread never waits for it.
+ * Hold references briefly: while every buffer of the ring is held the
+ * source has nowhere to write and drops frames.
+ */
+class Capture {
+public:
+    explicit Capture(std::unique_ptr<FrameSource> source);
+    ~Capture();
+
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+
+    bool start();
+    // Joins the capture thread, then waits for consumers to drop their frames before stopping the source.
+    // Never call it while holding a frame.
+    void stop();
+
+    FramePtr latest() const;
+    // A frame other than seen (any frame if seen is null), or null on timeout or stop
+    FramePtr waitNext(const FramePtr& seen, std::chrono::milliseconds timeout) const;
+
+    CaptureStats stats() const;
+    const char* sourceName() const { return source_->name(); }
+
+private:
+    void run();
+    FramePtr share(const Frame& frame);
+
+    std::unique_ptr<FrameSource> source_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex lock_;
+    mutable std::condition_variable published_;
+    FramePtr latest_;
+    CaptureStats stats_;
+    bool haveSequence_ = false;
+    uint64_t lastSequence_ = 0;
+
+    std::mutex outstandingLock_;
+    std::condition_variable returned_;
+    unsigned outstanding_ = 0;
+};
+
+#endif // CAPTURE_HPP
@@ -0,0 +1,49 @@
+#ifndef FRAME_SOURCE_HPP
+#define FRAME_SOURCE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/videodev2.h>
+
+/*
+ * One captured frame. The pixels stay in the source's buffer (a V4L2 mmap
+ * buffer for the camera) until the frame is released, so nothing is
+ * copied between the driver and the consumers.
+ *
+ * fourcc is a V4L2 pixel format. For V4L2_PIX_FMT_GREY and
+ * V4L2_PIX_FMT_YUV420 the luma plane starts at data with the given stride;
+ * for V4L2_PIX_FMT_YUYV luma is every other byte of each row.
+ */
+struct Frame {
+    const uint8_t* data = nullptr;
+    size_t bytes = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    uint32_t fourcc = 0;
+    uint32_t index = 0;        // buffer slot, for release()
+    uint64_t sequence = 0;     // counted by the source; gaps are dropped frames
+    uint64_t timestampNs = 0;  // CLOCK_MONOTONIC at capture
+};
+
+/*
+ * A ring of frame buffers filled by hardware or by a generator. acquire()
+ * blocks until a frame is ready or the timeout passes; every acquired
+ * frame must be handed back with release(), which may be called from any
+ * thread.
+ */
+class FrameSource {
+public:
+    enum class Status { Ok, Timeout, Error };
+
+    virtual ~FrameSource() = default;
+    virtual bool start() = 0;
+    virtual Status acquire(Frame& frame, std::chrono::milliseconds timeout) = 0;
+    virtual void release(const Frame& frame) = 0;
+    virtual void stop() = 0;
+    virtual const char* name() const = 0;
+};
+
+#endif // FRAME_SOURCE_HPP
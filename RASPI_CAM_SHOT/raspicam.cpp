@@ -1,137 +1,215 @@
 #include<iostream>
 #include<sys/types.h>
-#include<cnetdb>
-#include<cunistd>
-#include<raspicam/raspicam.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<cerrno>
+#include<cstdio>
 #include<cstring>
 #include<sys/ioctl.h>
+#include<csignal>
+#include<ctime>
 #include<fstream>
+#include<memory>
+#include<string>
 #include<vector>
+#include<algorithm>
+
+#include "capture.hpp"
+#include "salience.hpp"
+#include "synthetic_source.hpp"
+#include "v4l2_source.hpp"
+#include "vision_publisher.hpp"
+#include "../common/motor/ioctl_car_cmd.h"
+
+#define DEVNAME "/dev/motor"
+#define CAMERA "/dev/video0"
+#define SHOT_FILE "shot.pgm"
+#define SHOT_WIDTH 320
+#define SHOT_HEIGHT 240
+
 typedef unsigned char uchar;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Luma only: PGM needs no encoder, and it is what the vision code looks at
+static bool writePgm(const char* path, const Frame& frame) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "P5\n" << frame.width << " " << frame.height << "\n255\n";
+    std::vector<uchar> row(frame.width);
+    for (uint32_t y = 0; y < frame.height; ++y) {
+        const uint8_t* line = frame.data + static_cast<size_t>(y) * frame.stride;
+        if (frame.fourcc == V4L2_PIX_FMT_YUYV) {
+            for (uint32_t x = 0; x < frame.width; ++x) {
+                row[x] = line[2 * x];
+            }
+            out.write(reinterpret_cast<const char*>(row.data()), row.size());
+        } else {
+            out.write(reinterpret_cast<const char*>(line), frame.width);
+        }
+    }
+    return static_cast<bool>(out);
+}
+
 class RaspiCarRunner {
-    int motor;
-    int sr04;
-    int ir;
-    raspicam::RaspiCam camera;
-    void signalHandler(int dummy) {
+    int motor = -1;
+    Capture camera;
+public:
+    explicit RaspiCarRunner(std::unique_ptr<FrameSource> source) : camera(std::move(source)) {}
+    ~RaspiCarRunner() {
         closeDevice();
-        exit(0);
     }
     int openDevice() {
-        camera.setWidth(480);
-        camera.setWidth(320);
-        camera.setFormat(raspicam::RASPICAM_FORMAT_RGB);
-        camera.open();
-        if (!camera.isOpened()) {
-            std::cerr << "Error: cannot open camera." << std::endl;
-            return EPERM;
+        if (!camera.start()) {
+            std::cerr << "Error: cannot open camera " << camera.sourceName() << "." << std::endl;
+            return -EPERM;
         }
-        std::vector<uchar> imageData;
-        std::cout << "Waiting for camera for a second..." << std::endl;
-        sleep(1);
-        camera.grab();
+        // The camera works without the car, so a missing driver is not fatal.
+        // Distance and IR are sensor_hub's; opening them here would only race its ranging.
         motor = open(DEVNAME, O_RDWR);
-        ir = open(IR, O_RDWR);
-        sr04 = open(SR04, O_RDWR);
+        return 0;
     }
     void closeDevice() {
-        ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
-        close(motor);
-        close(sr04);
-        close(ir);
-        camera.release();
+        camera.stop();
+        if (motor >= 0) {
+            ioctl(motor, PI_CMD_STOP, sizeof(struct ioctl_info));
+            close(motor);
+            motor = -1;
+        }
     }
-    int handleCamera() {
-        camera.retrieve(imageData);
-        if(imageData.empty()) {
-            std::cerr << "Error: failed to capture image." << std::endl;
-            camera.release();
-            return -ENODATA;
+    // Waits for a fresh frame and saves it; the pixels are read straight from the capture buffer
+    int handleCamera(int frames) {
+        FramePtr frame;
+        for (int i = 0; i < frames; ++i) {
+            FramePtr next = camera.waitNext(frame, std::chrono::seconds(2));
+            if (!next) {
+                std::cerr << "Error: failed to capture image." << std::endl;
+                return -ENODATA;
+            }
+            frame = std::move(next);
         }
-    
-        std::ofstream capturedImage("shot.jpg". std::ios::binary);
-        if(capturedImage.is_open()) {
-            capturedImage.write(reinterpret_cast<const char*>(imageData.data(), imageData.size());
-            outputFile.close();
-            std::cout << "saved image file to jpg." << std::endl;
-        } else {
+        if (!writePgm(SHOT_FILE, *frame)) {
             std::cout << "cannot open file for writing" << std::endl;
             return -EPERM;
         }
+        std::cout << "saved frame " << frame->sequence << " to " << SHOT_FILE << "." << std::endl;
         return 0;
     }
-    void doIoctl(const char *cmd) {
-        struct ioctl_info data;
-        data.size = 5;
-        memcpy(data, cmd, sizeof(char)*data_size);
-        ioctl(motor, PI_CMD_IO, data);
-    }
-}
-
-class DataRetriever {
-    RaspiCarRunner runner;
-    struct addrinfo hints;
-    struct addrinfo *result, *rp;
-    int sfd, s, j;
-    size_t len;
-    ssize_t nread;
-    bool    ir_requested;
-    char buf[5];
-    int setupUDPSock() {
-        memset(&hints, 0, sizeof(struct addrinfo));
-        hints.ai_family = AF_UNSPEC;
-        hints.ai_socktype = SOCK_DGRAM;
-        hints.ai_flags = 0;
-        hints.ai_protocol = 0;
-        s = getaddrinfo("hobbies.yoonjin2.kr", "63000", &hints, &servinfo);
-        if(s) {
-            std::cerr << "getaddrinfo: " << gai_strerror(s) << std::endl;
-            return -EAGAIN;
+    // Feeds every frame through the salience stage and publishes it for the worm; frames == 0 runs until a signal
+    int runVision(int frames, SalienceKernel kernel) {
+        VisionPublisher publisher;
+        if (!publisher.open()) {
+            return -EPERM;
         }
-        for(rp = result; rp != NULL; rp = rp->ai_next) {
-            sfd = socket(rp->ai_faimly, rp->ai_socktype, rp->ai_protocol);
-            if(sfd == -1) {
+        SalienceExtractor extractor(kernel);
+        FramePtr frame;
+        uint64_t published = 0, latencySumNs = 0, latencyMaxNs = 0, workSumNs = 0;
+        while (!stopRequested && (frames == 0 || published < static_cast<uint64_t>(frames))) {
+            FramePtr next = camera.waitNext(frame, std::chrono::milliseconds(200));
+            if (!next) {
                 continue;
             }
-            if(connect(sfd, rp->ai_addr, rp->ai_addrlen) != -1) {
-                break;
+            frame = std::move(next);
+            uint64_t begin = monotonicNs();
+            Salience salience;
+            bool ready = extractor.process(*frame, salience);
+            uint64_t end = monotonicNs();
+            if (!ready) {
+                continue;
             }
-            close(sfd);
-        } 
-        if(rp == NULL) {
-            std::cerr << "Could not connect to destination\n" << std::endl;
-            return -ECONNREFUSED;
+            publisher.publish(salience, end);
+            uint64_t latency = end > frame->timestampNs ? end - frame->timestampNs : 0;
+            published++;
+            latencySumNs += latency;
+            latencyMaxNs = std::max(latencyMaxNs, latency);
+            workSumNs += end - begin;
+        }
+        frame.reset();
+        if (published > 0) {
+            std::cout << "Vision (" << salienceKernelName(kernel) << "): " << published << " frames, "
+                      << workSumNs / published / 1000 << " us/frame, frame-to-publish latency mean "
+                      << latencySumNs / published / 1000 << " us, max " << latencyMaxNs / 1000 << " us" << std::endl;
         }
-        freeaddrinfo(result);
         return 0;
     }
-    int setupSender() {
-        int udpSetupError = setupUDPSock();
-        if(udpSetupError) {
-            exit(udpSetupError);
-            runner.openDevice(); //PLEASE DEVELOP FROM HERE
-        }
+    void reportCamera() const {
+        CaptureStats stats = camera.stats();
+        std::cout << "Camera: " << stats.frames << " frames, " << stats.dropped << " dropped, worst latency "
+                  << stats.maxLatencyNs / 1000 << " us" << std::endl;
     }
-    int sendData() {
-        char distance[16];
+    void doIoctl(const char *cmd) {
+        struct ioctl_info data;
+        data.size = 5;
+        memcpy(data.buf, cmd, sizeof(char) * data.size);
+        ioctl(motor, PI_CMD_IO, &data);
+    }
+};
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--device /dev/videoN | --synthetic] [--frames N] [--vision [--scalar]]" << std::endl;
+}
 
-        char msg[32];
-        read(sr04, &distance, sizeof(distance));
-        if(ir_requested) {
-            write(ir, "ON", sizeof(char) * 2);
+int main(int argc, char** argv) {
+    std::string device = CAMERA;
+    bool synthetic = false;
+    int frames = 30; // let exposure settle before the shot
+    bool vision = false;
+    SalienceKernel kernel = SalienceKernel::Simd;
+    bool framesGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            device = argv[++i];
+        } else if (strcmp(argv[i], "--synthetic") == 0) {
+            synthetic = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+            framesGiven = true;
+            if (frames < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--vision") == 0) {
+            vision = true;
+        } else if (strcmp(argv[i], "--scalar") == 0) {
+            kernel = SalienceKernel::Scalar;
         } else {
-            write(ir, "OFF", sizeof(char) * 3);
-            //if ir turned off, always NONE
+            usage(argv[0]);
+            return 2;
         }
-        char ir_value[5];
-        read(ir, &ir_value, sizeof(ir_value));
-        strcat(msg, distance);
-        strcat(msg, ";");
-        strcat(msg, ir_value);
-        write(sfd, msg, sizeof(msg));
     }
-    int get_data() {
-        char cmd[5];
-        read(sfd, cmd, sizeof(cmd));
+
+    std::unique_ptr<FrameSource> source;
+    if (synthetic) {
+        source = std::make_unique<SyntheticSource>(SHOT_WIDTH, SHOT_HEIGHT);
+    } else {
+        source = std::make_unique<V4l2Source>(device, SHOT_WIDTH, SHOT_HEIGHT);
+    }
+    RaspiCarRunner runner(std::move(source));
+    if (runner.openDevice() != 0) {
+        return 1;
+    }
+    int rc;
+    if (vision) {
+        struct sigaction action = {};
+        action.sa_handler = onSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        rc = runner.runVision(framesGiven ? frames : 0, kernel);
+    } else {
+        rc = runner.handleCamera(frames);
     }
+    runner.reportCamera();
+    return rc == 0 ? 0 : 1;
 }
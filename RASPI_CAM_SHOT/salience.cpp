@@ -0,0 +1,212 @@
+#include "salience.hpp"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SALIENCE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SALIENCE_SSE2 1
+#endif
+
+#include "../common/vision/vision_shm.h"
+
+// Luma must move by more than this to count as motion, which keeps sensor noise out
+#define SALIENCE_NOISE_THRESHOLD 8
+// Mean thresholded change per pixel that saturates a half's salience
+#define SALIENCE_FULL_SCALE 12
+
+namespace {
+
+inline uint8_t average(uint8_t a, uint8_t b) {
+    return static_cast<uint8_t>((a + b + 1) >> 1);
+}
+
+void downsampleRowScalar(const uint8_t* row0, const uint8_t* row1, uint32_t from, uint32_t outWidth, uint8_t* dst) {
+    for (uint32_t x = from; x < outWidth; ++x) {
+        uint8_t even = average(row0[2 * x], row1[2 * x]);
+        uint8_t odd = average(row0[2 * x + 1], row1[2 * x + 1]);
+        dst[x] = average(even, odd);
+    }
+}
+
+uint32_t motionEnergyScalar(const uint8_t* a, const uint8_t* b, size_t from, size_t n, uint8_t threshold) {
+    uint32_t sum = 0;
+    for (size_t i = from; i < n; ++i) {
+        int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (diff > threshold) {
+            sum += static_cast<uint32_t>(diff - threshold);
+        }
+    }
+    return sum;
+}
+
+#if SALIENCE_NEON
+
+// Returns the number of output pixels done; the caller finishes the row
+uint32_t downsampleRowSimd(const uint8_t* row0, const uint8_t* row1, uint32_t outWidth, uint8_t* dst) {
+    uint32_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        uint8x16x2_t top = vld2q_u8(row0 + 2 * x);
+        uint8x16x2_t bottom = vld2q_u8(row1 + 2 * x);
+        uint8x16_t even = vrhaddq_u8(top.val[0], bottom.val[0]);
+        uint8x16_t odd = vrhaddq_u8(top.val[1], bottom.val[1]);
+        vst1q_u8(dst + x, vrhaddq_u8(even, odd));
+    }
+    return x;
+}
+
+uint32_t motionEnergySimd(const uint8_t* a, const uint8_t* b, size_t n, uint8_t threshold, size_t* done) {
+    uint8x16_t floor = vdupq_n_u8(threshold);
+    uint32x4_t acc = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t diff = vqsubq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)), floor);
+        acc = vpadalq_u16(acc, vpaddlq_u8(diff));
+    }
+    *done = i;
+    return vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+}
+
+#elif SALIENCE_SSE2
+
+uint32_t downsampleRowSimd(const uint8_t* row0, const uint8_t* row1, uint32_t outWidth, uint8_t* dst) {
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    uint32_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        const uint8_t* p0 = row0 + 2 * x;
+        const uint8_t* p1 = row1 + 2 * x;
+        __m128i lo = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)));
+        __m128i hi = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + 16)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + 16)));
+        __m128i even = _mm_packus_epi16(_mm_and_si128(lo, lowBytes), _mm_and_si128(hi, lowBytes));
+        __m128i odd = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_avg_epu8(even, odd));
+    }
+    return x;
+}
+
+uint32_t motionEnergySimd(const uint8_t* a, const uint8_t* b, size_t n, uint8_t threshold, size_t* done) {
+    const __m128i floor = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_subs_epu8(diff, floor), zero));
+    }
+    *done = i;
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(acc)) +
+           static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+}
+
+#else
+
+uint32_t downsampleRowSimd(const uint8_t*, const uint8_t*, uint32_t, uint8_t*) {
+    return 0;
+}
+
+uint32_t motionEnergySimd(const uint8_t*, const uint8_t*, size_t, uint8_t, size_t* done) {
+    *done = 0;
+    return 0;
+}
+
+#endif
+
+uint16_t toSalience(uint32_t energy, size_t pixels) {
+    uint64_t full = static_cast<uint64_t>(pixels) * SALIENCE_FULL_SCALE;
+    if (full == 0) {
+        return 0;
+    }
+    uint64_t scaled = static_cast<uint64_t>(energy) * VISION_SALIENCE_ONE / full;
+    return static_cast<uint16_t>(std::min<uint64_t>(scaled, VISION_SALIENCE_ONE));
+}
+
+} // namespace
+
+const char* salienceKernelName(SalienceKernel kernel) {
+    if (kernel == SalienceKernel::Scalar) {
+        return "scalar";
+    }
+#if SALIENCE_NEON
+    return "neon";
+#elif SALIENCE_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void downsampleLuma(SalienceKernel kernel, const uint8_t* src, size_t stride,
+                    uint32_t width, uint32_t height, uint8_t* dst) {
+    uint32_t outWidth = width / 2;
+    for (uint32_t y = 0; y + 1 < height; y += 2) {
+        const uint8_t* row0 = src + static_cast<size_t>(y) * stride;
+        const uint8_t* row1 = row0 + stride;
+        uint8_t* out = dst + static_cast<size_t>(y / 2) * outWidth;
+        uint32_t done = kernel == SalienceKernel::Simd ? downsampleRowSimd(row0, row1, outWidth, out) : 0;
+        downsampleRowScalar(row0, row1, done, outWidth, out);
+    }
+}
+
+uint32_t motionEnergy(SalienceKernel kernel, const uint8_t* a, const uint8_t* b, size_t n, uint8_t threshold) {
+    size_t done = 0;
+    uint32_t sum = kernel == SalienceKernel::Simd ? motionEnergySimd(a, b, n, threshold, &done) : 0;
+    return sum + motionEnergyScalar(a, b, done, n, threshold);
+}
+
+SalienceExtractor::SalienceExtractor(SalienceKernel kernel) : kernel_(kernel) {}
+
+// YUYV is rare on the Pi cameras, so its interleaved luma only gets the scalar path
+void SalienceExtractor::reduce(const Frame& frame, uint8_t* dst) const {
+    if (frame.fourcc != V4L2_PIX_FMT_YUYV) {
+        downsampleLuma(kernel_, frame.data, frame.stride, frame.width, frame.height, dst);
+        return;
+    }
+    for (uint32_t y = 0; y < height_; ++y) {
+        const uint8_t* row0 = frame.data + static_cast<size_t>(2 * y) * frame.stride;
+        const uint8_t* row1 = row0 + frame.stride;
+        for (uint32_t x = 0; x < width_; ++x) {
+            dst[static_cast<size_t>(y) * width_ + x] =
+                average(average(row0[4 * x], row1[4 * x]), average(row0[4 * x + 2], row1[4 * x + 2]));
+        }
+    }
+}
+
+bool SalienceExtractor::process(const Frame& frame, Salience& out) {
+    uint32_t width = frame.width / 2;
+    uint32_t height = frame.height / 2;
+    if (width != width_ || height != height_) {
+        width_ = width;
+        height_ = height;
+        current_.assign(static_cast<size_t>(width) * height, 0);
+        previous_.assign(current_.size(), 0);
+        primed_ = false;
+    }
+    reduce(frame, current_.data());
+    current_.swap(previous_);
+    if (!primed_) {
+        primed_ = true;
+        return false;
+    }
+
+    // previous_ now holds this frame and current_ the one before it
+    uint32_t split = width_ / 2;
+    uint32_t left = 0;
+    uint32_t right = 0;
+    for (uint32_t y = 0; y < height_; ++y) {
+        const uint8_t* now = previous_.data() + static_cast<size_t>(y) * width_;
+        const uint8_t* before = current_.data() + static_cast<size_t>(y) * width_;
+        left += motionEnergy(kernel_, now, before, split, SALIENCE_NOISE_THRESHOLD);
+        right += motionEnergy(kernel_, now + split, before + split, width_ - split, SALIENCE_NOISE_THRESHOLD);
+    }
+    out.left = toSalience(left, static_cast<size_t>(split) * height_);
+    out.right = toSalience(right, static_cast<size_t>(width_ - split) * height_);
+    out.frameSequence = frame.sequence;
+    out.captureNs = frame.timestampNs;
+    return true;
+}
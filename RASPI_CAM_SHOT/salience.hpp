@@ -0,0 +1,57 @@
+#ifndef SALIENCE_HPP
+#define SALIENCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_source.hpp"
+
+/*
+ * Integer kernels behind the salience stage. The Simd variants use NEON on
+ * ARM and SSE2 on x86 and fall back to the scalar code elsewhere; both
+ * variants produce bit-identical results.
+ */
+enum class SalienceKernel { Scalar, Simd };
+
+const char* salienceKernelName(SalienceKernel kernel);
+
+// Halves a luma plane in both directions with a rounded 2x2 box filter. width must be even.
+void downsampleLuma(SalienceKernel kernel, const uint8_t* src, size_t stride,
+                    uint32_t width, uint32_t height, uint8_t* dst);
+
+// Sum over n pixels of max(|a - b| - threshold, 0)
+uint32_t motionEnergy(SalienceKernel kernel, const uint8_t* a, const uint8_t* b, size_t n, uint8_t threshold);
+
+struct Salience {
+    uint16_t left = 0;   // Q0.16, see VISION_SALIENCE_ONE
+    uint16_t right = 0;
+    uint64_t frameSequence = 0;
+    uint64_t captureNs = 0;
+};
+
+/*
+ * Motion energy of the left and right image halves. Each frame's luma is
+ * reduced to half resolution and compared with the previous one; pixels
+ * that changed by less than the noise threshold do not count. The frame
+ * is read in place and is not needed after process() returns.
+ */
+class SalienceExtractor {
+public:
+    explicit SalienceExtractor(SalienceKernel kernel = SalienceKernel::Simd);
+
+    // Returns false for the first frame of a given size, which only primes the reference
+    bool process(const Frame& frame, Salience& out);
+
+private:
+    void reduce(const Frame& frame, uint8_t* dst) const;
+
+    SalienceKernel kernel_;
+    uint32_t width_ = 0;   // reduced size
+    uint32_t height_ = 0;
+    std::vector<uint8_t> current_;
+    std::vector<uint8_t> previous_;
+    bool primed_ = false;
+};
+
+#endif // SALIENCE_HPP
@@ -0,0 +1,86 @@
+#include "synthetic_source.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+SyntheticSource::SyntheticSource(uint32_t width, uint32_t height, unsigned fps, unsigned bufferCount)
+    : width_(width),
+      height_(height),
+      period_(std::chrono::nanoseconds(1000000000LL / std::max(fps, 1u))),
+      buffers_(std::max(bufferCount, 2u), std::vector<uint8_t>(static_cast<size_t>(width) * height)),
+      queued_(buffers_.size(), true) {}
+
+bool SyntheticSource::start() {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::fill(queued_.begin(), queued_.end(), true);
+    next_ = std::chrono::steady_clock::now();
+    sequence_ = 0;
+    return true;
+}
+
+void SyntheticSource::render(uint8_t* pixels, uint64_t sequence) const {
+    // One turn every four seconds at 30 fps
+    double angle = static_cast<double>(sequence) * (2.0 * M_PI / 120.0);
+    double cx = width_ * (0.5 + 0.3 * std::cos(angle));
+    double cy = height_ * (0.5 + 0.3 * std::sin(angle));
+    double radius = std::max(4.0, height_ / 12.0);
+    for (uint32_t y = 0; y < height_; ++y) {
+        uint8_t* row = pixels + static_cast<size_t>(y) * width_;
+        double dy = y - cy;
+        for (uint32_t x = 0; x < width_; ++x) {
+            double dx = x - cx;
+            bool inDisc = dx * dx + dy * dy <= radius * radius;
+            row[x] = inDisc ? 240 : static_cast<uint8_t>(32 + (x * 64) / std::max(width_, 1u));
+        }
+    }
+}
+
+FrameSource::Status SyntheticSource::acquire(Frame& frame, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> guard(lock_);
+    for (;;) {
+        if (next_ > deadline) {
+            guard.unlock();
+            std::this_thread::sleep_until(deadline);
+            return Status::Timeout;
+        }
+        auto due = next_;
+        guard.unlock();
+        std::this_thread::sleep_until(due);
+        guard.lock();
+
+        uint64_t sequence = sequence_++;
+        next_ += period_;
+        auto free = std::find(queued_.begin(), queued_.end(), true);
+        if (free == queued_.end()) {
+            continue; // every buffer is held, this frame is lost
+        }
+        uint32_t index = static_cast<uint32_t>(free - queued_.begin());
+        queued_[index] = false;
+        guard.unlock();
+
+        uint8_t* pixels = buffers_[index].data();
+        render(pixels, sequence);
+        frame.data = pixels;
+        frame.bytes = buffers_[index].size();
+        frame.width = width_;
+        frame.height = height_;
+        frame.stride = width_;
+        frame.fourcc = V4L2_PIX_FMT_GREY;
+        frame.index = index;
+        frame.sequence = sequence;
+        frame.timestampNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(due.time_since_epoch()).count());
+        return Status::Ok;
+    }
+}
+
+void SyntheticSource::release(const Frame& frame) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (frame.index < queued_.size()) {
+        queued_[frame.index] = true;
+    }
+}
+
+void SyntheticSource::stop() {}
@@ -0,0 +1,39 @@
+#ifndef SYNTHETIC_SOURCE_HPP
+#define SYNTHETIC_SOURCE_HPP
+
+#include <mutex>
+#include <vector>
+
+#include "frame_source.hpp"
+
+/*
+ * Camera stand-in for machines without one. Renders GREY frames at a
+ * fixed rate into its own buffer ring: a dim gradient with a bright disc
+ * circling the centre, so anything looking for salient spots has
+ * something to find. Like a real driver it skips frames (and counts the
+ * gap in the sequence) while every buffer is held by consumers.
+ */
+class SyntheticSource : public FrameSource {
+public:
+    SyntheticSource(uint32_t width, uint32_t height, unsigned fps = 30, unsigned bufferCount = 4);
+
+    bool start() override;
+    Status acquire(Frame& frame, std::chrono::milliseconds timeout) override;
+    void release(const Frame& frame) override;
+    void stop() override;
+    const char* name() const override { return "synthetic"; }
+
+private:
+    void render(uint8_t* pixels, uint64_t sequence) const;
+
+    uint32_t width_;
+    uint32_t height_;
+    std::chrono::nanoseconds period_;
+    std::vector<std::vector<uint8_t>> buffers_;
+    std::vector<bool> queued_; // free for the generator, like a QBUF'd buffer
+    std::mutex lock_;
+    std::chrono::steady_clock::time_point next_;
+    uint64_t sequence_ = 0;
+};
+
+#endif // SYNTHETIC_SOURCE_HPP
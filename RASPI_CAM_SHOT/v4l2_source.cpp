@@ -0,0 +1,202 @@
+#include "v4l2_source.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// Retries ioctls interrupted by a signal
+int xioctl(int fd, unsigned long request, void* arg) {
+    int rc;
+    do {
+        rc = ioctl(fd, request, arg);
+    } while (rc == -1 && errno == EINTR);
+    return rc;
+}
+
+void reportErrno(const std::string& what) {
+    std::cerr << what << ": " << std::strerror(errno) << std::endl;
+}
+
+} // namespace
+
+V4l2Source::V4l2Source(std::string device, uint32_t width, uint32_t height, unsigned bufferCount)
+    : device_(std::move(device)), width_(width), height_(height), bufferCount_(bufferCount) {}
+
+V4l2Source::~V4l2Source() {
+    stop();
+}
+
+bool V4l2Source::negotiateFormat() {
+    static const uint32_t preferred[] = {V4L2_PIX_FMT_YUV420, V4L2_PIX_FMT_GREY, V4L2_PIX_FMT_YUYV};
+    for (uint32_t fourcc : preferred) {
+        v4l2_format format{};
+        format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        format.fmt.pix.width = width_;
+        format.fmt.pix.height = height_;
+        format.fmt.pix.pixelformat = fourcc;
+        format.fmt.pix.field = V4L2_FIELD_NONE;
+        // The driver may adjust the size, and substitutes a format it prefers
+        if (xioctl(fd_, VIDIOC_S_FMT, &format) == 0 && format.fmt.pix.pixelformat == fourcc) {
+            width_ = format.fmt.pix.width;
+            height_ = format.fmt.pix.height;
+            fourcc_ = fourcc;
+            stride_ = format.fmt.pix.bytesperline ? format.fmt.pix.bytesperline
+                                                  : width_ * (fourcc == V4L2_PIX_FMT_YUYV ? 2 : 1);
+            return true;
+        }
+    }
+    std::cerr << device_ << ": none of YUV420, GREY or YUYV is supported" << std::endl;
+    return false;
+}
+
+bool V4l2Source::mapBuffers() {
+    v4l2_requestbuffers request{};
+    request.count = bufferCount_;
+    request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd_, VIDIOC_REQBUFS, &request) == -1) {
+        reportErrno(device_ + ": VIDIOC_REQBUFS");
+        return false;
+    }
+    if (request.count < 2) {
+        std::cerr << device_ << ": driver granted only " << request.count << " buffer(s)" << std::endl;
+        return false;
+    }
+
+    buffers_.resize(request.count);
+    for (uint32_t i = 0; i < request.count; ++i) {
+        v4l2_buffer buffer{};
+        buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index = i;
+        if (xioctl(fd_, VIDIOC_QUERYBUF, &buffer) == -1) {
+            reportErrno(device_ + ": VIDIOC_QUERYBUF");
+            return false;
+        }
+        void* start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buffer.m.offset);
+        if (start == MAP_FAILED) {
+            reportErrno(device_ + ": mmap");
+            return false;
+        }
+        buffers_[i].start = start;
+        buffers_[i].length = buffer.length;
+        if (xioctl(fd_, VIDIOC_QBUF, &buffer) == -1) {
+            reportErrno(device_ + ": VIDIOC_QBUF");
+            return false;
+        }
+    }
+    return true;
+}
+
+void V4l2Source::unmapBuffers() {
+    for (Buffer& buffer : buffers_) {
+        if (buffer.start != nullptr) {
+            munmap(buffer.start, buffer.length);
+        }
+    }
+    buffers_.clear();
+    if (fd_ >= 0) {
+        // Frees the driver's buffers
+        v4l2_requestbuffers request{};
+        request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        request.memory = V4L2_MEMORY_MMAP;
+        xioctl(fd_, VIDIOC_REQBUFS, &request);
+    }
+}
+
+bool V4l2Source::start() {
+    fd_ = open(device_.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd_ < 0) {
+        reportErrno("cannot open " + device_);
+        return false;
+    }
+    v4l2_capability capability{};
+    if (xioctl(fd_, VIDIOC_QUERYCAP, &capability) == -1 ||
+        !(capability.device_caps & V4L2_CAP_VIDEO_CAPTURE) || !(capability.device_caps & V4L2_CAP_STREAMING)) {
+        std::cerr << device_ << " is not a streaming capture device" << std::endl;
+        stop();
+        return false;
+    }
+    if (!negotiateFormat() || !mapBuffers()) {
+        stop();
+        return false;
+    }
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_STREAMON, &type) == -1) {
+        reportErrno(device_ + ": VIDIOC_STREAMON");
+        stop();
+        return false;
+    }
+    streaming_ = true;
+    std::cout << device_ << ": " << width_ << "x" << height_ << ", " << buffers_.size() << " mmap buffers" << std::endl;
+    return true;
+}
+
+FrameSource::Status V4l2Source::acquire(Frame& frame, std::chrono::milliseconds timeout) {
+    pollfd pfd{fd_, POLLIN, 0};
+    int ready = poll(&pfd, 1, static_cast<int>(timeout.count()));
+    if (ready == 0 || (ready < 0 && errno == EINTR)) {
+        return Status::Timeout;
+    }
+    if (ready < 0) {
+        reportErrno(device_ + ": poll");
+        return Status::Error;
+    }
+
+    v4l2_buffer buffer{};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd_, VIDIOC_DQBUF, &buffer) == -1) {
+        if (errno == EAGAIN) {
+            return Status::Timeout;
+        }
+        reportErrno(device_ + ": VIDIOC_DQBUF");
+        return Status::Error;
+    }
+    frame.data = static_cast<const uint8_t*>(buffers_[buffer.index].start);
+    frame.bytes = buffer.bytesused;
+    frame.width = width_;
+    frame.height = height_;
+    frame.stride = stride_;
+    frame.fourcc = fourcc_;
+    frame.index = buffer.index;
+    frame.sequence = buffer.sequence;
+    // Drivers on the Pi stamp buffers with CLOCK_MONOTONIC
+    frame.timestampNs = static_cast<uint64_t>(buffer.timestamp.tv_sec) * 1000000000ULL +
+                        static_cast<uint64_t>(buffer.timestamp.tv_usec) * 1000ULL;
+    return Status::Ok;
+}
+
+void V4l2Source::release(const Frame& frame) {
+    if (!streaming_) {
+        return;
+    }
+    v4l2_buffer buffer{};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index = frame.index;
+    if (xioctl(fd_, VIDIOC_QBUF, &buffer) == -1) {
+        reportErrno(device_ + ": VIDIOC_QBUF");
+    }
+}
+
+void V4l2Source::stop() {
+    if (streaming_) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd_, VIDIOC_STREAMOFF, &type);
+        streaming_ = false;
+    }
+    unmapBuffers();
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
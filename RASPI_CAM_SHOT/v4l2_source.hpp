@@ -0,0 +1,48 @@
+#ifndef V4L2_SOURCE_HPP
+#define V4L2_SOURCE_HPP
+
+#include <string>
+#include <vector>
+
+#include "frame_source.hpp"
+
+/*
+ * Streaming capture from a V4L2 device through mmap'd driver buffers. The
+ * driver DMAs into a ring of bufferCount buffers; a dequeued buffer is
+ * handed out as a Frame and queued back on release(). Asks for planar
+ * YUV420 first, whose first plane is plain luma, then GREY, then YUYV.
+ * With the libcamera stack, run under libcamerify to get a V4L2 node.
+ */
+class V4l2Source : public FrameSource {
+public:
+    V4l2Source(std::string device, uint32_t width, uint32_t height, unsigned bufferCount = 4);
+    ~V4l2Source() override;
+
+    bool start() override;
+    Status acquire(Frame& frame, std::chrono::milliseconds timeout) override;
+    void release(const Frame& frame) override;
+    void stop() override;
+    const char* name() const override { return device_.c_str(); }
+
+private:
+    struct Buffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+
+    bool negotiateFormat();
+    bool mapBuffers();
+    void unmapBuffers();
+
+    std::string device_;
+    uint32_t width_;
+    uint32_t height_;
+    unsigned bufferCount_;
+    int fd_ = -1;
+    bool streaming_ = false;
+    uint32_t fourcc_ = 0;
+    uint32_t stride_ = 0;
+    std::vector<Buffer> buffers_;
+};
+
+#endif // V4L2_SOURCE_HPP
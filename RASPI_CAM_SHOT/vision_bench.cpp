@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "salience.hpp"
+
+/*
+ * Frames per second of the salience stage alone, per kernel and capture
+ * size. The frames are rendered up front, so the numbers leave out the
+ * camera and show what the CPU can sustain. Run it on the Pi with
+ * `make bench`.
+ */
+
+#define BENCH_FRAMES 16
+#define BENCH_MIN_NS 500000000ULL
+
+namespace {
+
+struct Size {
+    uint32_t width;
+    uint32_t height;
+};
+
+// A textured background with a blob that moves from frame to frame, plus some sensor noise
+std::vector<std::vector<uint8_t>> renderFrames(Size size) {
+    std::vector<std::vector<uint8_t>> frames(BENCH_FRAMES);
+    unsigned seed = 12345;
+    for (int f = 0; f < BENCH_FRAMES; ++f) {
+        frames[f].resize(static_cast<size_t>(size.width) * size.height);
+        double angle = 2.0 * M_PI * f / BENCH_FRAMES;
+        double cx = size.width / 2.0 + std::cos(angle) * size.width / 4.0;
+        double cy = size.height / 2.0 + std::sin(angle) * size.height / 4.0;
+        double r2 = (size.height / 8.0) * (size.height / 8.0);
+        for (uint32_t y = 0; y < size.height; ++y) {
+            for (uint32_t x = 0; x < size.width; ++x) {
+                seed = seed * 1103515245u + 12345u;
+                int value = static_cast<int>((x ^ y) & 63) + static_cast<int>((seed >> 16) % 7);
+                double dx = x - cx;
+                double dy = y - cy;
+                if (dx * dx + dy * dy < r2) {
+                    value += 160;
+                }
+                frames[f][static_cast<size_t>(y) * size.width + x] = static_cast<uint8_t>(value);
+            }
+        }
+    }
+    return frames;
+}
+
+Frame frameOf(const std::vector<uint8_t>& pixels, Size size, uint64_t sequence) {
+    Frame frame;
+    frame.data = pixels.data();
+    frame.bytes = pixels.size();
+    frame.width = size.width;
+    frame.height = size.height;
+    frame.stride = size.width;
+    frame.fourcc = V4L2_PIX_FMT_GREY;
+    frame.sequence = sequence;
+    return frame;
+}
+
+bool run(Size size, const std::vector<std::vector<uint8_t>>& frames, SalienceKernel kernel,
+         std::vector<Salience>* results) {
+    SalienceExtractor extractor(kernel);
+    uint64_t processed = 0;
+    uint64_t elapsedNs = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (elapsedNs < BENCH_MIN_NS) {
+        for (int f = 0; f < BENCH_FRAMES; ++f) {
+            Salience salience;
+            if (extractor.process(frameOf(frames[f], size, processed), salience) && results != nullptr &&
+                results->size() < BENCH_FRAMES) {
+                results->push_back(salience);
+            }
+            processed++;
+        }
+        elapsedNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+    }
+    std::printf("salience %4ux%-4u %-6s %8.0f fps %8.1f us/frame\n", size.width, size.height,
+                salienceKernelName(kernel), processed * 1e9 / elapsedNs, elapsedNs / 1e3 / processed);
+    return true;
+}
+
+} // namespace
+
+int main() {
+    const Size sizes[] = {{320, 240}, {640, 480}, {1280, 720}};
+    int mismatches = 0;
+    for (Size size : sizes) {
+        std::vector<std::vector<uint8_t>> frames = renderFrames(size);
+        std::vector<Salience> scalar;
+        std::vector<Salience> simd;
+        run(size, frames, SalienceKernel::Scalar, &scalar);
+        run(size, frames, SalienceKernel::Simd, &simd);
+        for (size_t i = 0; i < scalar.size() && i < simd.size(); ++i) {
+            if (scalar[i].left != simd[i].left || scalar[i].right != simd[i].right) {
+                std::fprintf(stderr, "kernel mismatch at %ux%u frame %zu: scalar %u/%u, simd %u/%u\n",
+                             size.width, size.height, i, scalar[i].left, scalar[i].right,
+                             simd[i].left, simd[i].right);
+                mismatches++;
+                break;
+            }
+        }
+    }
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
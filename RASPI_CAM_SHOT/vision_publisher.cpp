@@ -0,0 +1,58 @@
+#include "vision_publisher.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+VisionPublisher::~VisionPublisher() {
+    close();
+}
+
+bool VisionPublisher::open(const char* name) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("shm_open");
+        return false;
+    }
+    if (ftruncate(fd, sizeof(VisionShm_t)) != 0) {
+        perror("ftruncate");
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, sizeof(VisionShm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    shm_ = static_cast<VisionShm_t*>(map);
+    __atomic_store_n(&shm_->magic, VISION_SHM_MAGIC, __ATOMIC_RELAXED);
+    // An odd seq left by a writer that died mid-update would lock readers out
+    uint32_t seq = __atomic_load_n(&shm_->seq, __ATOMIC_RELAXED);
+    if (seq & 1u) {
+        __atomic_store_n(&shm_->seq, seq + 1, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+void VisionPublisher::publish(const Salience& salience, uint64_t publishNs) {
+    if (shm_ == nullptr) {
+        return;
+    }
+    VisionSample_t sample;
+    sample.frame_seq = salience.frameSequence;
+    sample.capture_ns = salience.captureNs;
+    sample.publish_ns = publishNs;
+    sample.salience_l = salience.left;
+    sample.salience_r = salience.right;
+    vision_shm_publish(shm_, &sample);
+}
+
+void VisionPublisher::close() {
+    if (shm_ != nullptr) {
+        munmap(shm_, sizeof(VisionShm_t));
+        shm_ = nullptr;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef VISION_PUBLISHER_HPP
+#define VISION_PUBLISHER_HPP
+
+#include "salience.hpp"
+#include "../common/vision/vision_shm.h"
+
+/*
+ * Writer side of the vision shared memory block. The block is created on
+ * open() and left in place on close, so a worm that already mapped it
+ * keeps reading after the camera process restarts.
+ */
+class VisionPublisher {
+public:
+    VisionPublisher() = default;
+    ~VisionPublisher();
+
+    VisionPublisher(const VisionPublisher&) = delete;
+    VisionPublisher& operator=(const VisionPublisher&) = delete;
+
+    bool open(const char* name = VISION_SHM_NAME);
+    void publish(const Salience& salience, uint64_t publishNs);
+    void close();
+
+private:
+    VisionShm_t* shm_ = nullptr;
+};
+
+#endif // VISION_PUBLISHER_HPP
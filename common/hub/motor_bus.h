@@ -0,0 +1,162 @@
+#ifndef MOTOR_BUS_H
+#define MOTOR_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Motor setpoint channel between controllers and the sensor_hub daemon,
+ * which is the only process that writes /dev/motor while a controller is
+ * on the bus. Controllers claim a slot, post struct ioctl_info frames
+ * there and beat a heartbeat; none of this costs a syscall.
+ *
+ * The hub arbitrates: the live slot with the highest priority owns the
+ * motors, and a tie keeps the current owner. A slot whose heartbeat is
+ * older than MOTOR_BUS_TIMEOUT_NS is freed. Whenever ownership changes
+ * the hub stops the car and waits for a setpoint the new owner posted
+ * after taking over, so one controller's last frame never carries over
+ * to the next. A new controller therefore takes over by joining with a
+ * higher priority, and the old one can be stopped at leisure.
+ *
+ * Each setpoint is a seqlock of its own, written only by the slot's
+ * controller. pid is claimed with a compare-and-swap from 0, and
+ * heartbeat_ns stays 0 until the claimer has filled in the slot.
+ */
+#define MOTOR_BUS_SHM_NAME "/car_motor_bus"
+#define MOTOR_BUS_MAGIC 0x4D425331u  // "MBS1"
+#define MOTOR_BUS_VERSION 1u
+#define MOTOR_BUS_SLOTS 4
+#define MOTOR_BUS_NAME_LEN 16
+#define MOTOR_BUS_MAX_PRIORITY 1000
+// Five control ticks of the worm, the same budget as its motor watchdog
+#define MOTOR_BUS_TIMEOUT_NS 500000000ull
+
+typedef struct {
+    uint32_t seq;       // counts the controller's setpoints, 0 before the first
+    uint8_t frame[5];   // struct ioctl_info buf, as sent with PI_CMD_IO
+    uint8_t reserved[3];
+} MotorSetpoint_t;
+
+#define MOTOR_SETPOINT_WORDS ((sizeof(MotorSetpoint_t) + 7u) / 8u)
+
+typedef struct {
+    uint32_t pid;                  // 0 for a free slot
+    uint32_t priority;
+    uint64_t heartbeat_ns;         // CLOCK_MONOTONIC of the last beat, 0 while claiming
+    uint32_t seq;                  // seqlock over setpoint
+    uint32_t reserved;
+    uint64_t setpoint[MOTOR_SETPOINT_WORDS];
+    char name[MOTOR_BUS_NAME_LEN];
+    uint64_t pad;                  // one slot per cache line
+} MotorBusSlot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t hub_pid;
+    uint32_t reserved;
+    MotorBusSlot_t slots[MOTOR_BUS_SLOTS];
+} MotorBus_t;
+
+static inline bool motor_bus_valid(const MotorBus_t* bus) {
+    return __atomic_load_n(&bus->magic, __ATOMIC_ACQUIRE) == MOTOR_BUS_MAGIC &&
+           __atomic_load_n(&bus->version, __ATOMIC_RELAXED) == MOTOR_BUS_VERSION;
+}
+
+/*
+ * Takes a free slot for pid and returns its index, or -1 if every slot
+ * is taken. The slot joins arbitration with its first heartbeat.
+ */
+static inline int motor_bus_claim(MotorBus_t* bus, uint32_t pid, uint32_t priority, const char* name,
+                                  uint64_t now_ns) {
+    for (int i = 0; i < MOTOR_BUS_SLOTS; ++i) {
+        MotorBusSlot_t* slot = &bus->slots[i];
+        uint32_t expected = 0;
+        if (!__atomic_compare_exchange_n(&slot->pid, &expected, pid, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        __atomic_store_n(&slot->heartbeat_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->priority, priority, __ATOMIC_RELAXED);
+        size_t len = strlen(name);
+        for (size_t c = 0; c < MOTOR_BUS_NAME_LEN; ++c) {
+            __atomic_store_n(&slot->name[c], c + 1 < MOTOR_BUS_NAME_LEN && c < len ? name[c] : '\0',
+                             __ATOMIC_RELAXED);
+        }
+        // An empty setpoint, so nothing left by the previous claimer is applied
+        for (unsigned w = 0; w < MOTOR_SETPOINT_WORDS; ++w) {
+            __atomic_store_n(&slot->setpoint[w], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&slot->heartbeat_ns, now_ns, __ATOMIC_RELEASE);
+        return i;
+    }
+    return -1;
+}
+
+// False once the hub has expired the slot; the controller has to claim again
+static inline bool motor_bus_beat(MotorBus_t* bus, int index, uint32_t pid, uint64_t now_ns) {
+    MotorBusSlot_t* slot = &bus->slots[index];
+    if (__atomic_load_n(&slot->pid, __ATOMIC_ACQUIRE) != pid) {
+        return false;
+    }
+    __atomic_store_n(&slot->heartbeat_ns, now_ns, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool motor_bus_post(MotorBus_t* bus, int index, uint32_t pid, const MotorSetpoint_t* setpoint,
+                                  uint64_t now_ns) {
+    MotorBusSlot_t* slot = &bus->slots[index];
+    if (__atomic_load_n(&slot->pid, __ATOMIC_ACQUIRE) != pid) {
+        return false;
+    }
+    uint64_t words[MOTOR_SETPOINT_WORDS] = {0};
+    memcpy(words, setpoint, sizeof(*setpoint));
+    uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (unsigned w = 0; w < MOTOR_SETPOINT_WORDS; ++w) {
+        __atomic_store_n(&slot->setpoint[w], words[w], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->heartbeat_ns, now_ns, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool motor_bus_read_setpoint(const MotorBus_t* bus, int index, MotorSetpoint_t* setpoint) {
+    const MotorBusSlot_t* slot = &bus->slots[index];
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        uint32_t begin = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (begin & 1u) {
+            continue;
+        }
+        uint64_t words[MOTOR_SETPOINT_WORDS];
+        for (unsigned w = 0; w < MOTOR_SETPOINT_WORDS; ++w) {
+            words[w] = __atomic_load_n(&slot->setpoint[w], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == begin) {
+            memcpy(setpoint, words, sizeof(*setpoint));
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline void motor_bus_read_name(const MotorBus_t* bus, int index, char name[MOTOR_BUS_NAME_LEN]) {
+    for (size_t c = 0; c < MOTOR_BUS_NAME_LEN; ++c) {
+        name[c] = __atomic_load_n(&bus->slots[index].name[c], __ATOMIC_RELAXED);
+    }
+    name[MOTOR_BUS_NAME_LEN - 1] = '\0';
+}
+
+// The heartbeat goes first so the hub never mistakes the slot for a live one
+static inline void motor_bus_release(MotorBus_t* bus, int index, uint32_t pid) {
+    MotorBusSlot_t* slot = &bus->slots[index];
+    if (__atomic_load_n(&slot->pid, __ATOMIC_ACQUIRE) != pid) {
+        return;
+    }
+    __atomic_store_n(&slot->heartbeat_ns, 0, __ATOMIC_RELEASE);
+    __atomic_compare_exchange_n(&slot->pid, &pid, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+#endif // MOTOR_BUS_H
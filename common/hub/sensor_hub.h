@@ -0,0 +1,105 @@
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * One snapshot of everything the car senses, published by the sensor_hub
+ * daemon so controllers stop opening /dev/sr04, /dev/ir_device and
+ * /dev/motor each on their own. The daemon is the only process that
+ * ranges with the SR04 and reads the IR edge queue.
+ *
+ * The block lives in POSIX shared memory and is a seqlock like the vision
+ * block: the writer makes seq odd, copies the snapshot in 64-bit words and
+ * makes seq even again. Readers copy the words out and retry if seq moved,
+ * so a read costs no syscall at all and never blocks the daemon.
+ *
+ * Every source has its own CLOCK_MONOTONIC stamp, so a reader can tell a
+ * fresh distance from one that is only being republished next to a new IR
+ * edge. version changes whenever the snapshot layout does; a reader
+ * refuses a block whose version it does not know.
+ *
+ * The owner fields report the motor bus (common/hub/motor_bus.h): which
+ * controller's setpoints the hub is applying and the last one it applied.
+ */
+#define HUB_SHM_NAME "/car_sensor_hub"
+#define HUB_SHM_MAGIC 0x48554231u  // "HUB1"
+#define HUB_SNAPSHOT_VERSION 1u
+// The hub republishes at least this often, so a stale publish_ns means it is gone
+#define HUB_HEARTBEAT_NS 50000000ull
+#define HUB_NO_OWNER 0xFFu
+
+// Bits of HubSnapshot_t.valid: which sources have reported since the hub started
+#define HUB_HAVE_DISTANCE 0x01u
+#define HUB_HAVE_IR 0x02u
+#define HUB_HAVE_MOTOR 0x04u
+
+typedef struct {
+    uint64_t publish_ns;      // when this snapshot was written
+    uint64_t distance_ns;     // when the last measurement finished
+    uint64_t ir_ns;           // driver stamp of the last IR edge
+    uint64_t motor_ns;        // driver stamp of motor_frame
+    uint32_t distance_cm;     // 0 when the echo never came back
+    uint32_t distance_seq;    // measurements so far, to wait for a new one
+    uint32_t owner_pid;       // controller driving through the motor bus, 0 for none
+    uint32_t owner_applied;   // seq of the owner's setpoint last sent to the motors
+    uint8_t ir_state;         // IR_LEFT | IR_RIGHT from common/ir/ir_event.h
+    uint8_t valid;            // HUB_HAVE_*
+    uint8_t motor_frame[5];   // last struct ioctl_info buf the motor driver sent
+    uint8_t owner_slot;       // motor bus slot of owner_pid, HUB_NO_OWNER for none
+} HubSnapshot_t;
+
+#define HUB_SNAPSHOT_WORDS ((sizeof(HubSnapshot_t) + 7u) / 8u)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;
+    uint32_t writer_pid;
+    uint64_t words[HUB_SNAPSHOT_WORDS];
+} HubShm_t;
+
+// Single writer; words are stored with relaxed atomics like vision_shm_publish
+static inline void hub_shm_publish(HubShm_t* shm, const HubSnapshot_t* snapshot) {
+    uint64_t words[HUB_SNAPSHOT_WORDS] = {0};
+    memcpy(words, snapshot, sizeof(*snapshot));
+    uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (unsigned i = 0; i < HUB_SNAPSHOT_WORDS; ++i) {
+        __atomic_store_n(&shm->words[i], words[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&shm->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Returns false if nothing has been published yet, the layout is one this
+ * reader does not know, or the writer kept the block busy for every
+ * attempt.
+ */
+static inline bool hub_shm_read(const HubShm_t* shm, HubSnapshot_t* snapshot) {
+    if (__atomic_load_n(&shm->magic, __ATOMIC_RELAXED) != HUB_SHM_MAGIC ||
+        __atomic_load_n(&shm->version, __ATOMIC_RELAXED) != HUB_SNAPSHOT_VERSION) {
+        return false;
+    }
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        uint32_t begin = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        if (begin & 1u) {
+            continue;
+        }
+        uint64_t words[HUB_SNAPSHOT_WORDS];
+        for (unsigned i = 0; i < HUB_SNAPSHOT_WORDS; ++i) {
+            words[i] = __atomic_load_n(&shm->words[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == begin) {
+            memcpy(snapshot, words, sizeof(*snapshot));
+            return begin != 0;
+        }
+    }
+    return false;
+}
+
+#endif // SENSOR_HUB_H
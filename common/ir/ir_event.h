@@ -0,0 +1,31 @@
+#ifndef IR_EVENT_H
+#define IR_EVENT_H
+
+#include <linux/types.h>
+
+/*
+ * IR obstacle sensors, shared by the ir_avoid driver and its readers.
+ *
+ * Every read of /dev/ir_device returns whole struct ir_event records. A
+ * record is queued for each edge of either sensor, stamped in the IRQ, and
+ * each open file sees every edge. The first record after open() is a
+ * snapshot of the current state with changed == 0, so a reader always
+ * knows where it stands. read() blocks until an edge arrives unless the
+ * file is O_NONBLOCK; poll() reports EPOLLIN while records are queued.
+ *
+ * Writing "OFF" stops reporting (a record with state 0 is queued) and
+ * "ON" resumes it.
+ */
+#define IR_DEVNAME "/dev/ir_device"
+
+#define IR_LEFT 0x01u
+#define IR_RIGHT 0x02u
+
+struct ir_event {
+    __u64 timestamp_ns;  // ktime_get_ns() (CLOCK_MONOTONIC) at the edge
+    __u8 state;          // IR_LEFT | IR_RIGHT: obstacle seen after this edge
+    __u8 changed;        // sensors whose output moved; 0 for a snapshot
+    __u8 reserved[6];
+};
+
+#endif // IR_EVENT_H
@@ -2,12 +2,32 @@
 #define IOCTL_CAR_CMD_H
 
 #include <linux/ioctl.h>
+#include <linux/types.h>
 
 struct ioctl_info {
     unsigned long size;
     char buf[5];
 };
 
+/*
+ * Deadman watchdog of one open motor file. While timeout_ms is non-zero,
+ * every motion command must be followed by another within timeout_ms,
+ * otherwise the driver stops the motors on its own.
+ */
+struct motor_watchdog {
+    __u32 timeout_ms;   // 0 disables the watchdog for this file
+    __u32 trips;        // watchdog stops caused by this file (read only)
+    __u32 total_trips;  // watchdog stops since the module was loaded (read only)
+    __u32 reserved;
+};
+
+// The last frame the driver sent to the motor controller, whoever sent it
+struct motor_frame {
+    __u64 timestamp_ns;  // ktime_get_ns() when it was written, 0 if none yet
+    char buf[5];
+    __u8 reserved[3];
+};
+
 enum {
     CMD_LEFT = 3,
     CMD_RIGHT,
@@ -16,6 +36,9 @@ enum {
     CMD_BACKWARD,
     CMD_STOP,
     CMD_IO,
+    CMD_WATCHDOG_SET,
+    CMD_WATCHDOG_GET,
+    CMD_LAST_FRAME,
 };
 
 #define			IOCTL_MAGIC     'G'
@@ -27,5 +50,8 @@ enum {
 #define			PI_CMD_BACKWARD		_IOW(IOCTL_MAGIC, CMD_BACKWARD, struct ioctl_info)
 #define			PI_CMD_STOP		_IOW(IOCTL_MAGIC, CMD_STOP,	struct ioctl_info)
 #define			PI_CMD_IO		_IOW(IOCTL_MAGIC, CMD_IO,	struct ioctl_info)
+#define			PI_CMD_WATCHDOG_SET	_IOW(IOCTL_MAGIC, CMD_WATCHDOG_SET,	struct motor_watchdog)
+#define			PI_CMD_WATCHDOG_GET	_IOR(IOCTL_MAGIC, CMD_WATCHDOG_GET,	struct motor_watchdog)
+#define			PI_CMD_LAST_FRAME	_IOR(IOCTL_MAGIC, CMD_LAST_FRAME,	struct motor_frame)
 
 #endif
@@ -0,0 +1,152 @@
+#ifndef CAR_LINK_H
+#define CAR_LINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * UDP link between the car and a base station. The car streams state
+ * frames; the station answers with motor command frames. Every frame
+ * starts with an 8-byte header (magic, version, type, flags, seq) and all
+ * multi-byte fields are little-endian, so the frames do not depend on
+ * either side's struct layout.
+ *
+ * A command names the newest state frame the station had seen when it
+ * decided (basis_state_seq). The car remembers when it sent each state, so
+ * it can tell how old the station's picture was without the two clocks
+ * agreeing, and drops commands based on a picture that is too old.
+ * Commands are ordered by (basis_state_seq, seq): a restarted station
+ * resyncs as soon as it has seen a state, while late or duplicated
+ * datagrams are dropped.
+ */
+#define CAR_LINK_MAGIC 0xCAu
+#define CAR_LINK_VERSION 1u
+#define CAR_LINK_DEFAULT_PORT 63000
+#define CAR_LINK_HEADER_BYTES 8
+#define CAR_LINK_STATE_BYTES (CAR_LINK_HEADER_BYTES + 16)
+#define CAR_LINK_COMMAND_BYTES (CAR_LINK_HEADER_BYTES + 8)
+#define CAR_LINK_MAX_FRAME_BYTES CAR_LINK_STATE_BYTES
+
+enum {
+    CAR_LINK_TYPE_STATE = 1,
+    CAR_LINK_TYPE_COMMAND = 2,
+};
+
+// State flags
+#define CAR_LINK_STATE_REST 0x01u
+#define CAR_LINK_STATE_REMOTE 0x02u  // a station command is driving the motors
+// Command flags
+#define CAR_LINK_COMMAND_RELEASE 0x01u  // hand the motors back to the car at once
+
+typedef struct {
+    uint32_t seq;
+    uint32_t uptime_ms;        // car's CLOCK_MONOTONIC, for the station's jitter and loss figures
+    uint32_t ack_command_seq;  // last command the car accepted
+    uint16_t distance_cm;
+    int8_t left_speed;         // -100..100 as sent to the motors
+    int8_t right_speed;
+    uint8_t salience_l;        // camera salience, 0..255
+    uint8_t salience_r;
+    uint8_t atp;               // energy, 0..100
+    uint8_t flags;
+} CarLinkState_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t basis_state_seq;
+    int8_t left_speed;
+    int8_t right_speed;
+    uint16_t hold_ms;  // how long the command drives the motors without a successor
+    uint8_t flags;
+} CarLinkCommand_t;
+
+static inline void car_link_put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void car_link_put32(uint8_t* p, uint32_t v) {
+    car_link_put16(p, (uint16_t)v);
+    car_link_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t car_link_get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t car_link_get32(const uint8_t* p) {
+    return (uint32_t)car_link_get16(p) | (uint32_t)car_link_get16(p + 2) << 16;
+}
+
+static inline void car_link_put_header(uint8_t* p, uint8_t type, uint8_t flags, uint32_t seq) {
+    p[0] = CAR_LINK_MAGIC;
+    p[1] = CAR_LINK_VERSION;
+    p[2] = type;
+    p[3] = flags;
+    car_link_put32(p + 4, seq);
+}
+
+static inline bool car_link_check_header(const uint8_t* p, size_t len, uint8_t type, size_t bytes) {
+    return len == bytes && p[0] == CAR_LINK_MAGIC && p[1] == CAR_LINK_VERSION && p[2] == type;
+}
+
+static inline size_t car_link_encode_state(const CarLinkState_t* state, uint8_t* p) {
+    car_link_put_header(p, CAR_LINK_TYPE_STATE, state->flags, state->seq);
+    car_link_put32(p + 8, state->uptime_ms);
+    car_link_put32(p + 12, state->ack_command_seq);
+    car_link_put16(p + 16, state->distance_cm);
+    p[18] = (uint8_t)state->left_speed;
+    p[19] = (uint8_t)state->right_speed;
+    p[20] = state->salience_l;
+    p[21] = state->salience_r;
+    p[22] = state->atp;
+    p[23] = 0;
+    return CAR_LINK_STATE_BYTES;
+}
+
+static inline bool car_link_decode_state(const uint8_t* p, size_t len, CarLinkState_t* state) {
+    if (!car_link_check_header(p, len, CAR_LINK_TYPE_STATE, CAR_LINK_STATE_BYTES)) {
+        return false;
+    }
+    state->flags = p[3];
+    state->seq = car_link_get32(p + 4);
+    state->uptime_ms = car_link_get32(p + 8);
+    state->ack_command_seq = car_link_get32(p + 12);
+    state->distance_cm = car_link_get16(p + 16);
+    state->left_speed = (int8_t)p[18];
+    state->right_speed = (int8_t)p[19];
+    state->salience_l = p[20];
+    state->salience_r = p[21];
+    state->atp = p[22];
+    return true;
+}
+
+static inline size_t car_link_encode_command(const CarLinkCommand_t* command, uint8_t* p) {
+    car_link_put_header(p, CAR_LINK_TYPE_COMMAND, command->flags, command->seq);
+    car_link_put32(p + 8, command->basis_state_seq);
+    p[12] = (uint8_t)command->left_speed;
+    p[13] = (uint8_t)command->right_speed;
+    car_link_put16(p + 14, command->hold_ms);
+    return CAR_LINK_COMMAND_BYTES;
+}
+
+static inline bool car_link_decode_command(const uint8_t* p, size_t len, CarLinkCommand_t* command) {
+    if (!car_link_check_header(p, len, CAR_LINK_TYPE_COMMAND, CAR_LINK_COMMAND_BYTES)) {
+        return false;
+    }
+    command->flags = p[3];
+    command->seq = car_link_get32(p + 4);
+    command->basis_state_seq = car_link_get32(p + 8);
+    command->left_speed = (int8_t)p[12];
+    command->right_speed = (int8_t)p[13];
+    command->hold_ms = car_link_get16(p + 14);
+    return true;
+}
+
+// Serial-number comparison, so the 32-bit counters may wrap
+static inline bool car_link_seq_after(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+#endif // CAR_LINK_H
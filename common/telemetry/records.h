@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_RECORDS_H
+#define TELEMETRY_RECORDS_H
+
+#include <stdint.h>
+
+/*
+ * Fixed-size binary telemetry records written by the control loops.
+ * The record kind is stored in every segment header so the decoder
+ * knows which layout follows.
+ */
+enum {
+    TELEMETRY_KIND_WORM = 1,
+    TELEMETRY_KIND_RUNNER = 2,
+    TELEMETRY_KIND_WORM_TRACE = 3,
+};
+
+/*
+ * Neuromodulator channels of a worm record, in the order of the worm's
+ * NeuroModulator_t enum.
+ */
+#define TELEMETRY_NEUROMOD_CHANNELS 12
+#define TELEMETRY_NEUROMOD_NAMES \
+    "dopamine", "serotonin", "acetylcholine", "gaba", "epinephrine", "norepinephrine", \
+    "glutamate", "endorphin", "oxytocin", "cortisol", "stability", "atp"
+
+typedef struct {
+    uint64_t timestamp_ns;
+    int16_t left_speed;
+    int16_t right_speed;
+    uint8_t rest_mode;
+    uint8_t reserved[3];
+    int32_t neuromod_fx[TELEMETRY_NEUROMOD_CHANNELS];  // Q16.16, in TELEMETRY_NEUROMOD_NAMES order
+} WormTelemetry_t;
+
+enum {
+    RUNNER_ACTION_FORWARD = 0,
+    RUNNER_ACTION_BACKWARD,
+    RUNNER_ACTION_RIGHT,
+    RUNNER_ACTION_LEFT,
+    RUNNER_ACTION_STOP,
+    RUNNER_ACTION_RANDOM_TURN,
+};
+
+typedef struct {
+    uint64_t timestamp_ns;
+    uint32_t distance_cm;
+    uint8_t ir_flag;
+    uint8_t action;
+    uint8_t left_speed;
+    uint8_t right_speed;
+} RunnerTelemetry_t;
+
+/*
+ * Sensor trace for offline replay of the worm controller. A trace starts
+ * with a SEED event; each control tick starts with a TICK event followed
+ * by the raw inputs consumed during that tick, in consumption order.
+ */
+enum {
+    TRACE_EVENT_SEED = 0,
+    TRACE_EVENT_TICK,
+    TRACE_EVENT_DISTANCE,
+    TRACE_EVENT_ULTRA_PACKET,
+    TRACE_EVENT_VISION,  // left salience in the low 16 bits, right above
+    TRACE_EVENT_REMOTE_DRIVE,
+};
+
+typedef struct {
+    uint64_t timestamp_ns;
+    uint32_t tick;
+    uint32_t value;
+    uint8_t type;
+    uint8_t reserved[7];
+} WormTraceRecord_t;
+
+#endif // TELEMETRY_RECORDS_H
@@ -0,0 +1,198 @@
+#ifndef ULTRA_DEMOD_H
+#define ULTRA_DEMOD_H
+
+#include "ultra_proto.h"
+
+/*
+ * Pulse demodulator for both protocol versions, shared by the SR04 echo
+ * IRQ and the worm's channel simulator. Feed it one echo pulse at a time
+ * as rising and falling edge timestamps; it returns 1 and fills *out when
+ * the pulse completes a packet. Widths are compared in nanoseconds, with
+ * no 64-bit division, so it is safe in a 32-bit kernel.
+ *
+ * A sync pulse opens a v2 frame, and pulses inside a frame are v2
+ * symbols. Pulses outside a frame go to the v1 decoder, so older worms
+ * are still heard.
+ */
+
+struct ultra_demod_stats {
+    __u64 packets;
+    __u64 frame_errors; // packets abandoned on bad framing or timing
+    __u64 crc_errors;   // complete v2 frames failing their CRC
+    __u64 noise;        // pulses matching no width
+};
+
+struct ultra_demod {
+    // v1 state
+    __u64 v1_last_fall_ns;
+    __u8 v1_half_zero; // first short pulse of a 0 bit seen
+    __u8 v1_bits;
+    __u8 v1_value;
+    // v2 state
+    __u8 v2_active;
+    __u8 v2_symbols;
+    __u8 v2_frame[ULTRA2_FRAME_BYTES];
+    __u64 v2_sync_rise_ns;
+    __u64 v2_last_fall_ns;
+    struct ultra_demod_stats stats;
+};
+
+static inline int ultra_width_is(__u64 width_ns, __u32 nominal_us, __u32 tolerance_us) {
+    return width_ns + (__u64)tolerance_us * 1000u >= (__u64)nominal_us * 1000u &&
+           width_ns <= (__u64)(nominal_us + tolerance_us) * 1000u;
+}
+
+static inline void ultra_demod_v1_reset(struct ultra_demod* demod) {
+    demod->v1_half_zero = 0;
+    demod->v1_bits = 0;
+    demod->v1_value = 0;
+}
+
+static inline int ultra_demod_v1_bit(struct ultra_demod* demod, unsigned int bit, __u64 fall_ns,
+                                     struct ultra_rx_packet* out) {
+    if (demod->v1_bits == 0 && bit == 0) { // idle until a start bit
+        return 0;
+    }
+    demod->v1_value = (__u8)((demod->v1_value << 1) | bit);
+    if (++demod->v1_bits < ULTRA_PACKET_BITS) {
+        return 0;
+    }
+    __u8 packet = demod->v1_value;
+    ultra_demod_v1_reset(demod);
+    if (!(packet & ULTRA_STOP_BIT)) {
+        demod->stats.frame_errors++;
+        return 0;
+    }
+    out->version = 1;
+    out->sender = 0;
+    out->seq = 0;
+    out->packet = packet;
+    out->age_ns = 0;
+    out->rx_ns = fall_ns;
+    demod->stats.packets++;
+    return 1;
+}
+
+static inline int ultra_demod_v1_pulse(struct ultra_demod* demod, __u64 rise_ns, __u64 fall_ns,
+                                       struct ultra_rx_packet* out) {
+    __u64 width = fall_ns - rise_ns;
+    __u64 gap = rise_ns - demod->v1_last_fall_ns;
+    int in_packet = demod->v1_bits > 0 || demod->v1_half_zero;
+
+    if (in_packet && gap > ULTRA_GAP_TIMEOUT_NS) { // sender went quiet mid-packet
+        if (demod->v1_bits > 0) {
+            demod->stats.frame_errors++;
+        }
+        ultra_demod_v1_reset(demod);
+    }
+    if (ultra_width_is(width, ULTRA_PULSE_SHORT_US, ULTRA_PULSE_TOLERANCE_US)) {
+        demod->v1_last_fall_ns = fall_ns;
+        if (!demod->v1_half_zero) {
+            demod->v1_half_zero = 1;
+            return 0;
+        }
+        demod->v1_half_zero = 0;
+        if (gap > ULTRA_PAIR_GAP_MAX_NS) { // two lone short pulses are not a 0 bit
+            if (demod->v1_bits > 0) {
+                demod->stats.frame_errors++;
+            }
+            ultra_demod_v1_reset(demod);
+            demod->v1_half_zero = 1;
+            return 0;
+        }
+        return ultra_demod_v1_bit(demod, 0, fall_ns, out);
+    }
+    if (ultra_width_is(width, ULTRA_PULSE_LONG_US, ULTRA_PULSE_TOLERANCE_US)) {
+        demod->v1_last_fall_ns = fall_ns;
+        if (demod->v1_half_zero) { // a 0 bit cut in half
+            if (demod->v1_bits > 0) {
+                demod->stats.frame_errors++;
+            }
+            ultra_demod_v1_reset(demod);
+        }
+        return ultra_demod_v1_bit(demod, 1, fall_ns, out);
+    }
+    demod->stats.noise++;
+    return 0;
+}
+
+// Returns the symbol a pulse encodes, or -1
+static inline int ultra_demod_v2_symbol(__u64 width_ns) {
+    for (int symbol = 0; symbol < (1 << ULTRA2_SYMBOL_BITS); ++symbol) {
+        if (ultra_width_is(width_ns, (__u32)(symbol + 1) * ULTRA2_SYMBOL_BASE_US, ULTRA2_SYMBOL_TOLERANCE_US)) {
+            return symbol;
+        }
+    }
+    return -1;
+}
+
+static inline int ultra_demod_v2_finish(struct ultra_demod* demod, __u64 fall_ns, struct ultra_rx_packet* out) {
+    const __u8* frame = demod->v2_frame;
+    __u64 age_ns;
+
+    demod->v2_active = 0;
+    if (ultra2_crc8(frame, ULTRA2_BYTE_CRC) != frame[ULTRA2_BYTE_CRC]) {
+        demod->stats.crc_errors++;
+        return 0;
+    }
+    age_ns = (__u64)frame[ULTRA2_BYTE_AGE] * ULTRA2_AGE_UNIT_NS + (fall_ns - demod->v2_sync_rise_ns);
+    out->version = 2;
+    out->sender = frame[ULTRA2_BYTE_SENDER];
+    out->seq = frame[ULTRA2_BYTE_SEQ];
+    out->packet = frame[ULTRA2_BYTE_PACKET];
+    out->age_ns = age_ns > 0xFFFFFFFFu ? 0xFFFFFFFFu : (__u32)age_ns;
+    out->rx_ns = fall_ns;
+    demod->stats.packets++;
+    return 1;
+}
+
+static inline int ultra_demod_pulse(struct ultra_demod* demod, __u64 rise_ns, __u64 fall_ns,
+                                    struct ultra_rx_packet* out) {
+    __u64 width = fall_ns - rise_ns;
+
+    if (demod->v2_active && rise_ns - demod->v2_last_fall_ns > ULTRA2_GAP_TIMEOUT_NS) {
+        demod->stats.frame_errors++;
+        demod->v2_active = 0;
+    }
+    if (ultra_width_is(width, ULTRA2_SYNC_US, ULTRA2_SYMBOL_TOLERANCE_US)) {
+        if (demod->v2_active) { // a new frame overran the old one
+            demod->stats.frame_errors++;
+        }
+        demod->v2_active = 1;
+        demod->v2_symbols = 0;
+        for (int i = 0; i < ULTRA2_FRAME_BYTES; ++i) {
+            demod->v2_frame[i] = 0;
+        }
+        demod->v2_sync_rise_ns = rise_ns;
+        demod->v2_last_fall_ns = fall_ns;
+        return 0;
+    }
+    if (!demod->v2_active) {
+        return ultra_demod_v1_pulse(demod, rise_ns, fall_ns, out);
+    }
+
+    // Inside a frame a stray pulse is skipped; the CRC catches what it did to the timing
+    int symbol = ultra_demod_v2_symbol(width);
+    if (symbol < 0) {
+        demod->stats.noise++;
+        return 0;
+    }
+    unsigned int bit = (unsigned int)demod->v2_symbols * ULTRA2_SYMBOL_BITS;
+    demod->v2_frame[bit / 8] |= (__u8)(symbol << (8 - ULTRA2_SYMBOL_BITS - bit % 8));
+    demod->v2_last_fall_ns = fall_ns;
+    if (++demod->v2_symbols < ULTRA2_FRAME_SYMBOLS) {
+        return 0;
+    }
+    return ultra_demod_v2_finish(demod, fall_ns, out);
+}
+
+/*
+ * Until when ranging should hold off for the frame being received, 0 with
+ * no frame open. A sender that went quiet is only noticed at the next
+ * pulse, so the hold-off ends at the latest a frame could end.
+ */
+static inline __u64 ultra_demod_busy_until(const struct ultra_demod* demod) {
+    return demod->v2_active ? demod->v2_sync_rise_ns + ULTRA2_FRAME_MAX_NS : 0;
+}
+
+#endif // ULTRA_DEMOD_H
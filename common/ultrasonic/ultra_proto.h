@@ -0,0 +1,121 @@
+#ifndef ULTRA_PROTO_H
+#define ULTRA_PROTO_H
+
+#include <linux/types.h>
+
+/*
+ * Ultrasonic social channel shared by the SR04 driver, which demodulates
+ * echo pulses into packets, and the worm, which transmits them.
+ *
+ * Protocol v1: a packet is 7 bits, most significant first: start bit,
+ * 3-bit emotion, 2-bit intensity, stop bit. A 0 bit is two short pulses,
+ * each followed by ULTRA_INTERVAL_ZERO_NS; a 1 bit is one long pulse
+ * followed by ULTRA_INTERVAL_ONE_NS.
+ */
+#define ULTRA_PACKET_BITS 7
+#define ULTRA_START_BIT (1u << 6)
+#define ULTRA_STOP_BIT 0x01u
+#define ULTRA_PULSE_SHORT_US 1200
+#define ULTRA_PULSE_LONG_US 3200
+#define ULTRA_INTERVAL_ZERO_NS 100000000L
+#define ULTRA_INTERVAL_ONE_NS 200000000L
+
+/*
+ * Receiver tolerances. Pulse widths within ULTRA_PULSE_TOLERANCE_US of a
+ * nominal width are classified, anything else is noise. A gap longer than
+ * ULTRA_GAP_TIMEOUT_NS ends a partial packet; the second short pulse of a
+ * 0 bit must follow within ULTRA_PAIR_GAP_MAX_NS.
+ */
+#define ULTRA_PULSE_TOLERANCE_US 500
+#define ULTRA_GAP_TIMEOUT_NS (ULTRA_INTERVAL_ONE_NS + ULTRA_INTERVAL_ONE_NS / 2)
+#define ULTRA_PAIR_GAP_MAX_NS ((ULTRA_INTERVAL_ZERO_NS + ULTRA_INTERVAL_ONE_NS) / 2)
+
+/*
+ * Our own echo rises this soon after our trigger edge: the SR04 raises
+ * ECHO once its burst is out, and the longest pulse we send is the 4 ms v2
+ * sync. The receiver drops the pulse that rises in this window, however
+ * long it stays high, and hears whatever rises after it.
+ */
+#define ULTRA_SELF_ECHO_RISE_NS 5000000L
+
+/*
+ * Protocol v2: a sync pulse, then a 5-byte frame sent as 2-bit symbols,
+ * most significant first. Symbol s is a pulse (s + 1) * 600 us wide, and
+ * every pulse is followed by a 12 ms gap. A frame takes about 290 ms on air
+ * against 1.4 to 2.8 s for a v1 packet, and carries sender, sequence number
+ * and age, protected by a CRC-8.
+ */
+#define ULTRA2_SYNC_US 4000
+#define ULTRA2_SYMBOL_BITS 2
+#define ULTRA2_SYMBOL_BASE_US 600
+#define ULTRA2_SYMBOL_TOLERANCE_US 250
+#define ULTRA2_GAP_NS 12000000L
+#define ULTRA2_GAP_TIMEOUT_NS (3 * ULTRA2_GAP_NS)
+#define ULTRA2_FRAME_BYTES 5
+#define ULTRA2_FRAME_SYMBOLS (ULTRA2_FRAME_BYTES * 8 / ULTRA2_SYMBOL_BITS)
+#define ULTRA2_AGE_UNIT_NS 10000000L // the age byte counts 10 ms steps
+#define ULTRA2_AGE_MAX 255
+#define ULTRA2_CRC_POLY 0x07
+// Sync rise to the fall of the last symbol, with every symbol at its widest
+#define ULTRA2_FRAME_MAX_NS \
+    (ULTRA2_SYNC_US * 1000L + \
+     ULTRA2_FRAME_SYMBOLS * (ULTRA2_GAP_NS + (1L << ULTRA2_SYMBOL_BITS) * ULTRA2_SYMBOL_BASE_US * 1000L))
+
+/*
+ * A ranging trigger inside a v2 frame blanks one of its pulses, and a
+ * frame is lost to a single pulse. The SR04 driver therefore refuses to
+ * range, with EBUSY, while it is receiving a frame (until the frame ends,
+ * at most ULTRA2_FRAME_MAX_NS after its sync) or sending one (until
+ * ULTRA2_GAP_TIMEOUT_NS after the last trigger edge). The caller keeps its
+ * previous distance; no frame holds ranging off for more than 300 ms.
+ */
+
+enum {
+    ULTRA2_BYTE_SENDER,
+    ULTRA2_BYTE_SEQ,
+    ULTRA2_BYTE_PACKET, // the v1 packet: start, emotion, intensity, stop
+    ULTRA2_BYTE_AGE,    // how long the sender held the packet before sending it
+    ULTRA2_BYTE_CRC,    // CRC-8 over the bytes above
+};
+
+static inline __u8 ultra2_crc8(const __u8* data, unsigned int len) {
+    __u8 crc = 0;
+    for (unsigned int i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (__u8)((crc & 0x80u) ? (crc << 1) ^ ULTRA2_CRC_POLY : crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline void ultra2_frame_build(__u8 frame[ULTRA2_FRAME_BYTES], __u8 sender, __u8 seq, __u8 packet,
+                                      __u8 age) {
+    frame[ULTRA2_BYTE_SENDER] = sender;
+    frame[ULTRA2_BYTE_SEQ] = seq;
+    frame[ULTRA2_BYTE_PACKET] = packet;
+    frame[ULTRA2_BYTE_AGE] = age;
+    frame[ULTRA2_BYTE_CRC] = ultra2_crc8(frame, ULTRA2_BYTE_CRC);
+}
+
+/*
+ * One received packet as read() from /dev/sr04_comm. v1 packets carry no
+ * sender, sequence number or age and report zeros.
+ */
+struct ultra_rx_packet {
+    __u8 version;
+    __u8 sender;
+    __u8 seq;
+    __u8 packet;
+    __u32 age_ns; // sender's age plus time on air, as of rx_ns
+    __u64 rx_ns;  // CLOCK_MONOTONIC at the last falling edge
+};
+
+/*
+ * Minor 1 of the sr04 driver. read() returns whole struct ultra_rx_packet
+ * records and honours O_NONBLOCK, poll() reports EPOLLIN while packets are
+ * queued, and write() of '1'/'0' drives the trigger for transmitting.
+ */
+#define ULTRA_COMM_DEVNAME "/dev/sr04_comm"
+
+#endif // ULTRA_PROTO_H
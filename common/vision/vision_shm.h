@@ -0,0 +1,76 @@
+#ifndef VISION_SHM_H
+#define VISION_SHM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Left/right visual salience published by the camera process for the
+ * worm. The block lives in POSIX shared memory and is guarded by a
+ * seqlock: the single writer makes seq odd while it updates the fields,
+ * readers retry until they see the same even seq before and after their
+ * copy. Neither side ever blocks the other.
+ *
+ * Salience is Q0.16: 0 is a still scene, VISION_SALIENCE_ONE is motion
+ * at or above full scale on that half of the image.
+ */
+#define VISION_SHM_NAME "/worm_vision"
+#define VISION_SHM_MAGIC 0x56495331u  // "VIS1"
+#define VISION_SALIENCE_ONE 0xFFFFu
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint64_t frame_seq;
+    uint64_t capture_ns;  // CLOCK_MONOTONIC when the frame was exposed
+    uint64_t publish_ns;  // CLOCK_MONOTONIC when the salience was written
+    uint16_t salience_l;
+    uint16_t salience_r;
+    uint32_t reserved;
+} VisionShm_t;
+
+typedef struct {
+    uint64_t frame_seq;
+    uint64_t capture_ns;
+    uint64_t publish_ns;
+    uint16_t salience_l;
+    uint16_t salience_r;
+} VisionSample_t;
+
+// Fields are accessed with relaxed atomics so C and C++ readers agree with the writer without locks
+static inline void vision_shm_publish(VisionShm_t* shm, const VisionSample_t* sample) {
+    uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&shm->frame_seq, sample->frame_seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->capture_ns, sample->capture_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->publish_ns, sample->publish_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->salience_l, sample->salience_l, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->salience_r, sample->salience_r, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Returns false if no sample has been published yet or the writer kept
+ * the block busy for every attempt.
+ */
+static inline bool vision_shm_read(const VisionShm_t* shm, VisionSample_t* sample) {
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        uint32_t begin = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        if (begin & 1u) {
+            continue;
+        }
+        sample->frame_seq = __atomic_load_n(&shm->frame_seq, __ATOMIC_RELAXED);
+        sample->capture_ns = __atomic_load_n(&shm->capture_ns, __ATOMIC_RELAXED);
+        sample->publish_ns = __atomic_load_n(&shm->publish_ns, __ATOMIC_RELAXED);
+        sample->salience_l = __atomic_load_n(&shm->salience_l, __ATOMIC_RELAXED);
+        sample->salience_r = __atomic_load_n(&shm->salience_r, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == begin) {
+            return begin != 0;
+        }
+    }
+    return false;
+}
+
+#endif // VISION_SHM_H
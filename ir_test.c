@@ -1,19 +1,56 @@
 #include<fcntl.h>
 #include<unistd.h>
 #include<stdio.h>
+#include<poll.h>
+#include<string.h>
+#include "common/ir/ir_event.h"
+
+static void print_event(const struct ir_event *event) {
+	printf("%llu ns: left %s, right %s%s\n", (unsigned long long)event->timestamp_ns,
+		(event->state & IR_LEFT) ? "obstacle" : "clear",
+		(event->state & IR_RIGHT) ? "obstacle" : "clear",
+		event->changed ? "" : " (snapshot)");
+}
+
+// Prints every record queued on the O_NONBLOCK fd
+static void print_queued(int fd) {
+	struct ir_event events[8];
+	ssize_t got;
+	while((got = read(fd, events, sizeof(events))) > 0) {
+		for(ssize_t i = 0; i < got / (ssize_t)sizeof(events[0]); i++) {
+			print_event(&events[i]);
+		}
+	}
+}
+
+// OFF and ON only pause and resume reporting; the driver queues a record for either
+static void set_reporting(int fd, const char *cmd) {
+	if(write(fd, cmd, strlen(cmd)) < 0) {
+		perror(cmd);
+		return;
+	}
+	printf("Reporting %s, the driver queued:\n", strcmp(cmd, "ON") == 0 ? "resumed" : "paused");
+	print_queued(fd);
+}
+
 int main() {
-	char *filename = "/dev/ir_device";
-	int fd = open(filename, O_RDWR,0);
-	
-	char buf[6];
-	pread(fd,buf,sizeof(buf),0);
-	printf("%s\n",buf);
-	write(fd,"OFF", 3);
-	printf("Did the LED turned off?\n");
-	sleep(5);
-	write(fd,"ON",2);
-	printf("Did the LED turned on?\n");
+	char *filename = IR_DEVNAME;
+	int fd = open(filename, O_RDWR | O_NONBLOCK, 0);
+	if(fd < 0) {
+		perror(filename);
+		return 1;
+	}
+
+	print_queued(fd);
+	set_reporting(fd, "OFF");
 	sleep(5);
+	set_reporting(fd, "ON");
+
+	printf("Move a hand in front of the sensors (stops after 10 s without an edge)...\n");
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	while(poll(&pfd, 1, 10000) > 0) {
+		print_queued(fd);
+	}
+	close(fd);
 	return 0;
 }
-